@@ -0,0 +1,233 @@
+// @file:     null_engine.cc
+// @author:   Samuel
+// @created:  2020.06.17
+// @license:  GNU LGPL v3
+//
+// @desc:     Synthetic simulation engine which reads a SiQAD problem file and
+//            writes a result of configurable size after a configurable delay,
+//            for load testing the SiQAD job pipeline without a real simulator.
+
+#include <QCoreApplication>
+#include <QtCore>
+
+#include <iostream>
+#include <random>
+
+namespace {
+
+  // simulation parameters read from the problem file, defaults match the
+  // plugin description file
+  struct Params
+  {
+    int delay_ms=0;
+    int result_configs=100;
+    int potential_grid=0;
+    double failure_rate=0;
+    int stdout_lines=0;
+    int stdout_line_length=80;
+    uint seed=0;
+  };
+
+  qint64 nowMs() {return QDateTime::currentMSecsSinceEpoch();}
+
+  //! Read the simulation parameters and DB locations from the problem file.
+  bool readProblem(const QString &path, QMap<QString, QString> &sim_params,
+      QVector<QPointF> &physlocs)
+  {
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+      std::cerr << "Unable to open problem file " << qPrintable(path) << std::endl;
+      return false;
+    }
+
+    QXmlStreamReader rs(&file);
+    bool in_dbdot = false;
+    while (!rs.atEnd()) {
+      rs.readNext();
+      if (rs.isStartElement()) {
+        if (rs.name() == "sim_params") {
+          while (rs.readNextStartElement())
+            sim_params.insert(rs.name().toString(), rs.readElementText());
+        } else if (rs.name() == "dbdot") {
+          in_dbdot = true;
+        } else if (rs.name() == "physloc" && in_dbdot) {
+          physlocs.append(QPointF(rs.attributes().value("x").toDouble(),
+                                  rs.attributes().value("y").toDouble()));
+        }
+      } else if (rs.isEndElement() && rs.name() == "dbdot") {
+        in_dbdot = false;
+      }
+    }
+    if (rs.hasError()) {
+      std::cerr << "XML error in problem file: " << qPrintable(rs.errorString()) << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  //! Write the result file.
+  bool writeResult(const QString &path, const Params &p,
+      const QMap<QString, QString> &sim_params, const QVector<QPointF> &physlocs,
+      qint64 start_ms, std::mt19937 &gen)
+  {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+      std::cerr << "Unable to write result file " << qPrintable(path) << std::endl;
+      return false;
+    }
+    QXmlStreamWriter ws(&file);
+    ws.setAutoFormatting(true);
+    ws.writeStartDocument();
+    ws.writeStartElement("sim_out");
+
+    ws.writeStartElement("eng_info");
+    ws.writeTextElement("engine", "NullEngine");
+    ws.writeTextElement("version", "0.1.0");
+    ws.writeTextElement("return_code", "0");
+    ws.writeTextElement("timestamp", QDateTime::currentDateTime().toString(Qt::ISODate));
+    ws.writeTextElement("time_elapsed_s", QString::number((nowMs() - start_ms) / 1000.));
+    ws.writeEndElement();
+
+    ws.writeStartElement("sim_params");
+    for (auto it = sim_params.cbegin(); it != sim_params.cend(); ++it)
+      ws.writeTextElement(it.key(), it.value());
+    ws.writeEndElement();
+
+    QRectF bounds;
+    ws.writeStartElement("physloc");
+    for (const QPointF &loc : physlocs) {
+      ws.writeEmptyElement("dbdot");
+      ws.writeAttribute("x", QString::number(loc.x()));
+      ws.writeAttribute("y", QString::number(loc.y()));
+      bounds |= QRectF(loc, QSizeF(1e-3, 1e-3));
+    }
+    ws.writeEndElement();
+
+    if (p.result_configs > 0 && !physlocs.isEmpty()) {
+      const char charge_chars[] = {'-', '0', '+'};
+      std::discrete_distribution<int> charge({4, 5, 1});
+      std::uniform_real_distribution<double> energy(-1, 0);
+      QByteArray dist(physlocs.size(), '0');
+      ws.writeStartElement("elec_dist");
+      for (int i=0; i<p.result_configs; i++) {
+        for (int j=0; j<dist.size(); j++)
+          dist[j] = charge_chars[charge(gen)];
+        ws.writeStartElement("dist");
+        ws.writeAttribute("energy", QString::number(energy(gen)));
+        ws.writeAttribute("count", "1");
+        ws.writeAttribute("physically_valid", i == 0 ? "1" : "0");
+        ws.writeAttribute("state_count", "3");
+        ws.writeCharacters(QString::fromLatin1(dist));
+        ws.writeEndElement();
+      }
+      ws.writeEndElement();
+    }
+
+    if (p.potential_grid > 0 && !physlocs.isEmpty()) {
+      qreal step_x = bounds.width() / qMax(1, p.potential_grid-1);
+      qreal step_y = bounds.height() / qMax(1, p.potential_grid-1);
+      ws.writeStartElement("potential_map");
+      for (int i=0; i<p.potential_grid; i++) {
+        for (int j=0; j<p.potential_grid; j++) {
+          qreal x = bounds.left() + i * step_x;
+          qreal y = bounds.top() + j * step_y;
+          ws.writeEmptyElement("potential_val");
+          ws.writeAttribute("x", QString::number(x * 1e-10));
+          ws.writeAttribute("y", QString::number(y * 1e-10));
+          ws.writeAttribute("val", QString::number(0.1 * qSin(x / 50) * qCos(y / 50)));
+        }
+      }
+      ws.writeEndElement();
+    }
+
+    ws.writeEndElement();
+    ws.writeEndDocument();
+    file.close();
+    return file.error() == QFileDevice::NoError;
+  }
+}
+
+namespace {
+
+  //! Run a single simulation and return the exit code.
+  int runJob(const QString &problem_path, const QString &result_path)
+  {
+    qint64 start_ms = nowMs();
+
+    // the start and end timestamps allow SiQAD's own overhead to be isolated
+    // from the engine run time
+    std::cout << "null_engine: start " << start_ms << std::endl;
+
+    QMap<QString, QString> sim_params;
+    QVector<QPointF> physlocs;
+    if (!readProblem(problem_path, sim_params, physlocs))
+      return 1;
+    std::cout << "null_engine: read " << physlocs.size() << " DBs in "
+      << nowMs() - start_ms << " ms" << std::endl;
+
+    Params p;
+    p.delay_ms = sim_params.value("delay_ms", QString::number(p.delay_ms)).toInt();
+    p.result_configs = sim_params.value("result_configs", QString::number(p.result_configs)).toInt();
+    p.potential_grid = sim_params.value("potential_grid", QString::number(p.potential_grid)).toInt();
+    p.failure_rate = sim_params.value("failure_rate", QString::number(p.failure_rate)).toDouble();
+    p.stdout_lines = sim_params.value("stdout_lines", QString::number(p.stdout_lines)).toInt();
+    p.stdout_line_length = sim_params.value("stdout_line_length", QString::number(p.stdout_line_length)).toInt();
+    p.seed = sim_params.value("seed", QString::number(p.seed)).toUInt();
+    std::mt19937 gen(p.seed != 0 ? p.seed : static_cast<uint>(start_ms));
+
+    // spread the log output over the delay to mimic an engine reporting its
+    // progress
+    QByteArray line(qMax(0, p.stdout_line_length), 'x');
+    int chunks = qMax(1, qMin(p.stdout_lines, 100));
+    for (int c=0; c<chunks; c++) {
+      int line_end = static_cast<int>(qint64(p.stdout_lines) * (c+1) / chunks);
+      for (int i=static_cast<int>(qint64(p.stdout_lines) * c / chunks); i<line_end; i++)
+        std::cout << i << ' ' << line.constData() << '\n';
+      std::cout.flush();
+      QThread::msleep(p.delay_ms / chunks);
+    }
+
+    std::bernoulli_distribution fail(qBound(0., p.failure_rate, 1.));
+    if (fail(gen)) {
+      std::cerr << "null_engine: simulated failure" << std::endl;
+      return 2;
+    }
+
+    if (!writeResult(result_path, p, sim_params, physlocs, start_ms, gen))
+      return 1;
+    std::cout << "null_engine: wrote " << QFileInfo(result_path).size()
+      << " bytes, end " << nowMs() << " (" << nowMs() - start_ms << " ms)" << std::endl;
+    return 0;
+  }
+
+  //! Serve jobs requested by SiQAD over stdin until it is closed, following
+  //! the persistent worker protocol.
+  int runWorker()
+  {
+    std::string request;
+    while (std::getline(std::cin, request)) {
+      QJsonObject job = QJsonDocument::fromJson(QByteArray::fromStdString(request)).object();
+      int exit_code = runJob(job.value("problem_path").toString(),
+                             job.value("result_path").toString());
+      std::cerr.flush();
+      std::cout << "@SQWORKER@ {\"status\": \"done\", \"exit_code\": "
+        << exit_code << "}" << std::endl;
+    }
+    return 0;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  QCoreApplication app(argc, argv);
+
+  QStringList args = app.arguments();
+  if (args.size() == 2 && args.at(1) == "--worker")
+    return runWorker();
+  if (args.size() != 3) {
+    std::cerr << "Usage: null_engine <problem_path> <result_path>" << std::endl;
+    std::cerr << "       null_engine --worker" << std::endl;
+    return 1;
+  }
+  return runJob(args.at(1), args.at(2));
+}
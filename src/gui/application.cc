@@ -13,14 +13,27 @@
 
 // Qt includes
 #include <QtSvg>
+#include <QtConcurrent>
 #include <iostream>
 #include <QMessageBox>
 
 // gui includes
 #include "application.h"
 #include "settings/settings.h"
+#include "widgets/components/profiler.h"
 
 
+namespace {
+  // return the generation of an autosave checkpoint or journal file name, -1
+  // if the name doesn't belong to either
+  int autosaveGeneration(const QString &file_name)
+  {
+    static const QRegularExpression re("^(?:checkpoint|journal)-(\\d+)\\.");
+    QRegularExpressionMatch match = re.match(file_name);
+    return match.hasMatch() ? match.captured(1).toInt() : -1;
+  }
+}
+
 // init the DialogPanel to NULL until build in constructor
 gui::DialogPanel *gui::ApplicationGUI::dialog_pan = 0;
 
@@ -48,19 +61,49 @@ gui::ApplicationGUI::ApplicationGUI(const QString &f_path, QWidget *parent)
     msg->setText("Wait to load file...");
     msg->setModal(false);
     msg->open();
+    cli_load_pending = true;
     cli_load_timer.start(1000);
     connect(&cli_load_timer, &QTimer::timeout,
         [this,f_path,msg](){
           openFromFile(f_path);
           cli_load_timer.stop();
           msg->close();
+          // startup includes populating the design panel with the file
+          auto loadFinished = [this]()
+          {
+            cli_load_pending = false;
+            checkStartupFinished();
+          };
+          if (load_watcher != nullptr)
+            connect(load_watcher, &QFutureWatcher<QPair<bool, comp::DesignModel>>::finished,
+                    this, loadFinished);
+          else
+            loadFinished();
     });
+  } else {
+    // offer to recover designs of crashed sessions once the GUI is shown
+    QTimer::singleShot(0, this, &gui::ApplicationGUI::recoverAutosaves);
   }
 }
 
 // destructor
 gui::ApplicationGUI::~ApplicationGUI()
 {
+  // stop journaling and let the pending checkpoint finish
+  design_pan->setJournal(nullptr);
+  autosave_journal.close();
+  autosave_watcher.waitForFinished();
+
+  // remove autosave during peaceful termination
+  delete autosave_lock;   // releases the lock
+  for(const QString &dirFile : autosave_dir.entryList())
+    autosave_dir.remove(dirFile); // remove autosave files
+
+  if(autosave_dir.removeRecursively())
+    qDebug() << tr("Removed autosave directory: %1").arg(autosave_dir.path());
+  else
+    qDebug() << tr("Failed to remove autosave directory: %1").arg(autosave_dir.path());
+
   QStringList settings_remove_paths;
   if (reset_settings) {
     // store list of config files to be removed at the end
@@ -127,10 +170,10 @@ void gui::ApplicationGUI::dropEvent(QDropEvent *e)
   QList<QUrl> url_list = mime_data->urls();
   if (url_list.length() == 1) {
     QString f_path = url_list.at(0).toLocalFile();
-    if (f_path.right(4) == ".sqd")
+    if (f_path.right(4) == ".sqd" || comp::DesignModel::isBinaryPath(f_path))
       openFromFile(f_path);
     else
-      qWarning() << tr("Only accept dropping of *.sqd files. Your attempted path was %1.").arg(f_path);
+      qWarning() << tr("Only accept dropping of *.sqd and *.sqdb files. Your attempted path was %1.").arg(f_path);
   } else {
     qWarning() << tr("Drop event only supports opening exactly 1 file, %1 \
         received instead.").arg(url_list.length());
@@ -142,6 +185,8 @@ void gui::ApplicationGUI::dropEvent(QDropEvent *e)
 
 void gui::ApplicationGUI::initGUI()
 {
+  SQ_PROFILE_SCOPE("ApplicationGUI::initGUI");
+
   // Qt GUI flags
   setAcceptDrops(true);
 
@@ -161,11 +206,17 @@ void gui::ApplicationGUI::initGUI()
   // initialise mainwindow panels
   dialog_pan = new gui::DialogPanel(this); // init first to capture std output
   input_field = new gui::InputField(this);
-  design_pan = new gui::DesignPanel(this);
+  {
+    SQ_PROFILE_SCOPE("ApplicationGUI::initDesignPanel");
+    design_pan = new gui::DesignPanel(this);
+  }
   info_pan = new gui::InfoPanel(this);
 
   // detachable/pop-up widgets, order matters in some cases due to pointers
-  plugin_manager = new gui::PluginManager(this);
+  {
+    SQ_PROFILE_SCOPE("ApplicationGUI::initPluginManager");
+    plugin_manager = new gui::PluginManager(this);
+  }
   sim_manager = new gui::SimManager(this);
   sim_visualize = new gui::SimVisualizer(design_pan, this);
   job_manager = new gui::JobManager(plugin_manager, sim_visualize, this);
@@ -203,12 +254,28 @@ void gui::ApplicationGUI::initGUI()
           });
   connect(job_manager, &gui::JobManager::sig_showJob,
           sim_visualize, &gui::SimVisualizer::showJob);
+  connect(plugin_manager, &gui::PluginManager::sig_initialized,
+          this, &gui::ApplicationGUI::checkStartupFinished);
 
   // widget-app gui signals
   connect(job_manager, &gui::JobManager::sig_exportJobProblem,
           [this](comp::JobStep *js, gui::DesignInclusionArea inclusion_area)
           {
-            saveToFile(SaveSimulationProblem, js->problemPath(), inclusion_area, js);
+            // the problem hash is computed from the packed problem rather
+            // than by reading the exported file again
+            QList<QPair<QString,QString>> sim_params;
+            for (const QString &key : js->jobParameters().keys())
+              sim_params.append(qMakePair(key, js->jobParameters().value(key)));
+            QByteArray packed_problem = design_pan->designModel(inclusion_area)
+              .packedSimProblem(sim_params);
+            if (!js->usesSharedMemoryProblem()) {
+              if (saveToFile(SaveSimulationProblem, js->problemPath(), inclusion_area, js))
+                js->setExportedProblem(packed_problem);
+              return;
+            }
+            // the plugin reads the packed problem from shared memory
+            if (!js->setSharedMemoryProblem(packed_problem))
+              qWarning() << tr("Failed to place the simulation problem in shared memory.");
           });
   connect(settings_dialog, &settings::SettingsDialog::sig_resetSettings,
           [this](){reset_settings = true;});
@@ -219,7 +286,14 @@ void gui::ApplicationGUI::initGUI()
             sim_visualize->clearJob();
           });
   connect(design_pan, &gui::DesignPanel::sig_postDPReset,
-          [this](){initState();});
+          [this]()
+          {
+            initState();
+            // the journal doesn't apply to the reset design, start a new
+            // autosave generation once the design has been populated
+            autosave_journal.close();
+            QTimer::singleShot(0, this, &gui::ApplicationGUI::startAutosaveGeneration);
+          });
   connect(design_pan, &gui::DesignPanel::sig_setLayerManagerWidget,
           this, &gui::ApplicationGUI::setLayerManagerWidget);
   connect(design_pan, &gui::DesignPanel::sig_setItemManagerWidget,
@@ -397,12 +471,19 @@ void gui::ApplicationGUI::initMenuBar()
   QAction *open_log_dir = new QAction(tr("Open Log Directory"), this);
   QAction *open_autosave_dir = new QAction(tr("Open Autosave Directory"), this);
   QAction *open_config_dir = new QAction(tr("Open Config Directory"), this);
+  QAction *performance_overlay = new QAction(tr("Performance Overlay"), this);
+  QAction *export_performance_stats = new QAction(tr("Export Performance Statistics..."), this);
   QAction *about_version = new QAction(tr("About"), this);
 
+  performance_overlay->setCheckable(true);
+
   help->addAction(open_log_dir);
   help->addAction(open_autosave_dir);
   help->addAction(open_config_dir);
   help->addSeparator();
+  help->addAction(performance_overlay);
+  help->addAction(export_performance_stats);
+  help->addSeparator();
   help->addAction(about_version);
 
   // connect(new_file, &QAction::triggered, this, &gui::ApplicationGUI::newFile);
@@ -457,6 +538,22 @@ void gui::ApplicationGUI::initMenuBar()
       [this]() {
         QDesktopServices::openUrl(QUrl::fromLocalFile(settings::AppSettings::instance()->pathReplacement("<CONFIG>")));
       });
+  connect(performance_overlay, &QAction::toggled,
+          design_pan, &gui::DesignPanel::setHotPathTracing);
+  connect(export_performance_stats, &QAction::triggered,
+      [this]() {
+        if (!design_pan->hotPathTracing()) {
+          QMessageBox::information(this, tr("Export Performance Statistics"),
+              tr("Enable the performance overlay and interact with the design "
+                "to record statistics first."));
+          return;
+        }
+        QString path = QFileDialog::getSaveFileName(this,
+            tr("Export Performance Statistics"), save_dir.absolutePath(),
+            tr("JSON (*.json);;All files (*.*)"));
+        if (!path.isEmpty())
+          design_pan->exportHotPathStats(path);
+      });
   connect(action_screenshot_mode, &QAction::triggered,
           this, &gui::ApplicationGUI::toggleScreenshotMode);
   connect(action_settings_dialog, &QAction::triggered,
@@ -804,6 +901,7 @@ void gui::ApplicationGUI::initState()
 
 void gui::ApplicationGUI::loadSettings()
 {
+  SQ_PROFILE_SCOPE("ApplicationGUI::loadSettings");
   qDebug() << tr("Loading settings");
   settings::GUISettings *gui_settings = settings::GUISettings::instance();
 
@@ -812,6 +910,7 @@ void gui::ApplicationGUI::loadSettings()
   // autosave related settings
   settings::AppSettings *app_settings = settings::AppSettings::instance();
   autosave_num = app_settings->get<int>("save/autosavenum");
+  checkpoint_records = app_settings->get<int>("save/checkpointrecords");
   autosave_root.setPath(app_settings->getPath("save/autosaveroot"));
 
   // autosave directory for current instance
@@ -829,8 +928,21 @@ void gui::ApplicationGUI::loadSettings()
       qCritical() << tr("Failed to create autosave directory");
   }
 
+  // lock the autosave directory to tell other instances that it's in use,
+  // directories of crashed instances are left with stale locks
+  autosave_lock = new QLockFile(autosave_dir.filePath("instance.lock"));
+  if (!autosave_lock->tryLock(0))
+    qWarning() << tr("Failed to lock autosave directory");
+
   // auto save signal
   connect(&autosave_timer, &QTimer::timeout, this, &gui::ApplicationGUI::autoSave);
+  connect(&autosave_watcher, &QFutureWatcher<bool>::finished,
+          [this]()
+          {
+            if (autosave_pending)
+              startAutosaveGeneration();
+          });
+  startAutosaveGeneration();
 
   // reset state
   initState();
@@ -843,15 +955,6 @@ void gui::ApplicationGUI::saveSettings()
   settings::GUISettings *gui_settings = settings::GUISettings::instance();
 
   gui_settings->setValue("SBAR/loc", (int) toolBarArea(side_bar));
-
-  // remove autosave during peaceful termination
-  for(const QString &dirFile : autosave_dir.entryList())
-    autosave_dir.remove(dirFile); // remove autosave files
-
-  if(autosave_dir.removeRecursively())
-    qDebug() << tr("Removed autosave directory: %1").arg(autosave_dir.path());
-  else
-    qDebug() << tr("Failed to remove autosave directory: %1").arg(autosave_dir.path());
 }
 
 
@@ -1277,7 +1380,8 @@ bool gui::ApplicationGUI::saveToFile(gui::ApplicationGUI::SaveFlag flag,
   } else if (working_path.isEmpty() || flag==SaveAs) {
     save_dialog.setDefaultSuffix("sqd");
     write_path = save_dialog.getSaveFileName(this, tr("Save File"),
-                  save_dir.filePath("new-db-layout.sqd"), tr("SQD (*.sqd);;All files (*)"));
+                  save_dir.filePath("new-db-layout.sqd"),
+                  tr("SQD (*.sqd);;Binary SQD (*.sqdb);;All files (*)"));
     if (write_path.isEmpty())
       return false;
   } else {
@@ -1285,9 +1389,45 @@ bool gui::ApplicationGUI::saveToFile(gui::ApplicationGUI::SaveFlag flag,
   }
 
   // add .sqd extension if there isn't
-  if (!QStringList({"sqd", "qad", "xml"}).contains(QFileInfo(write_path).suffix()))
+  if (!QStringList({"sqd", "qad", "xml", comp::DesignModel::binary_suffix})
+      .contains(QFileInfo(write_path).suffix()))
     write_path.append(".sqd");
 
+  QString file_purpose;
+  switch(flag){
+    case SaveSimulationProblem:
+      file_purpose = "simulation";
+      break;
+    case AutoSave:
+      // Introduced in SiQAD v0.2.2
+      file_purpose = "autosave";
+      break;
+    default:
+      file_purpose = "save";
+      break;
+  }
+
+  // binary SQD files are written from the design model
+  if (comp::DesignModel::isBinaryPath(write_path)) {
+    QList<QPair<QString,QString>> sim_params;
+    if (flag == SaveSimulationProblem && job_step != nullptr) {
+      for (const QString &key : job_step->jobParameters().keys())
+        sim_params.append(qMakePair(key, job_step->jobParameters().value(key)));
+    }
+    if (!design_pan->designModel(inclusion_area).saveToBinaryFile(write_path,
+          file_purpose, sim_params)) {
+      qDebug() << tr("Save: Error when writing binary file %1").arg(write_path);
+      return false;
+    }
+    qDebug() << tr("Save: Write completed for %1").arg(write_path);
+    if(flag == Save || flag == SaveAs){
+      save_dir.setPath(write_path);
+      working_path = write_path;
+      updateWindowTitle();
+    }
+    return true;
+  }
+
   // set file name to write_path.writing while writing to prevent loss of
   // previous save if this save fails
   QFile file(write_path+".writing");
@@ -1309,20 +1449,6 @@ bool gui::ApplicationGUI::saveToFile(gui::ApplicationGUI::SaveFlag flag,
   // save program flags
   ws.writeComment("Program Flags");
   ws.writeStartElement("program");
-
-  QString file_purpose;
-  switch(flag){
-    case SaveSimulationProblem:
-      file_purpose = "simulation";
-      break;
-    case AutoSave:
-      // Introduced in SiQAD v0.2.2
-      file_purpose = "autosave";
-      break;
-    default:
-      file_purpose = "save";
-      break;
-  }
   ws.writeTextElement("file_purpose", file_purpose);
   ws.writeTextElement("version", QCoreApplication::applicationVersion());
   ws.writeTextElement("date", QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
@@ -1339,7 +1465,13 @@ bool gui::ApplicationGUI::saveToFile(gui::ApplicationGUI::SaveFlag flag,
   }
 
   // save design panel content (including GUI flags, layers and their corresponding contents (electrode, dbs, etc.)
-  design_pan->writeToXmlStream(&ws, inclusion_area);
+  if (flag == SaveSimulationProblem) {
+    // simulation problems don't need GUI flags, write them from the design
+    // model which doesn't involve the scene
+    design_pan->designModel(inclusion_area).writeToXmlStream(&ws);
+  } else {
+    design_pan->writeToXmlStream(&ws, inclusion_area);
+  }
 
   // close root element & close file
   ws.writeEndElement();
@@ -1364,24 +1496,195 @@ bool gui::ApplicationGUI::saveToFile(gui::ApplicationGUI::SaveFlag flag,
 
 void gui::ApplicationGUI::autoSave()
 {
-  // no check for changes in state... unneccesary complexity
+  // edits are journaled as they are made, new checkpoints are only needed to
+  // keep the journal short
+  if (autosave_journal.isOpen() && autosave_journal.recordCount() < checkpoint_records) {
+    qDebug() << tr("Autosave: %1 journal records since the last checkpoint, skipping")
+      .arg(autosave_journal.recordCount());
+    return;
+  }
+
+  if (autosave_watcher.isRunning()) {
+    qDebug() << tr("Autosave: previous checkpoint still in progress, skipping");
+    return;
+  }
 
   qDebug() << tr("Autosave: %1").arg(autosave_dir.absolutePath());
+  startAutosaveGeneration();
+}
+
+
+void gui::ApplicationGUI::startAutosaveGeneration()
+{
+  SQ_PROFILE_SCOPE("ApplicationGUI::startAutosaveGeneration");
+
   if(!autosave_dir.exists()){
     qCritical() << tr("Autosave: unable to create tmp instance directory at %1").arg(autosave_dir.path());
     return;
   }
 
-  autosave_ind = (autosave_ind+1) % autosave_num;
-  QString autosave_path = autosave_dir.filePath(tr("autosave-%1.xml").arg(autosave_ind));
-  saveToFile(AutoSave, autosave_path);
+  // only one checkpoint is written at a time, edits keep being journaled
+  // until the requested one can start
+  if (autosave_watcher.isRunning()) {
+    autosave_pending = true;
+    return;
+  }
+  autosave_pending = false;
+  autosave_gen++;
+
+  // snapshot the design on the GUI thread, the model keeps overlay layers and
+  // the item order of each layer as the journal addresses items by their
+  // layer manager and item indices. It also carries the view scale so that
+  // writing it doesn't read the settings from the worker.
+  comp::DesignModel checkpoint = design_pan->designModel(gui::IncludeEntireDesign, true);
+
+  // journal the edits that follow the checkpoint
+  QString journal_path = autosave_dir.filePath(QString("journal-%1.%2")
+      .arg(autosave_gen).arg(comp::DesignJournal::journal_suffix));
+  if (autosave_journal.open(journal_path))
+    design_pan->setJournal(&autosave_journal);
+  else
+    design_pan->setJournal(nullptr);
+
+  // serialize and write the checkpoint on a worker thread, then remove the
+  // generations that are no longer needed for recovery
+  QString dir_path = autosave_dir.absolutePath();
+  QString checkpoint_path = autosave_dir.filePath(QString("checkpoint-%1.xml").arg(autosave_gen));
+  int oldest_kept_gen = autosave_gen - qMax(autosave_num, 1) + 1;
+  autosave_watcher.setFuture(QtConcurrent::run([checkpoint, checkpoint_path, dir_path, oldest_kept_gen]()
+      {
+        if (!checkpoint.saveToFile(checkpoint_path, "autosave")) {
+          qWarning() << QObject::tr("Autosave: failed to write checkpoint %1")
+            .arg(checkpoint_path);
+          return false;
+        }
+
+        QDir dir(dir_path);
+        for (const QString &name : dir.entryList(QStringList() << "checkpoint-*"
+              << "journal-*", QDir::Files)) {
+          if (autosaveGeneration(name) < oldest_kept_gen)
+            dir.remove(name);
+        }
+        qDebug() << QObject::tr("Autosave checkpoint complete: %1").arg(checkpoint_path);
+        return true;
+      }));
+}
+
+
+void gui::ApplicationGUI::recoverAutosaves()
+{
+  QStringList instance_names = autosave_root.entryList(QStringList() << "instance-*",
+      QDir::Dirs | QDir::NoDotAndDotDot);
+  for (const QString &instance_name : instance_names) {
+    QDir instance_dir(autosave_root.filePath(instance_name));
+    if (instance_dir.absolutePath() == autosave_dir.absolutePath())
+      continue;
+
+    // directories of running instances are locked
+    QLockFile instance_lock(instance_dir.filePath("instance.lock"));
+    if (!instance_lock.tryLock(0))
+      continue;
+
+    int generation = -1;
+    for (const QString &name : instance_dir.entryList(QStringList() << "checkpoint-*.xml",
+          QDir::Files))
+      generation = qMax(generation, autosaveGeneration(name));
+    if (generation < 0)
+      continue;
+
+    QMessageBox msg(this);
+    msg.setIcon(QMessageBox::Warning);
+    msg.setText(tr("A previous session did not exit properly."));
+    msg.setInformativeText(tr("Recover the unsaved design from the autosave at %1?")
+        .arg(instance_dir.absolutePath()));
+    QPushButton *recover_button = msg.addButton(tr("Recover"), QMessageBox::AcceptRole);
+    QPushButton *discard_button = msg.addButton(QMessageBox::Discard);
+    msg.addButton(QMessageBox::Ignore);
+    msg.exec();
+
+    if (msg.clickedButton() == recover_button) {
+      if (design_pan->stateChanged() && !resolveUnsavedChanges())
+        return;
+      if (recoverFromAutosave(instance_dir, generation)) {
+        instance_lock.unlock();
+        instance_dir.removeRecursively();
+      }
+      // only one design can be recovered at a time
+      return;
+    } else if (msg.clickedButton() == discard_button) {
+      instance_lock.unlock();
+      instance_dir.removeRecursively();
+    }
+  }
+}
+
 
-  qDebug() << tr("Autosave complete");
+void gui::ApplicationGUI::checkStartupFinished()
+{
+  if (startup_finished || cli_load_pending || !plugin_manager->initialized())
+    return;
+  startup_finished = true;
+  emit sig_startupFinished();
+}
+
+
+bool gui::ApplicationGUI::recoverFromAutosave(const QDir &dir, int generation)
+{
+  QString checkpoint_path = dir.filePath(QString("checkpoint-%1.xml").arg(generation));
+  QFile file(checkpoint_path);
+  if(!file.open(QFile::ReadOnly | QFile::Text)){
+    qCritical() << tr("Recovery: error when opening %1: %2")
+      .arg(checkpoint_path).arg(file.errorString());
+    return false;
+  }
+
+  qDebug() << tr("Recovery: loading checkpoint %1").arg(checkpoint_path);
+  working_path.clear();
+  QXmlStreamReader rs(&file);
+  rs.readNextStartElement();
+  design_pan->loadFromFile(&rs);
+  file.close();
+
+  // replay the journals of the checkpoint generation and any later ones whose
+  // checkpoints were not completed
+  QMap<int, QString> journal_paths;
+  for (const QString &name : dir.entryList(QStringList() << QString("journal-*.%1")
+        .arg(comp::DesignJournal::journal_suffix), QDir::Files)) {
+    int journal_gen = autosaveGeneration(name);
+    if (journal_gen >= generation)
+      journal_paths.insert(journal_gen, dir.filePath(name));
+  }
+
+  bool complete = true;
+  for (const QString &journal_path : journal_paths) {
+    QVector<QVector<comp::DesignJournal::Op>> records;
+    if (!comp::DesignJournal::readRecords(journal_path, records)) {
+      complete = false;
+      break;
+    }
+    qDebug() << tr("Recovery: replaying %1 journal records from %2")
+      .arg(records.size()).arg(journal_path);
+    if (!design_pan->replayJournal(records))
+      complete = false;
+  }
+  if (!complete)
+    qWarning() << tr("Recovery: some edits could not be recovered");
+
+  // the recovered design hasn't been saved anywhere
+  design_pan->markModified();
+  updateWindowTitle();
+  qDebug() << tr("Recovery complete");
+  return true;
 }
 
 
 void gui::ApplicationGUI::openFromFile(const QString &f_path)
 {
+  if (load_watcher != nullptr) {
+    qWarning() << tr("Another file is still being loaded, please wait.");
+    return;
+  }
+
   // prompt user to resolve unsaved changes if program has been modified
   if(design_pan->stateChanged())
     if(!resolveUnsavedChanges())
@@ -1394,7 +1697,7 @@ void gui::ApplicationGUI::openFromFile(const QString &f_path)
     QFileDialog load_dialog;
     load_dialog.setDefaultSuffix("sqd");
     open_path = load_dialog.getOpenFileName(this, tr("Open File"),
-        save_dir.absolutePath(), tr("SQD (*.sqd);;All files (*.*)"));
+        save_dir.absolutePath(), tr("SQD (*.sqd *.sqdb);;All files (*.*)"));
     if(open_path.isEmpty()) {
       qDebug() << "No file chosen, cancelling file open operation.";
       return;
@@ -1408,24 +1711,52 @@ void gui::ApplicationGUI::openFromFile(const QString &f_path)
     return;
   }
 
-  working_path = open_path;
-  save_dir.setPath(QFileInfo(open_path).absolutePath());
-  updateWindowTitle();
-
-  // read from XML stream
-  QXmlStreamReader rs(&file);
-  qDebug() << tr("Beginning load from %1").arg(file.fileName());
+  file.close();
 
-  // TODO load program status here instead of from file
   // TODO if save type is simulation, warn the user when opening the file, especially the fact that sim params will not be retained the next time they save
 
-  // enter the root node and hand the loading over to design panel
-  rs.readNextStartElement();
-  design_pan->loadFromFile(&rs);
+  // the file is loaded in two phases: first parse the file into a design
+  // model on a worker thread, then populate the design panel in one batch
+  // unless parsing failed, in which case the current design is kept
+  qDebug() << tr("Beginning load from %1").arg(open_path);
+  QString fallback_lattice_path = settings::LatticeSettings::instance()->get<QString>(
+      "lattice/default_lattice_file_path");
+  load_watcher = new QFutureWatcher<QPair<bool, comp::DesignModel>>(this);
+  connect(load_watcher, &QFutureWatcher<QPair<bool, comp::DesignModel>>::finished,
+          [this, open_path]()
+          {
+            SQ_PROFILE_SCOPE("ApplicationGUI::openFromFile::populate");
+            QPair<bool, comp::DesignModel> loaded = load_watcher->result();
+            load_watcher->deleteLater();
+            load_watcher = nullptr;
+            design_pan->setEnabled(true);
+            QApplication::restoreOverrideCursor();
+            if (!loaded.first) {
+              QMessageBox::critical(this, tr("Open File"),
+                  tr("Errors encountered when loading %1, the file was not opened.")
+                  .arg(open_path));
+              return;
+            }
+            design_pan->loadFromModel(loaded.second);
+            working_path = open_path;
+            save_dir.setPath(QFileInfo(open_path).absolutePath());
+            updateWindowTitle();
+            qDebug() << tr("Load complete");
+          });
 
-  // clean up
-  file.close();
-  qDebug() << tr("Load complete");
+  design_pan->setEnabled(false);
+  QApplication::setOverrideCursor(Qt::WaitCursor);
+  load_watcher->setFuture(QtConcurrent::run([open_path, fallback_lattice_path]()
+        {
+          SQ_PROFILE_SCOPE("ApplicationGUI::openFromFile::parse");
+          comp::DesignModel model;
+          model.setFallbackLatticePath(fallback_lattice_path);
+          bool success = comp::DesignModel::isBinaryPath(open_path)
+              ? model.loadFromBinaryFile(open_path) : model.loadFromFile(open_path);
+          if (!success)
+            qCritical() << QObject::tr("Errors encountered when loading %1").arg(open_path);
+          return qMakePair(success, model);
+        }));
 }
 
 void gui::ApplicationGUI::aboutVersion()
@@ -57,6 +57,16 @@ namespace gui{
     // static declaration of DialogPanel for dialogstream
     static gui::DialogPanel *dialog_pan;
 
+    //! Return whether startup has finished, see sig_startupFinished().
+    bool startupFinished() const {return startup_finished;}
+
+  signals:
+
+    //! Emitted once the plugin engines have been loaded, the Python path has
+    //! been resolved and the file given on the command line, if any, has been
+    //! loaded or failed to load.
+    void sig_startupFinished();
+
   public slots:
 
     // update the window title
@@ -126,9 +136,21 @@ namespace gui{
                     gui::DesignInclusionArea inclusion_area=gui::IncludeEntireDesign,
                     comp::JobStep *job_step=nullptr);
 
-    //! Perform autosave.
+    //! Perform autosave. Edits are journaled as they are made, this writes a
+    //! new checkpoint once enough edits have been journaled.
     void autoSave();
 
+    //! Snapshot the current design and start a new journal for the edits that
+    //! follow, the snapshot is written as a checkpoint in the background.
+    //! Older checkpoint generations are removed once the new checkpoint has
+    //! been written. If a checkpoint is still being written, the new one is
+    //! started after it finishes.
+    void startAutosaveGeneration();
+
+    //! Offer to recover designs from autosave directories left behind by
+    //! sessions which did not exit properly.
+    void recoverAutosaves();
+
     //! Open a previous save. A file chooser dialog would be presented if no
     //! file path is given.
     void openFromFile(const QString &f_path=QString());
@@ -174,6 +196,13 @@ namespace gui{
     void loadSettings();  // load mainwindow settings from the settings instance
     void saveSettings();  // save mainwindow settings to the settings instance
 
+    // recover the design from the checkpoint of the given generation in the
+    // autosave directory and replay the journals that follow it
+    bool recoverFromAutosave(const QDir &dir, int generation);
+
+    // emit sig_startupFinished if nothing started at startup is pending
+    void checkStartupFinished();
+
     // VARIABLES
 
     // flag to indicate closing/quitting
@@ -184,6 +213,8 @@ namespace gui{
     // save start time for instance recognition
     QDateTime start_time;
     QTimer cli_load_timer;  // timer for loading file from command line, delayed to wait for GUI init
+    bool cli_load_pending=false;  // the command line file hasn't been loaded yet
+    bool startup_finished=false;  // sig_startupFinished has been emitted
 
     // directory path persistence
     QDir img_dir;
@@ -240,10 +271,16 @@ namespace gui{
     QDir autosave_root;        // the root of autosave directories
     QDir autosave_dir;         // directory of autosave
 
-    int autosave_ind=0;        // current autosave file index
-    int autosave_num;          // number of autosaves to keep
+    QLockFile *autosave_lock=nullptr;   // marks the autosave directory as in use
+    int autosave_gen=0;        // current checkpoint generation
+    int autosave_num;          // number of checkpoint generations to keep
+    int checkpoint_records;    // journal records between checkpoints
+    QFutureWatcher<bool> autosave_watcher;  // checkpoint being written in the background
+    bool autosave_pending=false;          // checkpoint requested while another was written
+    comp::DesignJournal autosave_journal; // journal of edits since the checkpoint
 
     QString working_path;      // path currently in use
+    QFutureWatcher<QPair<bool, comp::DesignModel>> *load_watcher=nullptr;  // file being parsed in the background
     Commander* commander;      // Handles commands
 
     bool reset_settings=false; // reset all settings at destruction
@@ -0,0 +1,137 @@
+/** @file:     design_journal.cc
+ *  @author:   Samuel
+ *  @created:  2020.06.09
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Append-only journal of design edits used for incremental
+ *             autosaves and crash recovery.
+ */
+
+#include "design_journal.h"
+
+using namespace comp;
+
+const QString DesignJournal::journal_suffix = "sqj";
+
+namespace {
+  // each record starts with the magic number, the payload size and the
+  // checksum of the payload
+  const quint32 record_magic = 0x524a5153;  // "SQJR" in little endian
+
+  QDataStream &initStream(QDataStream &ds)
+  {
+    ds.setVersion(QDataStream::Qt_5_0);
+    ds.setByteOrder(QDataStream::LittleEndian);
+    return ds;
+  }
+}
+
+bool DesignJournal::open(const QString &path)
+{
+  close();
+  file.setFileName(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    qWarning() << QObject::tr("DesignJournal: unable to open %1: %2")
+      .arg(path).arg(file.errorString());
+    return false;
+  }
+  return true;
+}
+
+void DesignJournal::close()
+{
+  if (file.isOpen())
+    file.close();
+  record_count = 0;
+}
+
+bool DesignJournal::append(const QVector<Op> &ops)
+{
+  if (!file.isOpen())
+    return false;
+
+  QByteArray payload;
+  {
+    QDataStream ds(&payload, QIODevice::WriteOnly);
+    initStream(ds);
+    ds << static_cast<quint32>(ops.size());
+    for (const Op &op : ops)
+      ds << static_cast<qint32>(op.type) << op.layer << op.index << op.item_xml;
+  }
+
+  QByteArray record;
+  {
+    QDataStream ds(&record, QIODevice::WriteOnly);
+    initStream(ds);
+    ds << record_magic << static_cast<quint32>(payload.size())
+       << qChecksum(payload.constData(), payload.size());
+  }
+  record.append(payload);
+
+  if (file.write(record) != record.size() || !file.flush()) {
+    qWarning() << QObject::tr("DesignJournal: failed to write to %1: %2")
+      .arg(file.fileName()).arg(file.errorString());
+    return false;
+  }
+  record_count++;
+  return true;
+}
+
+bool DesignJournal::readRecords(const QString &path, QVector<QVector<Op>> &records)
+{
+  QFile in_file(path);
+  if (!in_file.open(QIODevice::ReadOnly)) {
+    qWarning() << QObject::tr("DesignJournal: unable to open %1: %2")
+      .arg(path).arg(in_file.errorString());
+    return false;
+  }
+  QByteArray data = in_file.readAll();
+  in_file.close();
+
+  const int header_size = 2*sizeof(quint32) + sizeof(quint16);
+  int pos = 0;
+  while (data.size() - pos >= header_size) {
+    quint32 magic, payload_size;
+    quint16 checksum;
+    {
+      QDataStream ds(data.mid(pos, header_size));
+      initStream(ds);
+      ds >> magic >> payload_size >> checksum;
+    }
+    pos += header_size;
+    if (magic != record_magic || payload_size > static_cast<quint32>(data.size() - pos)) {
+      qWarning() << QObject::tr("DesignJournal: truncated record in %1, "
+          "discarding the rest of the journal").arg(path);
+      break;
+    }
+
+    QByteArray payload = data.mid(pos, payload_size);
+    pos += payload_size;
+    if (qChecksum(payload.constData(), payload.size()) != checksum) {
+      qWarning() << QObject::tr("DesignJournal: corrupted record in %1, "
+          "discarding the rest of the journal").arg(path);
+      break;
+    }
+
+    QDataStream ds(payload);
+    initStream(ds);
+    quint32 op_count;
+    ds >> op_count;
+    QVector<Op> ops;
+    for (quint32 i=0; i<op_count && ds.status() == QDataStream::Ok; i++) {
+      qint32 type;
+      Op op;
+      ds >> type >> op.layer >> op.index >> op.item_xml;
+      op.type = static_cast<OpType>(type);
+      ops.append(op);
+    }
+    if (ds.status() != QDataStream::Ok) {
+      qWarning() << QObject::tr("DesignJournal: malformed record in %1, "
+          "discarding the rest of the journal").arg(path);
+      break;
+    }
+    records.append(ops);
+  }
+
+  return true;
+}
@@ -0,0 +1,83 @@
+/** @file:     design_journal.h
+ *  @author:   Samuel
+ *  @created:  2020.06.09
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Append-only journal of design edits used for incremental
+ *             autosaves and crash recovery.
+ */
+
+#ifndef _COMP_DESIGN_JOURNAL_H_
+#define _COMP_DESIGN_JOURNAL_H_
+
+#include <QtCore>
+
+namespace comp{
+
+  //! DesignJournal records the item level changes made by each command on the
+  //! design undo stack. Each record holds the operations of one undo stack
+  //! index change and is flushed to disk as soon as it is appended, so a crash
+  //! loses at most the command that was being recorded. Together with a full
+  //! checkpoint of the design, replaying the records in order reproduces the
+  //! design at the time of the last record.
+  //!
+  //! Items are addressed by their layer index and their index in the layer
+  //! item stack, the same way that the undo commands address them.
+  class DesignJournal
+  {
+  public:
+
+    //! Operation types.
+    enum OpType{AddItem, RemoveItem, UpdateItem};
+
+    //! A single operation, item_xml holds the item as written by
+    //! prim::Item::saveItems for AddItem and UpdateItem.
+    struct Op
+    {
+      OpType type;
+      qint32 layer;
+      qint32 index;
+      QByteArray item_xml;
+    };
+
+    //! Constructor.
+    DesignJournal() {};
+
+    //! Destructor, closes the journal file.
+    ~DesignJournal() {close();}
+
+    //! Open the journal at the given path for appending, creating it if
+    //! needed. Returns whether the journal was opened.
+    bool open(const QString &path);
+
+    //! Close the journal file.
+    void close();
+
+    //! Return whether the journal is open for appending.
+    bool isOpen() const {return file.isOpen();}
+
+    //! Return the path of the journal file.
+    QString path() const {return file.fileName();}
+
+    //! Return the number of records appended since the journal was opened.
+    int recordCount() const {return record_count;}
+
+    //! Append one record with the given operations and flush it to disk.
+    bool append(const QVector<Op> &ops);
+
+    //! Read all intact records from the journal at the given path. Reading
+    //! stops at the first truncated or corrupted record, which is expected for
+    //! the last record if the application crashed while writing it.
+    static bool readRecords(const QString &path, QVector<QVector<Op>> &records);
+
+    static const QString journal_suffix;    // file extension of journal files
+
+  private:
+
+    QFile file;
+    int record_count=0;
+  };
+
+} // end of comp namespace
+
+#endif
@@ -0,0 +1,1116 @@
+/** @file:     design_model.cc
+ *  @author:   Samuel
+ *  @created:  2020.06.02
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Plain data model of a SiQAD design which can be loaded from and
+ *             written to SQD files without any graphics scene involvement.
+ */
+
+#include "design_model.h"
+#include "global.h"
+#include "settings/settings.h"
+
+#include <QtMath>
+#include <QColor>
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <tuple>
+
+#include <libs/zipper/zipper/zipper.h>
+#include <libs/zipper/zipper/unzipper.h>
+
+using namespace comp;
+
+const QString DesignModel::binary_suffix = "sqdb";
+const quint32 DesignModel::binary_version = 2;
+const char *DesignModel::packed_problem_magic = "SQPB";
+const quint32 DesignModel::packed_problem_version = 1;
+
+namespace {
+  void unrecognizedXMLElement(QXmlStreamReader *rs)
+  {
+    qWarning() << QObject::tr("DesignModel: invalid element encountered on line %1 - %2")
+      .arg(rs->lineNumber()).arg(rs->name().toString());
+    rs->skipCurrentElement();
+  }
+
+  // binary container entry names and magic number
+  const char *bin_magic = "SQDB";
+  const std::string entry_header = "header";
+  const std::string entry_meta = "meta";
+  const std::string entry_lattice = "lattice";
+  const std::string entry_layers = "layers";
+  std::string layerEntryName(int layer) {return QString("layer_%1").arg(layer).toStdString();}
+
+  // variable length encoding of unsigned integers, 7 bits per byte
+  void appendVarint(QByteArray &buf, quint32 val)
+  {
+    while (val >= 0x80) {
+      buf.append(static_cast<char>((val & 0x7f) | 0x80));
+      val >>= 7;
+    }
+    buf.append(static_cast<char>(val));
+  }
+
+  bool readVarint(const QByteArray &buf, int &pos, quint32 &val)
+  {
+    val = 0;
+    for (int shift=0; shift<35 && pos<buf.size(); shift+=7) {
+      quint8 byte = static_cast<quint8>(buf[pos++]);
+      val |= static_cast<quint32>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  // zigzag encoding maps signed deltas to small unsigned integers
+  quint32 zigzag(qint32 val) {return (static_cast<quint32>(val) << 1) ^ static_cast<quint32>(val >> 31);}
+  qint32 unzigzag(quint32 val) {return static_cast<qint32>(val >> 1) ^ -static_cast<qint32>(val & 1);}
+
+  QDataStream &initStream(QDataStream &ds)
+  {
+    ds.setVersion(QDataStream::Qt_5_0);
+    ds.setByteOrder(QDataStream::LittleEndian);
+    return ds;
+  }
+
+  // strings in packed problems are not QDataStream strings (UTF-16) so that
+  // they are trivial to read from other languages
+  void writePackedString(QDataStream &ds, const QString &str)
+  {
+    QByteArray utf8 = str.toUtf8();
+    ds << static_cast<quint32>(utf8.size());
+    ds.writeRawData(utf8.constData(), utf8.size());
+  }
+
+  bool addEntry(zipper::Zipper &zipper, const std::string &name, const QByteArray &data)
+  {
+    std::stringstream ss;
+    ss.write(data.constData(), data.size());
+    return zipper.add(ss, name);
+  }
+
+  bool extractEntry(zipper::Unzipper &unzipper, const std::string &name, QByteArray &data)
+  {
+    std::vector<unsigned char> buf;
+    if (!unzipper.extractEntryToMemory(name, buf))
+      return false;
+    data = QByteArray(reinterpret_cast<const char*>(buf.data()), static_cast<int>(buf.size()));
+    return true;
+  }
+}
+
+void DesignModel::clear()
+{
+  lat_def = LatticeDef();
+  layer_recs.clear();
+  db_recs.clear();
+  elec_recs.clear();
+  agg_recs.clear();
+  xml_item_recs.clear();
+  top_items.clear();
+  file_purpose.clear();
+  sim_params.clear();
+  displayed_region = QRectF();
+  pixels_per_angstrom = -1;
+  layer_load_order.clear();
+}
+
+bool DesignModel::loadFromFile(const QString &path)
+{
+  QFile file(path);
+  if (!file.open(QFile::ReadOnly | QFile::Text)) {
+    qWarning() << QObject::tr("DesignModel: error when opening file to read: %1")
+      .arg(file.errorString());
+    return false;
+  }
+
+  QXmlStreamReader rs(&file);
+  rs.readNextStartElement();
+  bool success = loadFromXmlStream(&rs);
+  file.close();
+  return success;
+}
+
+bool DesignModel::loadFromXmlStream(QXmlStreamReader *rs)
+{
+  clear();
+
+  while (rs->readNextStartElement()) {
+    if (rs->name() == "program") {
+      while (rs->readNextStartElement()) {
+        if (rs->name() == "file_purpose") {
+          file_purpose = rs->readElementText();
+        } else {
+          rs->skipCurrentElement();
+        }
+      }
+    } else if (rs->name() == "sim_params") {
+      while (rs->readNextStartElement()) {
+        QString key = rs->name().toString();
+        sim_params.append(qMakePair(key, rs->readElementText()));
+      }
+    } else if (rs->name() == "gui") {
+      QPointF tlpt, brpt;
+      while (rs->readNextStartElement()) {
+        if (rs->name() == "displayed_region") {
+          tlpt.setX(rs->attributes().value("x1").toFloat());
+          tlpt.setY(rs->attributes().value("y1").toFloat());
+          brpt.setX(rs->attributes().value("x2").toFloat());
+          brpt.setY(rs->attributes().value("y2").toFloat());
+        }
+        rs->skipCurrentElement();
+      }
+      if (!(tlpt.isNull() && brpt.isNull()))
+        displayed_region = QRectF(tlpt, brpt);
+    } else if (rs->name() == "layers") {
+      while (rs->readNextStartElement()) {
+        if (rs->name() == "layer_prop") {
+          readLayerProp(rs);
+        } else {
+          unrecognizedXMLElement(rs);
+        }
+      }
+    } else if (rs->name() == "layer_prop") {
+      // legacy support for files < v0.0.2
+      readLayerProp(rs);
+    } else if (rs->name() == "design") {
+      readDesign(rs);
+    } else {
+      unrecognizedXMLElement(rs);
+    }
+  }
+
+  if (rs->hasError()) {
+    qCritical() << QObject::tr("XML error: ") << rs->errorString().data();
+    return false;
+  }
+
+  return true;
+}
+
+bool DesignModel::loadLatticeFromFile(const QString &path)
+{
+  QFile file(path);
+  if (!file.open(QFile::ReadOnly | QFile::Text)) {
+    qCritical() << QObject::tr("Cannot open lattice file at path: %1").arg(path);
+    return false;
+  }
+
+  QXmlStreamReader rs(&file);
+  rs.readNextStartElement();
+  readLatVec(&rs);
+  file.close();
+  return lat_def.isValid();
+}
+
+bool DesignModel::saveToFile(const QString &path, const QString &t_file_purpose,
+    const QList<QPair<QString,QString>> &t_sim_params) const
+{
+  // write to path.writing first to prevent loss of the previous file if this
+  // write fails
+  QFile file(path+".writing");
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << QObject::tr("DesignModel: error when opening file to save: %1")
+      .arg(file.errorString());
+    return false;
+  }
+
+  QXmlStreamWriter ws(&file);
+  ws.setAutoFormatting(true);
+  ws.writeStartDocument();
+  ws.writeStartElement("siqad");
+
+  ws.writeComment("Program Flags");
+  ws.writeStartElement("program");
+  ws.writeTextElement("file_purpose", t_file_purpose);
+  ws.writeTextElement("version", QCoreApplication::applicationVersion());
+  ws.writeTextElement("date", QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
+  ws.writeEndElement();
+
+  if (!displayed_region.isNull()) {
+    ws.writeComment("GUI Flags");
+    ws.writeStartElement("gui");
+    ws.writeEmptyElement("displayed_region");
+    ws.writeAttribute("x1", QString::number(displayed_region.left()));
+    ws.writeAttribute("y1", QString::number(displayed_region.top()));
+    ws.writeAttribute("x2", QString::number(displayed_region.right()));
+    ws.writeAttribute("y2", QString::number(displayed_region.bottom()));
+    ws.writeEndElement();
+  }
+
+  if (!t_sim_params.isEmpty()) {
+    ws.writeStartElement("sim_params");
+    for (const QPair<QString,QString> &param : t_sim_params)
+      ws.writeTextElement(param.first, param.second);
+    ws.writeEndElement();
+  }
+
+  writeToXmlStream(&ws);
+
+  ws.writeEndElement();
+  file.close();
+
+  QFile::remove(path);
+  return file.rename(path);
+}
+
+void DesignModel::writeToXmlStream(QXmlStreamWriter *ws) const
+{
+  ws->writeComment("Layer Properties");
+  ws->writeComment("Layer ID is intrinsic to the layer order");
+  ws->writeStartElement("layers");
+  for (const LayerRecord &layer : layer_recs) {
+    ws->writeStartElement("layer_prop");
+    ws->writeTextElement("name", layer.name);
+    ws->writeTextElement("type", layer.type);
+    ws->writeTextElement("role", layer.role);
+    ws->writeTextElement("zoffset", QString::number(layer.zoffset));
+    ws->writeTextElement("zheight", QString::number(layer.zheight));
+    ws->writeTextElement("visible", QString::number(layer.visible));
+    ws->writeTextElement("active", QString::number(layer.active));
+    if (layer.type == "Lattice") {
+      ws->writeStartElement("lat_vec");
+      ws->writeTextElement("name", lat_def.name);
+      for (int i=0; i<2; i++) {
+        ws->writeEmptyElement(QString("a%1").arg(i+1));
+        ws->writeAttribute("x", QString::number(lat_def.a[i].x()));
+        ws->writeAttribute("y", QString::number(lat_def.a[i].y()));
+      }
+      ws->writeTextElement("N", QString::number(lat_def.b.size()));
+      for (int i=0; i<lat_def.b.size(); i++) {
+        ws->writeEmptyElement(QString("b%1").arg(i+1));
+        ws->writeAttribute("x", QString::number(lat_def.b[i].x()));
+        ws->writeAttribute("y", QString::number(lat_def.b[i].y()));
+      }
+      ws->writeEndElement();  // end of lat_vec
+    }
+    ws->writeEndElement();    // end of layer_prop
+  }
+  ws->writeEndElement();      // end of layers
+
+  // group DBs and aggregates by their parent aggregates once so that each
+  // aggregate can be written in a single pass
+  QVector<QVector<int>> agg_dbs(agg_recs.size()+1);       // index 0 for top level
+  QVector<QVector<int>> agg_children(agg_recs.size()+1);  // index 0 for top level
+  for (int i=0; i<db_recs.size(); i++)
+    agg_dbs[db_recs[i].aggregate+1].append(i);
+  for (int i=0; i<agg_recs.size(); i++)
+    agg_children[agg_recs[i].parent+1].append(i);
+
+  ws->writeComment("Item Hierarchy");
+  ws->writeStartElement("design");
+  for (int lay=0; lay<layer_recs.size(); lay++) {
+    ws->writeComment(layer_recs[lay].name);
+    ws->writeStartElement("layer");
+    ws->writeAttribute("type", layer_recs[lay].type);
+    // top level items in their original order, journals address them by it
+    for (const ItemRef &ref : top_items) {
+      switch (ref.kind) {
+        case DBItem:
+          if (db_recs[ref.index].layer == lay)
+            writeDB(ws, ref.index);
+          break;
+        case ElectrodeItem:
+          if (elec_recs[ref.index].layer == lay)
+            writeElectrode(ws, ref.index);
+          break;
+        case AggregateItem:
+          if (agg_recs[ref.index].layer == lay) {
+            ws->writeStartElement("aggregate");
+            writeDBs(ws, lay, ref.index, agg_dbs, agg_children);
+            ws->writeEndElement();
+          }
+          break;
+        case XmlItem:
+          if (xml_item_recs[ref.index].layer == lay)
+            writeXmlItem(ws, ref.index);
+          break;
+      }
+    }
+    ws->writeEndElement();
+  }
+  ws->writeEndElement();      // end of design
+}
+
+bool DesignModel::saveToBinaryFile(const QString &path, const QString &t_file_purpose,
+    const QList<QPair<QString,QString>> &t_sim_params) const
+{
+  QString write_path = path + ".writing";
+  QFile::remove(write_path);
+
+  // header
+  QByteArray header;
+  {
+    QDataStream ds(&header, QIODevice::WriteOnly);
+    initStream(ds);
+    ds.writeRawData(bin_magic, 4);
+    ds << binary_version << static_cast<quint32>(layer_recs.size());
+  }
+
+  // meta data
+  QByteArray meta;
+  {
+    QDataStream ds(&meta, QIODevice::WriteOnly);
+    initStream(ds);
+    ds << t_file_purpose << QCoreApplication::applicationVersion()
+       << QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss")
+       << displayed_region << static_cast<quint32>(t_sim_params.size());
+    for (const QPair<QString,QString> &param : t_sim_params)
+      ds << param.first << param.second;
+  }
+
+  // lattice
+  QByteArray lattice;
+  {
+    QDataStream ds(&lattice, QIODevice::WriteOnly);
+    initStream(ds);
+    ds << lat_def.name << lat_def.a[0] << lat_def.a[1] << lat_def.b;
+  }
+
+  // layer table
+  QByteArray layers;
+  {
+    QDataStream ds(&layers, QIODevice::WriteOnly);
+    initStream(ds);
+    for (const LayerRecord &layer : layer_recs) {
+      ds << layer.name << layer.type << layer.role << layer.zoffset
+         << layer.zheight << layer.visible << layer.active
+         << static_cast<qint32>(layer.layer_id);
+    }
+  }
+
+  // items of each layer
+  QVector<QByteArray> layer_entries(layer_recs.size());
+  QVector<QVector<int>> layer_dbs(layer_recs.size());
+  QVector<QVector<int>> layer_elecs(layer_recs.size());
+  QVector<QVector<int>> layer_aggs(layer_recs.size());
+  QVector<QVector<int>> layer_xml_items(layer_recs.size());
+  // global to layer local indices of each item kind
+  QVector<int> db_local(db_recs.size(), -1);
+  QVector<int> elec_local(elec_recs.size(), -1);
+  QVector<int> agg_local(agg_recs.size(), -1);
+  QVector<int> xml_item_local(xml_item_recs.size(), -1);
+  for (int i=0; i<db_recs.size(); i++) {
+    db_local[i] = layer_dbs[db_recs[i].layer].size();
+    layer_dbs[db_recs[i].layer].append(i);
+  }
+  for (int i=0; i<elec_recs.size(); i++) {
+    elec_local[i] = layer_elecs[elec_recs[i].layer].size();
+    layer_elecs[elec_recs[i].layer].append(i);
+  }
+  for (int i=0; i<agg_recs.size(); i++) {
+    agg_local[i] = layer_aggs[agg_recs[i].layer].size();
+    layer_aggs[agg_recs[i].layer].append(i);
+  }
+  for (int i=0; i<xml_item_recs.size(); i++) {
+    xml_item_local[i] = layer_xml_items[xml_item_recs[i].layer].size();
+    layer_xml_items[xml_item_recs[i].layer].append(i);
+  }
+
+  // top level items of each layer in their original order as item kind and
+  // layer local index
+  QVector<QVector<QPair<quint8, quint32>>> layer_top_items(layer_recs.size());
+  for (const ItemRef &ref : top_items) {
+    switch (ref.kind) {
+      case DBItem:
+        layer_top_items[db_recs[ref.index].layer].append(
+            qMakePair(quint8(DBItem), quint32(db_local[ref.index])));
+        break;
+      case ElectrodeItem:
+        layer_top_items[elec_recs[ref.index].layer].append(
+            qMakePair(quint8(ElectrodeItem), quint32(elec_local[ref.index])));
+        break;
+      case AggregateItem:
+        layer_top_items[agg_recs[ref.index].layer].append(
+            qMakePair(quint8(AggregateItem), quint32(agg_local[ref.index])));
+        break;
+      case XmlItem:
+        layer_top_items[xml_item_recs[ref.index].layer].append(
+            qMakePair(quint8(XmlItem), quint32(xml_item_local[ref.index])));
+        break;
+    }
+  }
+
+  for (int lay=0; lay<layer_recs.size(); lay++) {
+    QDataStream ds(&layer_entries[lay], QIODevice::WriteOnly);
+    initStream(ds);
+
+    // electrodes
+    const QVector<int> &elecs = layer_elecs[lay];
+    ds << static_cast<quint32>(elecs.size());
+    for (int i : elecs) {
+      const ElectrodeRecord &elec = elec_recs[i];
+      ds << elec.rect << elec.angle << static_cast<quint32>(elec.color)
+         << static_cast<quint32>(elec.properties.size());
+      for (const QPair<QString,QString> &prop : elec.properties)
+        ds << prop.first << prop.second;
+    }
+
+    // aggregates as layer local parent indices
+    ds << static_cast<quint32>(layer_aggs[lay].size());
+    for (int i : layer_aggs[lay]) {
+      int parent = agg_recs[i].parent;
+      ds << static_cast<qint32>(parent == -1 ? -1 : agg_local[parent]);
+    }
+
+    // DBs with delta encoded lattice coordinates and run length encoded colors
+    QByteArray db_coords, db_colors;
+    qint32 prev_n=0, prev_m=0, prev_l=0;
+    quint32 color_run=0;
+    QRgb run_color=0;
+    for (int i : layer_dbs[lay]) {
+      const DBRecord &db = db_recs[i];
+      appendVarint(db_coords, zigzag(db.n - prev_n));
+      appendVarint(db_coords, zigzag(db.m - prev_m));
+      appendVarint(db_coords, zigzag(db.l - prev_l));
+      appendVarint(db_coords, static_cast<quint32>(db.aggregate == -1 ? 0 : agg_local[db.aggregate]+1));
+      prev_n = db.n; prev_m = db.m; prev_l = db.l;
+      if (color_run > 0 && db.color != run_color) {
+        appendVarint(db_colors, color_run);
+        appendVarint(db_colors, run_color);
+        color_run = 0;
+      }
+      run_color = db.color;
+      color_run++;
+    }
+    if (color_run > 0) {
+      appendVarint(db_colors, color_run);
+      appendVarint(db_colors, run_color);
+    }
+    ds << static_cast<quint32>(layer_dbs[lay].size()) << db_coords << db_colors;
+
+    // items kept as XML and the order of the top level items, since version 2
+    ds << static_cast<quint32>(layer_xml_items[lay].size());
+    for (int i : layer_xml_items[lay])
+      ds << xml_item_recs[i].xml;
+    ds << static_cast<quint32>(layer_top_items[lay].size());
+    for (const QPair<quint8, quint32> &item : layer_top_items[lay])
+      ds << item.first << item.second;
+  }
+
+  // write the container
+  bool success = true;
+  try {
+    zipper::Zipper zipper(write_path.toStdString());
+    success &= addEntry(zipper, entry_header, header);
+    success &= addEntry(zipper, entry_meta, meta);
+    success &= addEntry(zipper, entry_lattice, lattice);
+    success &= addEntry(zipper, entry_layers, layers);
+    for (int lay=0; lay<layer_entries.size(); lay++)
+      success &= addEntry(zipper, layerEntryName(lay), layer_entries[lay]);
+    zipper.close();
+  } catch (const std::exception &e) {
+    qWarning() << e.what();
+    success = false;
+  }
+
+  if (!success) {
+    qWarning() << QObject::tr("DesignModel: error when writing binary file %1").arg(write_path);
+    QFile::remove(write_path);
+    return false;
+  }
+
+  QFile::remove(path);
+  return QFile::rename(write_path, path);
+}
+
+QByteArray DesignModel::packedSimProblem(const QList<QPair<QString,QString>> &t_sim_params) const
+{
+  QByteArray packed;
+  QDataStream ds(&packed, QIODevice::WriteOnly);
+  initStream(ds);
+  ds.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+  // simulation parameters
+  QList<QPair<QString,QString>> params = t_sim_params;
+  std::sort(params.begin(), params.end());
+  ds << static_cast<quint32>(params.size());
+  for (const QPair<QString,QString> &param : params) {
+    writePackedString(ds, param.first);
+    writePackedString(ds, param.second);
+  }
+
+  // lattice
+  writePackedString(ds, lat_def.name);
+  ds << lat_def.a[0].x() << lat_def.a[0].y() << lat_def.a[1].x() << lat_def.a[1].y()
+     << static_cast<quint32>(lat_def.b.size());
+  for (const QPointF &site : lat_def.b)
+    ds << site.x() << site.y();
+
+  // layer table
+  ds << static_cast<quint32>(layer_recs.size());
+  for (const LayerRecord &layer : layer_recs) {
+    writePackedString(ds, layer.name);
+    writePackedString(ds, layer.type);
+    writePackedString(ds, layer.role);
+    ds << static_cast<double>(layer.zoffset) << static_cast<double>(layer.zheight);
+  }
+
+  // DBs
+  QVector<int> db_order(db_recs.size());
+  std::iota(db_order.begin(), db_order.end(), 0);
+  std::sort(db_order.begin(), db_order.end(), [this](int a, int b)
+      {
+        const DBRecord &db_a = db_recs[a], &db_b = db_recs[b];
+        return std::tie(db_a.layer, db_a.n, db_a.m, db_a.l)
+          < std::tie(db_b.layer, db_b.n, db_b.m, db_b.l);
+      });
+  ds << static_cast<quint32>(db_recs.size());
+  for (int i : db_order) {
+    const DBRecord &db = db_recs[i];
+    QPointF loc = latticeCoord2PhysLoc(db.n, db.m, db.l);
+    ds << db.n << db.m << db.l << db.layer << loc.x() << loc.y();
+  }
+
+  // electrodes
+  ds << static_cast<quint32>(elec_recs.size());
+  for (const ElectrodeRecord &elec : elec_recs) {
+    ds << elec.layer << elec.rect.left() << elec.rect.top() << elec.rect.right()
+       << elec.rect.bottom() << elec.angle
+       << static_cast<quint32>(elec.properties.size());
+    for (const QPair<QString,QString> &prop : elec.properties) {
+      writePackedString(ds, prop.first);
+      writePackedString(ds, prop.second);
+    }
+  }
+
+  return packed;
+}
+
+bool DesignModel::loadFromBinaryFile(const QString &path, const QList<int> &load_layers)
+{
+  clear();
+
+  if (!QFileInfo(path).isFile()) {
+    qWarning() << QObject::tr("DesignModel: binary file %1 not found").arg(path);
+    return false;
+  }
+
+  // zipper reports failures to open an archive with exceptions
+  bool success = false;
+  try {
+    zipper::Unzipper unzipper(path.toStdString());
+    success = readBinaryEntries(unzipper, path, load_layers);
+    unzipper.close();
+  } catch (const std::exception &e) {
+    qCritical() << QObject::tr("DesignModel: unable to open %1: %2").arg(path).arg(e.what());
+  }
+  return success;
+}
+
+bool DesignModel::readBinaryEntries(zipper::Unzipper &unzipper, const QString &path,
+    const QList<int> &load_layers)
+{
+  auto readFailure = [&path](const QString &entry)
+  {
+    qCritical() << QObject::tr("DesignModel: unable to read %1 from %2").arg(entry).arg(path);
+    return false;
+  };
+
+  // header
+  QByteArray buf;
+  quint32 version=0, layer_count=0;
+  if (!extractEntry(unzipper, entry_header, buf))
+    return readFailure("header");
+  {
+    QDataStream ds(buf);
+    initStream(ds);
+    char magic[4];
+    if (ds.readRawData(magic, 4) != 4 || qstrncmp(magic, bin_magic, 4) != 0)
+      return readFailure("header");
+    ds >> version >> layer_count;
+  }
+  if (version > binary_version) {
+    qCritical() << QObject::tr("DesignModel: binary format version %1 of %2 is newer "
+        "than the supported version %3").arg(version).arg(path).arg(binary_version);
+    return false;
+  }
+
+  // meta data
+  if (!extractEntry(unzipper, entry_meta, buf))
+    return readFailure("meta");
+  {
+    QDataStream ds(buf);
+    initStream(ds);
+    QString version_str, date_str;
+    quint32 param_count;
+    ds >> file_purpose >> version_str >> date_str >> displayed_region >> param_count;
+    for (quint32 i=0; i<param_count && ds.status() == QDataStream::Ok; i++) {
+      QPair<QString,QString> param;
+      ds >> param.first >> param.second;
+      sim_params.append(param);
+    }
+  }
+
+  // lattice
+  if (!extractEntry(unzipper, entry_lattice, buf))
+    return readFailure("lattice");
+  {
+    QDataStream ds(buf);
+    initStream(ds);
+    ds >> lat_def.name >> lat_def.a[0] >> lat_def.a[1] >> lat_def.b;
+  }
+
+  // layer table
+  if (!extractEntry(unzipper, entry_layers, buf))
+    return readFailure("layers");
+  {
+    QDataStream ds(buf);
+    initStream(ds);
+    for (quint32 i=0; i<layer_count; i++) {
+      LayerRecord layer;
+      qint32 layer_id;
+      ds >> layer.name >> layer.type >> layer.role >> layer.zoffset
+         >> layer.zheight >> layer.visible >> layer.active >> layer_id;
+      layer.layer_id = layer_id;
+      addLayer(layer);
+    }
+    if (ds.status() != QDataStream::Ok)
+      return readFailure("layers");
+  }
+
+  // items of the requested layers
+  for (int lay=0; lay<layer_recs.size(); lay++) {
+    if (!load_layers.isEmpty() && !load_layers.contains(lay))
+      continue;
+    if (!extractEntry(unzipper, layerEntryName(lay), buf))
+      return readFailure(QString::fromStdString(layerEntryName(lay)));
+
+    QDataStream ds(buf);
+    initStream(ds);
+
+    int db_offset = db_recs.size();
+    int elec_offset = elec_recs.size();
+    int xml_item_offset = xml_item_recs.size();
+    int top_item_offset = top_items.size();
+
+    quint32 count;
+    ds >> count;
+    for (quint32 i=0; i<count && ds.status() == QDataStream::Ok; i++) {
+      ElectrodeRecord elec;
+      quint32 color, prop_count;
+      elec.layer = lay;
+      ds >> elec.rect >> elec.angle >> color >> prop_count;
+      elec.color = color;
+      for (quint32 j=0; j<prop_count && ds.status() == QDataStream::Ok; j++) {
+        QPair<QString,QString> prop;
+        ds >> prop.first >> prop.second;
+        elec.properties.append(prop);
+      }
+      addElectrode(elec);
+    }
+
+    int agg_offset = agg_recs.size();
+    ds >> count;
+    for (quint32 i=0; i<count && ds.status() == QDataStream::Ok; i++) {
+      qint32 parent;
+      ds >> parent;
+      addAggregate(lay, parent == -1 ? -1 : agg_offset + parent);
+    }
+
+    QByteArray db_coords, db_colors;
+    ds >> count >> db_coords >> db_colors;
+    if (ds.status() != QDataStream::Ok)
+      return readFailure(QString::fromStdString(layerEntryName(lay)));
+
+    db_recs.reserve(db_recs.size() + static_cast<int>(count));
+    int coord_pos=0, color_pos=0;
+    quint32 color_run=0, color=0;
+    qint32 n=0, m=0, l=0;
+    for (quint32 i=0; i<count; i++) {
+      quint32 dn, dm, dl, agg;
+      if (!(readVarint(db_coords, coord_pos, dn) && readVarint(db_coords, coord_pos, dm)
+            && readVarint(db_coords, coord_pos, dl) && readVarint(db_coords, coord_pos, agg)))
+        return readFailure(QString::fromStdString(layerEntryName(lay)));
+      if (color_run == 0) {
+        if (!(readVarint(db_colors, color_pos, color_run) && readVarint(db_colors, color_pos, color)))
+          return readFailure(QString::fromStdString(layerEntryName(lay)));
+      }
+      color_run--;
+      n += unzigzag(dn);
+      m += unzigzag(dm);
+      l += unzigzag(dl);
+      addDB(n, m, l, lay, color, agg == 0 ? -1 : agg_offset + static_cast<int>(agg) - 1);
+    }
+
+    // version 1 containers have neither XML items nor the item order, their
+    // top level items stay grouped by kind
+    if (version < 2)
+      continue;
+
+    ds >> count;
+    for (quint32 i=0; i<count && ds.status() == QDataStream::Ok; i++) {
+      QByteArray xml;
+      ds >> xml;
+      addXmlItem(lay, xml);
+    }
+
+    // replace the top level items added above by the stored order
+    QVector<ItemRef> layer_items;
+    ds >> count;
+    for (quint32 i=0; i<count && ds.status() == QDataStream::Ok; i++) {
+      quint8 kind;
+      quint32 local_ind;
+      ds >> kind >> local_ind;
+      int offset, size;
+      switch (kind) {
+        case DBItem:
+          offset = db_offset;
+          size = db_recs.size();
+          break;
+        case ElectrodeItem:
+          offset = elec_offset;
+          size = elec_recs.size();
+          break;
+        case AggregateItem:
+          offset = agg_offset;
+          size = agg_recs.size();
+          break;
+        case XmlItem:
+          offset = xml_item_offset;
+          size = xml_item_recs.size();
+          break;
+        default:
+          return readFailure(QString::fromStdString(layerEntryName(lay)));
+      }
+      if (local_ind >= static_cast<quint32>(size - offset))
+        return readFailure(QString::fromStdString(layerEntryName(lay)));
+      layer_items.append(ItemRef{static_cast<ItemKind>(kind),
+          offset + static_cast<qint32>(local_ind)});
+    }
+    if (ds.status() != QDataStream::Ok
+        || layer_items.size() != top_items.size() - top_item_offset)
+      return readFailure(QString::fromStdString(layerEntryName(lay)));
+    std::copy(layer_items.cbegin(), layer_items.cend(),
+              top_items.begin() + top_item_offset);
+  }
+
+  return true;
+}
+
+int DesignModel::firstLayerOfType(const QString &type) const
+{
+  for (int i=0; i<layer_recs.size(); i++)
+    if (layer_recs[i].type == type)
+      return i;
+  return -1;
+}
+
+
+// PRIVATE
+
+void DesignModel::readLayerProp(QXmlStreamReader *rs)
+{
+  LayerRecord layer;
+  while (rs->readNextStartElement()) {
+    if (rs->name() == "name") {
+      layer.name = rs->readElementText();
+    } else if (rs->name() == "type") {
+      layer.type = rs->readElementText();
+    } else if (rs->name() == "role") {
+      layer.role = rs->readElementText();
+    } else if (rs->name() == "zoffset") {
+      layer.zoffset = rs->readElementText().toFloat();
+    } else if (rs->name() == "zheight") {
+      layer.zheight = rs->readElementText().toFloat();
+    } else if (rs->name() == "visible") {
+      layer.visible = rs->readElementText() == "1";
+    } else if (rs->name() == "active") {
+      layer.active = rs->readElementText() == "1";
+    } else if (rs->name() == "lat_vec") {
+      readLatVec(rs);
+    } else {
+      unrecognizedXMLElement(rs);
+    }
+  }
+
+  layer.layer_id = layer_load_order.size();
+
+  // overlay and result layers are not part of the design
+  if (layer.role == "Overlay" || layer.role == "Result") {
+    layer_load_order.append(-1);
+    return;
+  }
+  layer_load_order.append(addLayer(layer));
+}
+
+void DesignModel::readDesign(QXmlStreamReader *rs)
+{
+  // use the default lattice if the file doesn't define one
+  if (!lat_def.isValid()) {
+    loadLatticeFromFile(!fallback_lat_path.isEmpty() ? fallback_lat_path
+        : settings::LatticeSettings::instance()->get<QString>(
+          "lattice/default_lattice_file_path"));
+  }
+
+  int layer_load_ind=0;
+  while (rs->readNextStartElement()) {
+    if (rs->name() == "layer") {
+      int layer = layer_load_order.value(layer_load_ind++, -1);
+      if (layer == -1) {
+        rs->skipCurrentElement();
+        continue;
+      }
+      readLayerItems(rs, layer, -1);
+    } else {
+      unrecognizedXMLElement(rs);
+    }
+  }
+}
+
+void DesignModel::readLatVec(QXmlStreamReader *rs)
+{
+  QList<QPair<int, QPointF>> read_atoms_raw;
+  lat_def = LatticeDef();
+  while (rs->readNextStartElement()) {
+    QPointF pt(rs->attributes().value("x").toFloat(),
+               rs->attributes().value("y").toFloat());
+    if (rs->name() == "name") {
+      lat_def.name = rs->readElementText();
+    } else if (rs->name() == "N") {
+      rs->skipCurrentElement();
+    } else if (rs->name() == "a1") {
+      lat_def.a[0] = pt;
+      rs->skipCurrentElement();
+    } else if (rs->name() == "a2") {
+      lat_def.a[1] = pt;
+      rs->skipCurrentElement();
+    } else if (rs->name().startsWith("b")) {
+      read_atoms_raw.append(qMakePair(rs->name().mid(1).toInt(), pt));
+      rs->skipCurrentElement();
+    } else {
+      unrecognizedXMLElement(rs);
+    }
+  }
+
+  std::sort(read_atoms_raw.begin(), read_atoms_raw.end(), QPairFirstComparer());
+  for (const QPair<int, QPointF> &atom : read_atoms_raw)
+    lat_def.b.append(atom.second);
+}
+
+void DesignModel::readLayerItems(QXmlStreamReader *rs, int layer, int aggregate)
+{
+  while (rs->readNextStartElement()) {
+    if (rs->name() == "dbdot") {
+      readDB(rs, layer, aggregate);
+    } else if (rs->name() == "aggregate") {
+      readLayerItems(rs, layer, addAggregate(layer, aggregate));
+    } else if (rs->name() == "electrode" && aggregate == -1) {
+      readElectrode(rs, layer);
+    } else if (aggregate == -1) {
+      readXmlItem(rs, layer);
+    } else {
+      unrecognizedXMLElement(rs);
+    }
+  }
+}
+
+void DesignModel::readDB(QXmlStreamReader *rs, int layer, int aggregate)
+{
+  qint32 n=0, m=0, l=-1;
+  QPointF loc;
+  QRgb color = 0;
+  bool has_color = false;
+  while (rs->readNextStartElement()) {
+    if (rs->name() == "latcoord") {
+      n = rs->attributes().value("n").toInt();
+      m = rs->attributes().value("m").toInt();
+      l = rs->attributes().value("l").toInt();
+      rs->skipCurrentElement();
+    } else if (rs->name() == "physloc") {
+      loc.setX(rs->attributes().value("x").toFloat());
+      loc.setY(rs->attributes().value("y").toFloat());
+      rs->skipCurrentElement();
+    } else if (rs->name() == "color") {
+      QColor col(rs->readElementText());
+      has_color = col.isValid();
+      color = col.rgba();
+    } else {
+      // layer_id is no longer used for loading
+      rs->skipCurrentElement();
+    }
+  }
+
+  // legacy saves only contain the physical location, find the nearest
+  // lattice site in that case
+  if (l == -1) {
+    if (loc.isNull() || !lat_def.isValid()) {
+      qWarning() << QObject::tr("DesignModel: DB without lattice coordinates "
+          "encountered on line %1, skipping.").arg(rs->lineNumber());
+      return;
+    }
+    qreal mdist = -1;
+    int n0 = qFloor(QPointF::dotProduct(loc, lat_def.a[0])
+        / QPointF::dotProduct(lat_def.a[0], lat_def.a[0]));
+    int m0 = qFloor(QPointF::dotProduct(loc, lat_def.a[1])
+        / QPointF::dotProduct(lat_def.a[1], lat_def.a[1]));
+    for (int n_s=n0-1; n_s<n0+2; n_s++) {
+      for (int m_s=m0-1; m_s<m0+2; m_s++) {
+        for (int l_s=0; l_s<lat_def.b.size(); l_s++) {
+          qreal dist = (latticeCoord2PhysLoc(n_s, m_s, l_s) - loc).manhattanLength();
+          if (mdist < 0 || dist < mdist) {
+            mdist = dist;
+            n = n_s; m = m_s; l = l_s;
+          }
+        }
+      }
+    }
+  }
+
+  if (!has_color)
+    color = QColor(0, 0, 0, 0).rgba();  // alpha 0 indicates the default color
+
+  addDB(n, m, l, layer, color, aggregate);
+}
+
+void DesignModel::readElectrode(QXmlStreamReader *rs, int layer)
+{
+  ElectrodeRecord elec;
+  elec.layer = layer;
+  elec.color = QColor(0, 0, 0, 0).rgba();
+  QPointF pt1, pt2;
+  while (rs->readNextStartElement()) {
+    if (rs->name() == "dim") {
+      pt1.setX(rs->attributes().value("x1").toFloat());
+      pt1.setY(rs->attributes().value("y1").toFloat());
+      pt2.setX(rs->attributes().value("x2").toFloat());
+      pt2.setY(rs->attributes().value("y2").toFloat());
+      rs->skipCurrentElement();
+    } else if (rs->name() == "angle") {
+      elec.angle = rs->readElementText().toDouble();
+    } else if (rs->name() == "color") {
+      QColor col(rs->readElementText());
+      if (col.isValid())
+        elec.color = col.rgba();
+    } else if (rs->name() == "property_map") {
+      while (rs->readNextStartElement()) {
+        QString key = rs->name().toString();
+        QString val;
+        while (rs->readNextStartElement()) {
+          if (rs->name() == "val")
+            val = rs->readElementText();
+          else
+            rs->skipCurrentElement();
+        }
+        elec.properties.append(qMakePair(key, val));
+      }
+    } else if (rs->name() == "pixel_per_angstrom") {
+      pixels_per_angstrom = rs->readElementText().toDouble();
+    } else {
+      // layer_id is not needed
+      rs->skipCurrentElement();
+    }
+  }
+  elec.rect = QRectF(pt1, pt2).normalized();
+  addElectrode(elec);
+}
+
+void DesignModel::readXmlItem(QXmlStreamReader *rs, int layer)
+{
+  // copy the element with everything it contains
+  QByteArray xml;
+  QXmlStreamWriter ws(&xml);
+  int depth = 0;
+  do {
+    if (rs->isStartElement())
+      depth++;
+    else if (rs->isEndElement())
+      depth--;
+    if (!rs->isWhitespace())
+      ws.writeCurrentToken(*rs);
+  } while (depth > 0 && !rs->hasError() && rs->readNext() != QXmlStreamReader::Invalid);
+  if (!rs->hasError())
+    addXmlItem(layer, xml);
+}
+
+void DesignModel::writeDBs(QXmlStreamWriter *ws, int layer, int aggregate,
+    const QVector<QVector<int>> &agg_dbs,
+    const QVector<QVector<int>> &agg_children) const
+{
+  for (int db_ind : agg_dbs[aggregate+1])
+    if (db_recs[db_ind].layer == layer)
+      writeDB(ws, db_ind);
+  for (int agg_ind : agg_children[aggregate+1]) {
+    if (agg_recs[agg_ind].layer != layer)
+      continue;
+    ws->writeStartElement("aggregate");
+    writeDBs(ws, layer, agg_ind, agg_dbs, agg_children);
+    ws->writeEndElement();
+  }
+}
+
+void DesignModel::writeDB(QXmlStreamWriter *ws, int db_ind) const
+{
+  const DBRecord &db = db_recs[db_ind];
+  QPointF physloc = latticeCoord2PhysLoc(db.n, db.m, db.l);
+
+  ws->writeStartElement("dbdot");
+  ws->writeTextElement("layer_id", QString::number(layerID(db.layer)));
+  ws->writeEmptyElement("latcoord");
+  ws->writeAttribute("n", QString::number(db.n));
+  ws->writeAttribute("m", QString::number(db.m));
+  ws->writeAttribute("l", QString::number(db.l));
+  ws->writeEmptyElement("physloc");
+  ws->writeAttribute("x", QString::number(physloc.x()));
+  ws->writeAttribute("y", QString::number(physloc.y()));
+  if (qAlpha(db.color) != 0)
+    ws->writeTextElement("color", QColor::fromRgba(db.color).name(QColor::HexArgb));
+  ws->writeEndElement();
+}
+
+void DesignModel::writeElectrode(QXmlStreamWriter *ws, int elec_ind) const
+{
+  const ElectrodeRecord &elec = elec_recs[elec_ind];
+
+  ws->writeStartElement("electrode");
+  ws->writeTextElement("layer_id", QString::number(layerID(elec.layer)));
+  ws->writeEmptyElement("dim");
+  ws->writeAttribute("x1", QString::number(elec.rect.left()));
+  ws->writeAttribute("y1", QString::number(elec.rect.top()));
+  ws->writeAttribute("x2", QString::number(elec.rect.right()));
+  ws->writeAttribute("y2", QString::number(elec.rect.bottom()));
+  ws->writeTextElement("pixel_per_angstrom", QString::number(pixels_per_angstrom > 0
+        ? pixels_per_angstrom
+        : settings::GUISettings::instance()->get<qreal>("view/scale_fact")));
+  ws->writeTextElement("angle", QString::number(elec.angle));
+  if (qAlpha(elec.color) != 0)
+    ws->writeTextElement("color", QColor::fromRgba(elec.color).name(QColor::HexArgb));
+  ws->writeStartElement("property_map");
+  for (const QPair<QString,QString> &prop : elec.properties) {
+    ws->writeStartElement(prop.first);
+    ws->writeTextElement("val", prop.second);
+    ws->writeEndElement();
+  }
+  ws->writeEndElement();  // end of property_map
+  ws->writeEndElement();
+}
+
+void DesignModel::writeXmlItem(QXmlStreamWriter *ws, int item_ind) const
+{
+  const XmlItemRecord &item = xml_item_recs[item_ind];
+  QXmlStreamReader rs(item.xml);
+  int depth = 0;
+  while (!rs.atEnd()) {
+    rs.readNext();
+    if (rs.isStartElement()) {
+      depth++;
+      // the layer ID of the item refers to the written layer list like those
+      // of DBs and electrodes
+      if (depth == 2 && rs.name() == "layer_id") {
+        ws->writeTextElement("layer_id", QString::number(layerID(item.layer)));
+        rs.skipCurrentElement();
+        depth--;
+        continue;
+      }
+    } else if (rs.isEndElement()) {
+      depth--;
+    }
+    if (rs.isStartElement() || rs.isEndElement()
+        || (rs.isCharacters() && !rs.isWhitespace()))
+      ws->writeCurrentToken(rs);
+  }
+}
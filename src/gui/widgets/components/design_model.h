@@ -0,0 +1,368 @@
+/** @file:     design_model.h
+ *  @author:   Samuel
+ *  @created:  2020.06.02
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Plain data model of a SiQAD design which can be loaded from and
+ *             written to SQD files without any graphics scene involvement.
+ */
+
+#ifndef _COMP_DESIGN_MODEL_H_
+#define _COMP_DESIGN_MODEL_H_
+
+#include <QtCore>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QRgb>
+
+namespace zipper{
+  class Unzipper;
+}
+
+namespace comp{
+
+  //! DesignModel holds the content of a design (layers, DB lattice coordinates
+  //! and electrode geometries) in compact arrays. It does not depend on any
+  //! QGraphicsScene or widget and can be used in headless pipelines, e.g. to
+  //! read a design file and write a simulation problem from it. DesignPanel
+  //! produces and consumes DesignModel instances for the same purposes.
+  //!
+  //! All containers are implicitly shared, copying a DesignModel is cheap
+  //! until either copy is modified.
+  class DesignModel
+  {
+  public:
+
+    //! Lattice definition in angstrom.
+    struct LatticeDef
+    {
+      QString name;
+      QPointF a[2];         // lattice vectors
+      QVector<QPointF> b;   // unit cell site vectors
+
+      bool isValid() const {return !b.isEmpty();}
+    };
+
+    //! Layer properties, type and role strings correspond to the keys of
+    //! prim::Layer::LayerType and prim::Layer::LayerRole.
+    struct LayerRecord
+    {
+      QString name;
+      QString type;
+      QString role="Design";
+      float zoffset=0;
+      float zheight=0;
+      bool visible=true;
+      bool active=false;
+      int layer_id=-1;      // layer ID in the originating design, -1 if none,
+                            // informational only, see layerID()
+    };
+
+    //! A single dangling bond.
+    struct DBRecord
+    {
+      qint32 n;
+      qint32 m;
+      qint32 l;
+      qint32 layer;         // index in layers()
+      qint32 aggregate;     // index in aggregates, -1 if not in an aggregate
+      QRgb color;
+    };
+
+    //! A single electrode with its geometry in angstrom.
+    struct ElectrodeRecord
+    {
+      qint32 layer;         // index in layers()
+      QRectF rect;          // unrotated rectangle in angstrom
+      qreal angle=0;        // rotation in degrees
+      QRgb color;
+      QList<QPair<QString,QString>> properties; // property key and value pairs
+    };
+
+    //! An aggregate, DBs and other aggregates point to it.
+    struct AggregateRecord
+    {
+      qint32 layer;         // index in layers()
+      qint32 parent;        // index of parent aggregate, -1 if top level
+    };
+
+    //! A top level item the model doesn't represent (e.g. text labels), kept
+    //! as the XML written by the item so that it survives a round trip
+    //! through SQD and binary SQD files.
+    struct XmlItemRecord
+    {
+      qint32 layer;         // index in layers()
+      QByteArray xml;       // the item element
+    };
+
+    //! Kinds of records a top level item can be.
+    enum ItemKind{DBItem, ElectrodeItem, AggregateItem, XmlItem};
+
+    //! A top level item of a layer, kept in the order the items were added so
+    //! that written layers preserve the item order of the originating design.
+    struct ItemRef
+    {
+      ItemKind kind;
+      qint32 index;         // index in the records of the kind
+    };
+
+    //! Constructor creating an empty model.
+    DesignModel() {};
+
+    //! Destructor.
+    ~DesignModel() {};
+
+    //! Clear all contents.
+    void clear();
+
+    //! Load from the SQD file at the specified path. Returns whether the load
+    //! was successful.
+    bool loadFromFile(const QString &path);
+
+    //! Load from the XML stream, the stream should already be positioned at
+    //! the root (siqad) element. Returns whether the load was successful.
+    bool loadFromXmlStream(QXmlStreamReader *rs);
+
+    //! Load the lattice definition from a lattice file, e.g. one of the
+    //! default lattice resources.
+    bool loadLatticeFromFile(const QString &path);
+
+    //! Set the lattice file used when the loaded design doesn't define its
+    //! lattice. If unset, the default lattice from LatticeSettings is used,
+    //! set this when loading outside of the GUI thread.
+    void setFallbackLatticePath(const QString &path) {fallback_lat_path = path;}
+
+    //! Write the model to a complete SQD file. The file purpose is recorded in
+    //! the program element, sim_params are written if provided.
+    bool saveToFile(const QString &path, const QString &file_purpose="save",
+        const QList<QPair<QString,QString>> &sim_params=QList<QPair<QString,QString>>()) const;
+
+    //! Write a simulation problem file from this model.
+    bool writeSimProblem(const QString &path,
+        const QList<QPair<QString,QString>> &sim_params) const
+    {
+      return saveToFile(path, "simulation", sim_params);
+    }
+
+    //! Write the layers and design elements to the XML stream, in the same
+    //! format as DesignPanel::writeToXmlStream minus the GUI flags.
+    void writeToXmlStream(QXmlStreamWriter *ws) const;
+
+    //! Return whether the path refers to the binary SQD format by extension.
+    static bool isBinaryPath(const QString &path)
+    {
+      return QFileInfo(path).suffix() == binary_suffix;
+    }
+
+    //! Write the model to a binary SQD container. The container is a zip
+    //! archive with separately compressed entries for the meta data, lattice,
+    //! layer table and the items of each layer. DB lattice coordinates are
+    //! delta encoded. Items kept as XML and the order of top level items are
+    //! stored as well.
+    bool saveToBinaryFile(const QString &path, const QString &file_purpose="save",
+        const QList<QPair<QString,QString>> &sim_params=QList<QPair<QString,QString>>()) const;
+
+    //! Load from a binary SQD container. If load_layers is non-empty, only the
+    //! items of the listed layer indices are extracted and decoded, the layer
+    //! table is always loaded in full.
+    bool loadFromBinaryFile(const QString &path,
+        const QList<int> &load_layers=QList<int>());
+
+    //! Return a simulation problem packed for plugins which read it from
+    //! shared memory instead of parsing a problem file. All values are little
+    //! endian, strings are a uint32 byte count followed by UTF-8 bytes:
+    //!   uint32 parameter count, then key and value strings sorted by key
+    //!   lattice name, float64 a1 x y, a2 x y, uint32 site count, site x y
+    //!   uint32 layer count, then name, type, role, float64 zoffset, zheight
+    //!   uint32 DB count, then int32 n, m, l, layer, float64 x, y in angstrom
+    //!   uint32 electrode count, then int32 layer, float64 x1, y1, x2, y2 in
+    //!     angstrom, float64 angle, uint32 property count, key value strings
+    //! DBs are sorted by layer and lattice coordinates so that identical
+    //! designs pack identically.
+    QByteArray packedSimProblem(const QList<QPair<QString,QString>> &sim_params) const;
+
+    static const QString binary_suffix;       // file extension of the binary format
+    static const quint32 binary_version;      // current binary format version
+    static const char *packed_problem_magic;  // magic of packed simulation problems
+    static const quint32 packed_problem_version;  // current packed problem version
+
+
+    // Content manipulation
+
+    //! Set the lattice definition.
+    void setLattice(const LatticeDef &t_lattice) {lat_def = t_lattice;}
+
+    //! Append a layer and return its index.
+    int addLayer(const LayerRecord &layer) {layer_recs.append(layer); return layer_recs.size()-1;}
+
+    //! Append a DB to the given layer and return its index.
+    int addDB(qint32 n, qint32 m, qint32 l, qint32 layer, QRgb color,
+        qint32 aggregate=-1)
+    {
+      db_recs.append(DBRecord{n, m, l, layer, aggregate, color});
+      if (aggregate == -1)
+        top_items.append(ItemRef{DBItem, db_recs.size()-1});
+      return db_recs.size()-1;
+    }
+
+    //! Append an electrode and return its index.
+    int addElectrode(const ElectrodeRecord &elec)
+    {
+      elec_recs.append(elec);
+      top_items.append(ItemRef{ElectrodeItem, elec_recs.size()-1});
+      return elec_recs.size()-1;
+    }
+
+    //! Append an aggregate and return its index.
+    int addAggregate(qint32 layer, qint32 parent=-1)
+    {
+      agg_recs.append(AggregateRecord{layer, parent});
+      if (parent == -1)
+        top_items.append(ItemRef{AggregateItem, agg_recs.size()-1});
+      return agg_recs.size()-1;
+    }
+
+    //! Append an item element to the given layer and return its index.
+    int addXmlItem(qint32 layer, const QByteArray &xml)
+    {
+      xml_item_recs.append(XmlItemRecord{layer, xml});
+      top_items.append(ItemRef{XmlItem, xml_item_recs.size()-1});
+      return xml_item_recs.size()-1;
+    }
+
+    //! Reserve space for the given number of DBs.
+    void reserveDBs(int count) {db_recs.reserve(count);}
+
+
+    // Accessors
+
+    //! Return the lattice definition.
+    const LatticeDef &lattice() const {return lat_def;}
+
+    //! Return the layers.
+    const QVector<LayerRecord> &layers() const {return layer_recs;}
+
+    //! Return the DBs.
+    const QVector<DBRecord> &dbs() const {return db_recs;}
+
+    //! Return the electrodes.
+    const QVector<ElectrodeRecord> &electrodes() const {return elec_recs;}
+
+    //! Return the aggregates.
+    const QVector<AggregateRecord> &aggregates() const {return agg_recs;}
+
+    //! Return the items kept as XML.
+    const QVector<XmlItemRecord> &xmlItems() const {return xml_item_recs;}
+
+    //! Return the top level items of all layers in the order they were added.
+    const QVector<ItemRef> &topLevelItems() const {return top_items;}
+
+    //! Return the number of DBs.
+    int dbCount() const {return db_recs.size();}
+
+    //! Return the layer ID written to items of the specified layer. This is
+    //! the position of the layer in the written layer list, which differs
+    //! from the ID in the originating design when layers were left out.
+    int layerID(int layer) const {return layer;}
+
+    //! Return the index of the first layer with the given type, -1 if none.
+    int firstLayerOfType(const QString &type) const;
+
+    //! Return the physical location (angstrom) of the specified DB.
+    QPointF dbPhysLoc(int db_ind) const
+    {
+      const DBRecord &db = db_recs[db_ind];
+      return latticeCoord2PhysLoc(db.n, db.m, db.l);
+    }
+
+    //! Convert lattice coordinates to physical location in angstrom.
+    QPointF latticeCoord2PhysLoc(int n, int m, int l) const
+    {
+      return n * lat_def.a[0] + m * lat_def.a[1] + lat_def.b.value(l);
+    }
+
+    //! Return the file purpose read from the program element.
+    QString filePurpose() const {return file_purpose;}
+
+    //! Return the simulation parameters read from the file, if any.
+    QList<QPair<QString,QString>> simParams() const {return sim_params;}
+
+    //! Return the displayed region in angstrom as read from the GUI flags, a
+    //! null QRectF if unavailable.
+    QRectF displayedRegion() const {return displayed_region;}
+
+    //! Set the displayed region in angstrom.
+    void setDisplayedRegion(const QRectF &region) {displayed_region = region;}
+
+    //! Return the scale of the GUI view in pixels per angstrom which is written
+    //! with electrodes, -1 if neither set nor read from an SQD file.
+    qreal pixelsPerAngstrom() const {return pixels_per_angstrom;}
+
+    //! Set the scale of the GUI view in pixels per angstrom. If unset, writing
+    //! electrodes reads it from the GUI settings, so set it when writing
+    //! outside of the GUI thread.
+    void setPixelsPerAngstrom(qreal scale) {pixels_per_angstrom = scale;}
+
+  private:
+
+    //! Read the entries of a binary SQD container.
+    bool readBinaryEntries(zipper::Unzipper &unzipper, const QString &path,
+        const QList<int> &load_layers);
+
+    //! Read the layer_prop element.
+    void readLayerProp(QXmlStreamReader *rs);
+
+    //! Read the design element.
+    void readDesign(QXmlStreamReader *rs);
+
+    //! Read the lattice vectors in a lat_vec element.
+    void readLatVec(QXmlStreamReader *rs);
+
+    //! Read the items of a layer, recursing into aggregates.
+    void readLayerItems(QXmlStreamReader *rs, int layer, int aggregate);
+
+    //! Read a single DB.
+    void readDB(QXmlStreamReader *rs, int layer, int aggregate);
+
+    //! Read a single electrode.
+    void readElectrode(QXmlStreamReader *rs, int layer);
+
+    //! Read an item element the model doesn't represent as an XML item.
+    void readXmlItem(QXmlStreamReader *rs, int layer);
+
+    //! Write the DBs and child aggregates belonging to the given aggregate
+    //! (-1 for top level) of the given layer.
+    void writeDBs(QXmlStreamWriter *ws, int layer, int aggregate,
+        const QVector<QVector<int>> &agg_dbs,
+        const QVector<QVector<int>> &agg_children) const;
+
+    //! Write a single DB.
+    void writeDB(QXmlStreamWriter *ws, int db_ind) const;
+
+    //! Write a single electrode.
+    void writeElectrode(QXmlStreamWriter *ws, int elec_ind) const;
+
+    //! Write an item kept as XML with its layer_id updated to layerID().
+    void writeXmlItem(QXmlStreamWriter *ws, int item_ind) const;
+
+    LatticeDef lat_def;
+    QVector<LayerRecord> layer_recs;
+    QVector<DBRecord> db_recs;
+    QVector<ElectrodeRecord> elec_recs;
+    QVector<AggregateRecord> agg_recs;
+    QVector<XmlItemRecord> xml_item_recs;
+    QVector<ItemRef> top_items;
+
+    QString file_purpose;
+    QList<QPair<QString,QString>> sim_params;
+    QRectF displayed_region;
+    qreal pixels_per_angstrom=-1;
+    QString fallback_lat_path;
+
+    // loading state: file layer order to model layer index, -1 to skip
+    QVector<int> layer_load_order;
+  };
+
+} // end of comp namespace
+
+#endif
@@ -0,0 +1,174 @@
+// @file:     job_archive.cc
+// @author:   Samuel
+// @created:  2020.06.26
+// @license:  GNU LGPL v3
+//
+// @desc:     JobArchive implementation
+
+#include "job_archive.h"
+
+#include <fstream>
+#include <libs/zipper/zipper/unzipper.h>
+
+using namespace comp;
+
+JobArchive::JobArchive(const QString &archive_path, const QString &extract_root)
+  : archive_path(archive_path), extract_root(extract_root)
+{
+  // zipper reports failures to open an archive with exceptions
+  try {
+    unzipper.reset(new zipper::Unzipper(archive_path.toStdString()));
+    for (const zipper::ZipEntry &entry : unzipper->entries()) {
+      QString name = QString::fromStdString(entry.name);
+      if (name.endsWith("/"))
+        continue;   // directory entry
+      if (!isSafeEntryName(name)) {
+        qWarning() << QObject::tr("Ignoring unsafe entry %1 in job archive %2")
+          .arg(name).arg(archive_path);
+        continue;
+      }
+      entries.insert(name, static_cast<qint64>(entry.uncompressedSize));
+      // the shallowest manifest belongs to the job
+      if ((name == "manifest.xml" || name.endsWith("/manifest.xml"))
+          && (manifest_entry.isEmpty() || name.count("/") < manifest_entry.count("/")))
+        manifest_entry = name;
+    }
+  } catch (const std::exception &e) {
+    qWarning() << QObject::tr("Unable to open job archive %1: %2")
+      .arg(archive_path).arg(e.what());
+    unzipper.reset();
+    entries.clear();
+    manifest_entry.clear();
+  }
+  entry_prefix = manifest_entry.left(manifest_entry.lastIndexOf("/") + 1);
+}
+
+JobArchive::~JobArchive()
+{
+  if (unzipper)
+    unzipper->close();
+}
+
+bool JobArchive::read(const QString &local_path, QByteArray &data) const
+{
+  QFile file(local_path);
+  if (file.exists()) {
+    if (!file.open(QFile::ReadOnly))
+      return false;
+    data = file.readAll();
+    return true;
+  }
+
+  QString entry = entryName(local_path);
+  if (!entries.contains(entry) || !unzipper)
+    return false;
+  if (entries.value(entry) > max_read_bytes) {
+    qWarning() << QObject::tr("Refusing to read %1 from job archive %2 into memory, "
+        "the entry is too large").arg(entry).arg(archive_path);
+    return false;
+  }
+  QMutexLocker locker(&unzipper_mutex);
+  try {
+    std::vector<unsigned char> buf;
+    if (!unzipper->extractEntryToMemory(entry.toStdString(), buf))
+      return false;
+    data = QByteArray(reinterpret_cast<const char*>(buf.data()), static_cast<int>(buf.size()));
+  } catch (const std::exception &e) {
+    qWarning() << QObject::tr("Unable to read %1 from job archive %2: %3")
+      .arg(entry).arg(archive_path).arg(e.what());
+    return false;
+  }
+  return true;
+}
+
+QIODevice *JobArchive::open(const QString &local_path, QIODevice::OpenMode mode) const
+{
+  if (!QFileInfo(local_path).exists()) {
+    QString entry = entryName(local_path);
+    if (!entries.contains(entry))
+      return nullptr;
+    if (entries.value(entry) <= max_read_bytes) {
+      QByteArray data;
+      if (!read(local_path, data))
+        return nullptr;
+      QBuffer *buffer = new QBuffer();
+      buffer->setData(data);
+      buffer->open(mode);
+      return buffer;
+    }
+    if (!extract(local_path))
+      return nullptr;
+  }
+
+  QFile *file = new QFile(local_path);
+  if (!file->open(mode)) {
+    delete file;
+    return nullptr;
+  }
+  return file;
+}
+
+bool JobArchive::extract(const QString &local_path) const
+{
+  if (QFileInfo(local_path).exists())
+    return true;
+
+  QString entry = entryName(local_path);
+  if (!entries.contains(entry) || !unzipper)
+    return false;
+  QDir().mkpath(QFileInfo(local_path).absolutePath());
+
+  // stream to a temporary file first so that an interrupted extraction isn't
+  // mistaken for an extracted file
+  QString write_path = local_path + ".extracting";
+  bool success;
+  {
+    std::ofstream file(write_path.toStdString(), std::ios::binary);
+    if (!file.is_open()) {
+      qWarning() << QObject::tr("Unable to extract %1").arg(local_path);
+      return false;
+    }
+    QMutexLocker locker(&unzipper_mutex);
+    try {
+      success = unzipper->extractEntryToStream(entry.toStdString(), file);
+    } catch (const std::exception &e) {
+      qWarning() << QObject::tr("Unable to extract %1 from job archive %2: %3")
+        .arg(entry).arg(archive_path).arg(e.what());
+      success = false;
+    }
+    file.close();
+    success = success && !file.fail();
+  }
+  if (!success || !QFile::rename(write_path, local_path)) {
+    QFile::remove(write_path);
+    return false;
+  }
+  return true;
+}
+
+bool JobArchive::extractDir(const QString &local_dir) const
+{
+  QString rel_dir = QDir(extract_root).relativeFilePath(local_dir);
+  if (rel_dir == ".." || rel_dir.startsWith("../") || QDir::isAbsolutePath(rel_dir))
+    return false;
+  QString dir_prefix = rel_dir == "." ? entry_prefix : entry_prefix + rel_dir + "/";
+  bool success = true;
+  for (const QString &entry : entries.keys()) {
+    if (entry.startsWith(dir_prefix))
+      success &= extract(QDir(extract_root).absoluteFilePath(entry.mid(entry_prefix.length())));
+  }
+  return success;
+}
+
+bool JobArchive::isSafeEntryName(const QString &name)
+{
+  // reject absolute paths, drive letters, backslashes and any "." or ".."
+  // components, which also covers names that don't survive cleaning
+  if (name.isEmpty() || name.startsWith("/") || name.contains("\\")
+      || name.contains(":") || QDir::cleanPath(name) != name)
+    return false;
+  for (const QString &part : name.split("/"))
+    if (part == "." || part == "..")
+      return false;
+  return true;
+}
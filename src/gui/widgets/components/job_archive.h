@@ -0,0 +1,107 @@
+/** @file:     job_archive.h
+ *  @author:   Samuel
+ *  @created:  2020.06.26
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Read access to exported SimJob archives without extracting them.
+ */
+
+#ifndef _COMP_JOB_ARCHIVE_H_
+#define _COMP_JOB_ARCHIVE_H_
+
+#include <QtCore>
+#include <memory>
+
+namespace zipper{
+  class Unzipper;
+}
+
+namespace comp{
+
+  //! An exported SimJob archive (*.sqjx.zip) read in place. Files in the
+  //! archive are addressed by the local path they would have if the job
+  //! directory, i.e. the directory containing manifest.xml, was extracted to
+  //! the extraction root. Nothing is extracted unless extract() is called,
+  //! e.g. for files which must be passed to other components by path.
+  //!
+  //! The archive is kept open for the lifetime of the instance. Entries whose
+  //! names aren't clean relative paths are ignored so that nothing can be
+  //! extracted outside of the extraction root.
+  class JobArchive
+  {
+  public:
+
+    //! Entries larger than this are extracted to disk rather than read into
+    //! memory.
+    static const qint64 max_read_bytes = 64 * 1024 * 1024;
+
+    //! Open the archive and locate its manifest. The extraction root is only
+    //! created once a file is extracted.
+    JobArchive(const QString &archive_path, const QString &extract_root);
+
+    //! Destructor, closes the archive.
+    ~JobArchive();
+
+    //! Return whether the archive could be read and contains a manifest.
+    bool isValid() const {return !manifest_entry.isEmpty();}
+
+    //! Return the local path of the manifest.
+    QString manifestPath() const {return QDir(extract_root).absoluteFilePath("manifest.xml");}
+
+    //! Return whether the archive contains the file at the local path.
+    bool contains(const QString &local_path) const
+    {
+      return entries.contains(entryName(local_path));
+    }
+
+    //! Read the file at the local path from the archive, or from disk if it
+    //! has already been extracted. Entries larger than max_read_bytes are
+    //! refused, use open() for those. Returns whether successful.
+    bool read(const QString &local_path, QByteArray &data) const;
+
+    //! Open the file at the local path for reading. Small entries are read
+    //! into a buffer, larger ones are extracted and read from disk. Returns
+    //! a device owned by the caller or a null pointer on failure.
+    QIODevice *open(const QString &local_path,
+                    QIODevice::OpenMode mode=QIODevice::ReadOnly) const;
+
+    //! Extract the file at the local path unless it already exists. The file
+    //! is streamed to disk without being held in memory. Returns whether the
+    //! file exists afterwards.
+    bool extract(const QString &local_path) const;
+
+    //! Extract all files below the local directory which don't exist yet.
+    //! Returns whether all of them could be extracted.
+    bool extractDir(const QString &local_dir) const;
+
+    //! Return whether the entry name is a clean relative path, which can't
+    //! be extracted to outside of the extraction root.
+    static bool isSafeEntryName(const QString &name);
+
+  private:
+
+    //! Return the archive entry name of the local path, an empty string if
+    //! the path is outside of the extraction root.
+    QString entryName(const QString &local_path) const
+    {
+      QString rel_path = QDir(extract_root).relativeFilePath(local_path);
+      if (rel_path == ".." || rel_path.startsWith("../") || QDir::isAbsolutePath(rel_path))
+        return QString();
+      return entry_prefix + rel_path;
+    }
+
+    QString archive_path;       // path to the archive
+    QString extract_root;       // local directory corresponding to the job directory
+    QString manifest_entry;     // entry name of the manifest, empty if not found
+    QString entry_prefix;       // entry name prefix of the job directory
+    QHash<QString, qint64> entries;   // uncompressed sizes of all file entries
+
+    mutable QMutex unzipper_mutex;    // entries may be read from worker threads
+    std::unique_ptr<zipper::Unzipper> unzipper; // the open archive
+
+    Q_DISABLE_COPY(JobArchive)
+  };
+
+} // end of comp namespace
+
+#endif
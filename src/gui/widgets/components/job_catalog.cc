@@ -0,0 +1,429 @@
+// @file:     job_catalog.cc
+// @author:   Samuel
+// @created:  2020.06.28
+// @license:  GNU LGPL v3
+//
+// @desc:     JobCatalog implementation
+
+#include "job_catalog.h"
+#include "sim_job.h"
+#include "result_cache.h"
+#include "settings/settings.h"
+
+#include <QtConcurrent>
+#include <algorithm>
+
+using namespace comp;
+
+namespace {
+
+  QJsonObject resourceUsageToJson(const ResourceUsage &usage)
+  {
+    QJsonObject obj;
+    obj["wall_ms"] = usage.wall_ms;
+    obj["user_cpu_s"] = usage.user_cpu_s;
+    obj["sys_cpu_s"] = usage.sys_cpu_s;
+    obj["peak_rss_kb"] = usage.peak_rss_kb;
+    obj["read_bytes"] = usage.read_bytes;
+    obj["written_bytes"] = usage.written_bytes;
+    obj["process_count"] = usage.process_count;
+    obj["peak_process_count"] = usage.peak_process_count;
+    return obj;
+  }
+
+  ResourceUsage resourceUsageFromJson(const QJsonObject &obj)
+  {
+    ResourceUsage usage;
+    usage.wall_ms = static_cast<qint64>(obj["wall_ms"].toDouble(-1));
+    usage.user_cpu_s = obj["user_cpu_s"].toDouble(-1);
+    usage.sys_cpu_s = obj["sys_cpu_s"].toDouble(-1);
+    usage.peak_rss_kb = static_cast<qint64>(obj["peak_rss_kb"].toDouble(-1));
+    usage.read_bytes = static_cast<qint64>(obj["read_bytes"].toDouble(-1));
+    usage.written_bytes = static_cast<qint64>(obj["written_bytes"].toDouble(-1));
+    usage.process_count = obj["process_count"].toInt(-1);
+    usage.peak_process_count = obj["peak_process_count"].toInt(-1);
+    return usage;
+  }
+
+  // Return the total size of the files below the directory.
+  qint64 dirBytes(const QString &dir_path)
+  {
+    qint64 bytes = 0;
+    QDirIterator it(dir_path, QDir::Files | QDir::Hidden,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+      it.next();
+      bytes += it.fileInfo().size();
+    }
+    return bytes;
+  }
+
+}
+
+QJsonObject JobCatalog::JobRecord::toJson() const
+{
+  QJsonObject obj;
+  obj["job_dir"] = job_dir_path;
+  obj["name"] = name;
+  obj["state"] = state;
+  obj["time_start"] = start_time.toString(Qt::ISODate);
+  obj["time_end"] = end_time.toString(Qt::ISODate);
+  obj["dir_bytes"] = dir_bytes;
+  if (imported)
+    obj["imported"] = true;
+
+  QJsonArray steps_arr;
+  for (const StepRecord &step : steps) {
+    QJsonObject step_obj;
+    step_obj["engine_name"] = step.engine_name;
+    step_obj["engine_version"] = step.engine_version;
+    QJsonObject params_obj;
+    for (auto it = step.sim_params.cbegin(); it != step.sim_params.cend(); ++it)
+      params_obj[it.key()] = it.value();
+    step_obj["sim_params"] = params_obj;
+    step_obj["problem_hash"] = step.problem_hash;
+    step_obj["design_hash"] = step.design_hash;
+    step_obj["problem_path"] = step.problem_path;
+    step_obj["result_path"] = step.result_path;
+    step_obj["result_types"] = QJsonArray::fromStringList(step.result_types);
+    step_obj["resources"] = resourceUsageToJson(step.res_usage);
+    if (step.has_energy)
+      step_obj["min_energy"] = step.min_energy;
+    steps_arr.append(step_obj);
+  }
+  obj["steps"] = steps_arr;
+  return obj;
+}
+
+JobCatalog::JobRecord JobCatalog::JobRecord::fromJson(const QJsonObject &obj)
+{
+  JobRecord job_record;
+  job_record.job_dir_path = obj["job_dir"].toString();
+  job_record.name = obj["name"].toString();
+  job_record.state = obj["state"].toString();
+  job_record.start_time = QDateTime::fromString(obj["time_start"].toString(), Qt::ISODate);
+  job_record.end_time = QDateTime::fromString(obj["time_end"].toString(), Qt::ISODate);
+  job_record.dir_bytes = static_cast<qint64>(obj["dir_bytes"].toDouble());
+  job_record.imported = obj["imported"].toBool();
+
+  for (const QJsonValue &step_val : obj["steps"].toArray()) {
+    QJsonObject step_obj = step_val.toObject();
+    StepRecord step;
+    step.engine_name = step_obj["engine_name"].toString();
+    step.engine_version = step_obj["engine_version"].toString();
+    QJsonObject params_obj = step_obj["sim_params"].toObject();
+    for (auto it = params_obj.constBegin(); it != params_obj.constEnd(); ++it)
+      step.sim_params.insert(it.key(), it.value().toString());
+    step.problem_hash = step_obj["problem_hash"].toString();
+    step.design_hash = step_obj["design_hash"].toString();
+    step.problem_path = step_obj["problem_path"].toString();
+    step.result_path = step_obj["result_path"].toString();
+    for (const QJsonValue &type_val : step_obj["result_types"].toArray())
+      step.result_types.append(type_val.toString());
+    step.res_usage = resourceUsageFromJson(step_obj["resources"].toObject());
+    step.has_energy = step_obj.contains("min_energy");
+    step.min_energy = step_obj["min_energy"].toDouble();
+    job_record.steps.append(step);
+  }
+  return job_record;
+}
+
+JobCatalog *JobCatalog::instance()
+{
+  static JobCatalog catalog(catalogPath());
+  return &catalog;
+}
+
+JobCatalog::JobCatalog(const QString &t_catalog_path)
+  : catalog_path(t_catalog_path)
+{
+  QFile file(catalog_path);
+  if (!file.exists())
+    return;
+  if (!file.open(QFile::ReadOnly | QFile::Text)) {
+    qWarning() << QObject::tr("Unable to read job catalog %1: %2")
+      .arg(catalog_path).arg(file.errorString());
+    return;
+  }
+
+  // later records of a job directory replace earlier ones
+  int record_count = 0;
+  while (!file.atEnd()) {
+    QByteArray line = file.readLine().trimmed();
+    if (line.isEmpty())
+      continue;
+    QJsonObject obj = QJsonDocument::fromJson(line).object();
+    QString job_dir_path = obj["job_dir"].toString();
+    if (job_dir_path.isEmpty()) {
+      // e.g. a line cut short by a crash
+      qWarning() << QObject::tr("Skipping unreadable job catalog record.");
+      continue;
+    }
+    record_count++;
+    unindex(job_dir_path);
+    if (!obj["removed"].toBool())
+      index(JobRecord::fromJson(obj));
+  }
+  superseded_count = record_count - job_records.size();
+  qDebug() << QObject::tr("Read %1 jobs from the job catalog.").arg(job_records.size());
+}
+
+void JobCatalog::record(SimJob *job)
+{
+  JobRecord job_record;
+  job_record.job_dir_path = job->runtimeTempPath();
+  job_record.name = job->name();
+  job_record.state = QVariant::fromValue(job->jobState()).toString();
+  job_record.imported = job->fromImport();
+  if (!job->jobSteps().isEmpty()) {
+    job_record.start_time = job->startTime();
+    job_record.end_time = job->endTime();
+  }
+
+  // reuse what the job doesn't know anymore from the previous record, the
+  // directory size is updated once it has been determined
+  JobRecord prev_record = job_records.value(job_record.job_dir_path);
+  job_record.dir_bytes = prev_record.dir_bytes;
+
+  for (JobStep *js : job->jobSteps()) {
+    StepRecord step;
+    step.engine_name = js->engineName();
+    step.engine_version = js->engineVersion();
+    step.sim_params = js->jobParameters();
+    step.problem_hash = js->problemHash();
+    step.problem_path = js->problemPath();
+    step.result_path = js->resultPath();
+    step.res_usage = js->resourceUsage();
+    step.design_hash = js->designHash();
+    int step_ind = job_record.steps.length();
+    const StepRecord *prev_step = (step_ind < prev_record.steps.length()
+        && prev_record.steps.at(step_ind).problem_path == step.problem_path)
+      ? &prev_record.steps.at(step_ind) : nullptr;
+    if (step.design_hash.isEmpty() && prev_step != nullptr)
+      step.design_hash = prev_step->design_hash;
+
+    if (js->jobStepState() == JobStep::FinishedNormally) {
+      auto&& type_enum = QMetaEnum::fromType<JobResult::ResultType>();
+      for (JobResult::ResultType type : js->resultTypes())
+        step.result_types.append(type_enum.valueToKey(type));
+
+      // lowest energy among configs which aren't known to be invalid, results
+      // aren't loaded just for this
+      if (prev_step != nullptr && prev_step->has_energy) {
+        step.has_energy = true;
+        step.min_energy = prev_step->min_energy;
+      } else if (js->resultsLoaded()
+          && js->resultTypes().contains(JobResult::ChargeConfigsResult)) {
+        ChargeConfigSet *configs = static_cast<ChargeConfigSet*>(
+            js->jobResults().value(JobResult::ChargeConfigsResult));
+        if (configs != nullptr) {
+          for (const ChargeConfigSet::ChargeConfig &config : configs->chargeConfigs()) {
+            if (config.is_valid == 0)
+              continue;
+            if (!step.has_energy || config.energy < step.min_energy)
+              step.min_energy = config.energy;
+            step.has_energy = true;
+          }
+        }
+      }
+    }
+    job_record.steps.append(step);
+  }
+
+  if (job_records.contains(job_record.job_dir_path))
+    superseded_count++;
+  unindex(job_record.job_dir_path);
+  index(job_record);
+  append(job_record.toJson());
+
+  if (job->jobState() != SimJob::Running)
+    updateDirBytes(job_record.job_dir_path);
+}
+
+void JobCatalog::forget(const QString &job_dir_path)
+{
+  if (!job_records.contains(job_dir_path))
+    return;
+  unindex(job_dir_path);
+  // the removal record and the record it removes are both superseded
+  superseded_count += 2;
+  QJsonObject obj;
+  obj["job_dir"] = job_dir_path;
+  obj["removed"] = true;
+  append(obj);
+}
+
+bool JobCatalog::lowestEnergyStep(const QString &design_hash,
+    QString *job_dir_path, int *step_ind) const
+{
+  bool found = false;
+  double min_energy = 0;
+  for (const QString &dir_path : design_jobs.values(design_hash)) {
+    const QList<StepRecord> &steps = job_records[dir_path].steps;
+    for (int i=0; i<steps.length(); i++) {
+      const StepRecord &step = steps.at(i);
+      if (step.design_hash != design_hash || !step.has_energy)
+        continue;
+      if (!found || step.min_energy < min_energy) {
+        found = true;
+        min_energy = step.min_energy;
+        *job_dir_path = dir_path;
+        *step_ind = i;
+      }
+    }
+  }
+  return found;
+}
+
+int JobCatalog::cleanUp(const QSet<QString> &in_use_dir_paths)
+{
+  ResultCache::removeStaleFiles();
+
+  qint64 quota_bytes = settings::AppSettings::instance()->get<int>(
+      "plugs/runtime_tmp_quota_mb") * 1024LL * 1024LL;
+  if (quota_bytes <= 0)
+    return 0;
+
+  // cached results are copies of job step results and count towards the quota
+  QFileInfoList cached_results = ResultCache::cachedResults();
+  qint64 used_bytes = 0;
+  for (const JobRecord &job_record : job_records)
+    used_bytes += job_record.dir_bytes;
+  for (const QFileInfo &cached_result : cached_results)
+    used_bytes += cached_result.size();
+  if (used_bytes <= quota_bytes)
+    return 0;
+
+  // oldest first, running and imported jobs are never removed and neither is
+  // anything outside of the runtime temp root, e.g. the directory an archive
+  // was extracted to by the user
+  QString root_path = QDir(settings::AppSettings::instance()->getPath(
+        "plugs/runtime_tmp_root_path")).canonicalPath();
+  QList<JobRecord> candidates;
+  for (const JobRecord &job_record : job_records) {
+    if (in_use_dir_paths.contains(job_record.job_dir_path) || job_record.imported
+        || job_record.state == QVariant::fromValue(SimJob::Running).toString())
+      continue;
+    QString dir_path = QDir(job_record.job_dir_path).canonicalPath();
+    if (root_path.isEmpty() || (!dir_path.isEmpty()
+          && !dir_path.startsWith(root_path + "/")))
+      continue;
+    candidates.append(job_record);
+  }
+  std::sort(candidates.begin(), candidates.end(),
+      [](const JobRecord &a, const JobRecord &b) {return a.end_time < b.end_time;});
+
+  // job directories and cached results are removed in the order they were
+  // finished and stored respectively
+  int removed_count = 0;
+  int job_ind = 0, cache_ind = 0;
+  while (used_bytes > quota_bytes
+      && (job_ind < candidates.size() || cache_ind < cached_results.size())) {
+    if (job_ind >= candidates.size() || (cache_ind < cached_results.size()
+          && cached_results.at(cache_ind).lastModified() < candidates.at(job_ind).end_time)) {
+      const QFileInfo &cached_result = cached_results.at(cache_ind++);
+      if (QFile::remove(cached_result.absoluteFilePath()))
+        used_bytes -= cached_result.size();
+      continue;
+    }
+
+    const JobRecord &job_record = candidates.at(job_ind++);
+    qDebug() << QObject::tr("Removing job directory %1 (%2 kiB) to meet the "
+        "runtime temp quota.").arg(job_record.job_dir_path)
+      .arg(job_record.dir_bytes / 1024);
+    QDir job_dir(job_record.job_dir_path);
+    if (job_dir.exists() && !job_dir.removeRecursively()) {
+      qWarning() << QObject::tr("Unable to remove job directory %1")
+        .arg(job_record.job_dir_path);
+      continue;
+    }
+    used_bytes -= job_record.dir_bytes;
+    forget(job_record.job_dir_path);
+    removed_count++;
+  }
+  return removed_count;
+}
+
+QString JobCatalog::catalogPath()
+{
+  return settings::AppSettings::instance()->getPath("plugs/job_catalog_path");
+}
+
+
+// PRIVATE
+
+void JobCatalog::index(const JobRecord &job_record)
+{
+  job_records.insert(job_record.job_dir_path, job_record);
+  QSet<QString> design_hashes;
+  for (const StepRecord &step : job_record.steps)
+    if (!step.design_hash.isEmpty())
+      design_hashes.insert(step.design_hash);
+  for (const QString &design_hash : design_hashes)
+    design_jobs.insert(design_hash, job_record.job_dir_path);
+}
+
+void JobCatalog::unindex(const QString &job_dir_path)
+{
+  if (!job_records.contains(job_dir_path))
+    return;
+  for (const StepRecord &step : job_records.take(job_dir_path).steps)
+    design_jobs.remove(step.design_hash, job_dir_path);
+}
+
+void JobCatalog::updateDirBytes(const QString &job_dir_path)
+{
+  QFutureWatcher<qint64> *watcher = new QFutureWatcher<qint64>();
+  QObject::connect(watcher, &QFutureWatcher<qint64>::finished,
+      [this, watcher, job_dir_path]()
+      {
+        qint64 bytes = watcher->result();
+        watcher->deleteLater();
+        // the job might have been forgotten in the meantime
+        if (!job_records.contains(job_dir_path)
+            || job_records[job_dir_path].dir_bytes == bytes)
+          return;
+        job_records[job_dir_path].dir_bytes = bytes;
+        superseded_count++;
+        append(job_records[job_dir_path].toJson());
+      });
+  watcher->setFuture(QtConcurrent::run(dirBytes, job_dir_path));
+}
+
+void JobCatalog::append(const QJsonObject &obj)
+{
+  if (superseded_count > 100 && superseded_count > job_records.size()) {
+    compact();
+    return;
+  }
+
+  QString path = catalog_path;
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QFile file(path);
+  if (!file.open(QFile::WriteOnly | QFile::Append | QFile::Text)) {
+    qWarning() << QObject::tr("Unable to write job catalog %1: %2")
+      .arg(path).arg(file.errorString());
+    return;
+  }
+  file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n");
+}
+
+void JobCatalog::compact()
+{
+  // write to a temporary file first so that a crash never loses the catalog
+  QString path = catalog_path;
+  QString tmp_path = path + ".writing";
+  QDir().mkpath(QFileInfo(path).absolutePath());
+  QFile file(tmp_path);
+  if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+    qWarning() << QObject::tr("Unable to write job catalog %1: %2")
+      .arg(tmp_path).arg(file.errorString());
+    return;
+  }
+  for (const JobRecord &job_record : job_records)
+    file.write(QJsonDocument(job_record.toJson()).toJson(QJsonDocument::Compact) + "\n");
+  file.close();
+  QFile::remove(path);
+  if (QFile::rename(tmp_path, path))
+    superseded_count = 0;
+}
@@ -0,0 +1,129 @@
+/** @file:     job_catalog.h
+ *  @author:   Samuel
+ *  @created:  2020.06.28
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Persistent catalog of SimJobs across sessions.
+ */
+
+#ifndef _COMP_JOB_CATALOG_H_
+#define _COMP_JOB_CATALOG_H_
+
+#include <QtCore>
+#include "resource_monitor.h"
+
+namespace comp{
+
+  class SimJob;
+
+  //! Catalog of all jobs run by SiQAD, kept across sessions in an append-only
+  //! index file of one JSON record per line. A job is recorded again whenever
+  //! its state changes and the last record of a job directory wins, so the
+  //! catalog is read once at startup without scanning job directories. The
+  //! file is compacted when superseded records outnumber the current ones.
+  class JobCatalog
+  {
+  public:
+
+    //! Summary of a job step.
+    struct StepRecord
+    {
+      QString engine_name;
+      QString engine_version;
+      QMap<QString, QString> sim_params;
+      QString problem_hash;         // canonical problem hash, see ResultCache
+      QString design_hash;          // hash of the design only, see ResultCache
+      QString problem_path;
+      QString result_path;
+      QStringList result_types;     // names of JobResult::ResultType
+      ResourceUsage res_usage;
+      bool has_energy=false;        // whether min_energy was recorded
+      double min_energy=0;          // lowest energy of valid charge configs
+    };
+
+    //! Summary of a job.
+    struct JobRecord
+    {
+      //! Convert to and from a JSON record.
+      QJsonObject toJson() const;
+      static JobRecord fromJson(const QJsonObject &obj);
+
+      QString job_dir_path;         // identifies the job
+      QString name;
+      QString state;                // name of SimJob::JobState
+      QDateTime start_time;
+      QDateTime end_time;
+      qint64 dir_bytes=0;           // size of the job directory when recorded
+      bool imported=false;          // the job directory belongs to an imported job
+      QList<StepRecord> steps;
+    };
+
+    //! Return the catalog instance, reading the index file on first use.
+    static JobCatalog *instance();
+
+    //! Constructor, reads the index file at the given path. SiQAD uses the
+    //! instance() at catalogPath(), other catalogs are meant for testing.
+    JobCatalog(const QString &t_catalog_path);
+
+    //! Record the current state of the job, replacing its previous record.
+    //! Hashes and energies are taken from the job steps as far as they are
+    //! known and from the previous record otherwise. The size of the job
+    //! directory is determined in the background and recorded once known.
+    void record(SimJob *job);
+
+    //! Remove the job directory from the catalog.
+    void forget(const QString &job_dir_path);
+
+    //! Return the records of all catalogued jobs.
+    QList<JobRecord> jobs() const {return job_records.values();}
+
+    //! Return the record of the job directory, or an empty record if it isn't
+    //! catalogued.
+    JobRecord job(const QString &job_dir_path) const
+    {
+      return job_records.value(job_dir_path);
+    }
+
+    //! Find the step with the lowest energy among all runs of the design with
+    //! the given hash. Returns whether any was found, in which case the job
+    //! directory and step index are written to the provided pointers.
+    bool lowestEnergyStep(const QString &design_hash, QString *job_dir_path,
+                          int *step_ind) const;
+
+    //! Delete the directories of the oldest finished jobs and the oldest
+    //! cached results until both together fit into the runtime temp quota of
+    //! the application settings. Only directories inside the runtime temp root
+    //! are deleted, directories of jobs in use and of imported jobs are kept.
+    //! Returns the number of deleted job directories.
+    int cleanUp(const QSet<QString> &in_use_dir_paths);
+
+    //! Return the index file path.
+    static QString catalogPath();
+
+  private:
+
+    //! Add the record to the in-memory index.
+    void index(const JobRecord &job_record);
+
+    //! Remove the job directory from the in-memory index.
+    void unindex(const QString &job_dir_path);
+
+    //! Determine the size of the job directory on a worker thread and update
+    //! its record with it.
+    void updateDirBytes(const QString &job_dir_path);
+
+    //! Append a JSON record to the index file, compacting it if worthwhile.
+    void append(const QJsonObject &obj);
+
+    //! Rewrite the index file with only the current records.
+    void compact();
+
+    QString catalog_path;                       // path of the index file
+    QHash<QString, JobRecord> job_records;      // current record of each job directory
+    QMultiHash<QString, QString> design_jobs;   // job directories of each design hash
+    int superseded_count=0;                     // records in the file which are no longer current
+  };
+
+} // end of comp namespace
+
+#endif
@@ -0,0 +1,133 @@
+// @file:     job_export.cc
+// @author:   Samuel
+// @created:  2020.06.27
+// @license:  GNU LGPL v3
+//
+// @desc:     JobExport implementation
+
+#include "job_export.h"
+#include "settings/settings.h"
+
+#include <fstream>
+#include <libs/zipper/zipper/zipper.h>
+
+using namespace comp;
+
+JobExport::Options JobExport::Options::fromSettings()
+{
+  settings::AppSettings *s = settings::AppSettings::instance();
+  Options options;
+  QMetaEnum comp_enum = QMetaEnum::fromType<Compression>();
+  bool ok;
+  int comp_val = comp_enum.keyToValue(
+      s->get<QString>("plugs/export_compression").toLatin1(), &ok);
+  if (ok)
+    options.compression = static_cast<Compression>(comp_val);
+  options.include_filters = s->get<QString>("plugs/export_include_filters")
+    .split(" ", QString::SkipEmptyParts);
+  options.exclude_filters = s->get<QString>("plugs/export_exclude_filters")
+    .split(" ", QString::SkipEmptyParts);
+  return options;
+}
+
+JobExport::JobExport(const QString &job_dir_path, const QString &out_path,
+                     const Options &options, QObject *parent)
+  : QObject(parent), job_dir_path(job_dir_path), out_path(out_path),
+    options(options), cancel_requested(0)
+{
+  watcher = new QFutureWatcher<bool>(this);
+  connect(watcher, &QFutureWatcher<bool>::finished,
+          [this]()
+          {
+            bool cancelled = cancel_requested.load();
+            emit sig_finished(watcher->result() && !cancelled, cancelled);
+          });
+}
+
+JobExport::~JobExport()
+{
+  cancel();
+  watcher->waitForFinished();
+}
+
+void JobExport::start()
+{
+  if (watcher->isRunning())
+    return;
+  cancel_requested.store(0);
+  watcher->setFuture(QtConcurrent::run(this, &JobExport::writeArchive));
+}
+
+bool JobExport::passesFilters(const QString &rel_path, const Options &options)
+{
+  // filters match either the file name or the path relative to the job
+  // directory, e.g. "*.tmp" or "step_0/checkpoint*"
+  auto matches = [&rel_path](const QStringList &filters)
+  {
+    return QDir::match(filters, rel_path)
+      || QDir::match(filters, QFileInfo(rel_path).fileName());
+  };
+  if (!options.include_filters.isEmpty() && !matches(options.include_filters))
+    return false;
+  return !matches(options.exclude_filters);
+}
+
+bool JobExport::writeArchive()
+{
+  // collect the files first so that progress can be reported
+  QDir job_dir(job_dir_path);
+  QStringList rel_paths;
+  QDirIterator it(job_dir_path, QDir::Files | QDir::Hidden,
+                  QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    QString rel_path = job_dir.relativeFilePath(it.next());
+    // the manifest is needed to import the archive
+    if (rel_path == "manifest.xml" || passesFilters(rel_path, options))
+      rel_paths.append(rel_path);
+  }
+
+  zipper::Zipper::zipFlags flags = zipper::Zipper::Better;
+  switch (options.compression) {
+    case Store:
+      flags = zipper::Zipper::Store;
+      break;
+    case Faster:
+      flags = zipper::Zipper::Faster;
+      break;
+    default:
+      break;
+  }
+
+  // entries are placed in a directory named after the job directory like
+  // zipping the directory itself would do
+  bool success = true;
+  try {
+    zipper::Zipper zipper(out_path.toStdString());
+    for (int i=0; i<rel_paths.length(); i++) {
+      if (cancel_requested.load()) {
+        success = false;
+        break;
+      }
+      std::ifstream file(job_dir.absoluteFilePath(rel_paths.at(i)).toStdString(),
+                         std::ios::binary);
+      QString entry_name = job_dir.dirName() + "/" + rel_paths.at(i);
+      if (!file.is_open() || !zipper.add(file, entry_name.toStdString(), flags)) {
+        qWarning() << tr("Unable to add %1 to job archive %2")
+          .arg(rel_paths.at(i)).arg(out_path);
+        success = false;
+        break;
+      }
+      emit sig_progress(i+1, rel_paths.length());
+    }
+    zipper.close();
+  } catch (const std::exception &e) {
+    qWarning() << tr("Unable to write job archive %1: %2").arg(out_path)
+      .arg(e.what());
+    success = false;
+  }
+
+  // don't leave incomplete archives behind
+  if (!success)
+    QFile::remove(out_path);
+  return success;
+}
@@ -0,0 +1,87 @@
+/** @file:     job_export.h
+ *  @author:   Samuel
+ *  @created:  2020.06.27
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Export of SimJob directories into archives on a worker thread.
+ */
+
+#ifndef _COMP_JOB_EXPORT_H_
+#define _COMP_JOB_EXPORT_H_
+
+#include <QtCore>
+#include <QtConcurrent>
+
+namespace comp{
+
+  //! Compresses a job directory into an archive (*.sqjx.zip) on a worker
+  //! thread, reporting progress per file and stopping early when cancelled.
+  //! Each export runs as its own task on the global thread pool, so several
+  //! jobs can be exported at the same time.
+  class JobExport : public QObject
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Compression level of the archive entries.
+    enum Compression{Store, Faster, Better};
+    Q_ENUM(Compression)
+
+    //! Options determining what goes into the archive and how.
+    struct Options
+    {
+      //! Return the options in the application settings.
+      static Options fromSettings();
+
+      Compression compression=Better;
+      QStringList include_filters;  // wildcards of files to include, all files if empty
+      QStringList exclude_filters;  // wildcards of files to leave out
+    };
+
+    //! Constructor. The export starts when start() is called.
+    JobExport(const QString &job_dir_path, const QString &out_path,
+              const Options &options, QObject *parent=nullptr);
+
+    //! Destructor, cancels a running export and waits for it to stop.
+    ~JobExport();
+
+    //! Start the export on a worker thread.
+    void start();
+
+    //! Request the export to stop. The incomplete archive is removed.
+    void cancel() {cancel_requested.store(1);}
+
+    //! Return whether the export is running.
+    bool isRunning() const {return watcher->isRunning();}
+
+    //! Return the output archive path.
+    QString outPath() const {return out_path;}
+
+    //! Return whether the file at the path relative to the job directory
+    //! passes the include and exclude filters of the options.
+    static bool passesFilters(const QString &rel_path, const Options &options);
+
+  signals:
+
+    //! Emitted from the worker thread after each archived file.
+    void sig_progress(int files_done, int files_total);
+
+    //! Emitted once the export has ended. Cancelled exports are unsuccessful.
+    void sig_finished(bool success, bool cancelled);
+
+  private:
+
+    //! Write the archive, run on the worker thread. Returns whether successful.
+    bool writeArchive();
+
+    QString job_dir_path;         // job directory to archive
+    QString out_path;             // output archive path
+    Options options;              // export options
+    QAtomicInt cancel_requested;  // set to stop the worker
+    QFutureWatcher<bool> *watcher;  // watches the worker
+  };
+
+} // end of comp namespace
+
+#endif
@@ -34,6 +34,12 @@ namespace comp{
     //! Return the DB locations.
     QList<QPointF> locations() const {return db_locs;}
 
+    //! Return an estimate of the memory held by this result in bytes.
+    qint64 memoryUsage() const override
+    {
+      return sizeof(*this) + db_locs.size() * (sizeof(void*) + sizeof(QPointF));
+    }
+
 
   private:
 
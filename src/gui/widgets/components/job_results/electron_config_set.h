@@ -130,6 +130,18 @@ namespace comp{
     //! index, return -1.
     static int lowestPhysicallyValidInd(const QList<ChargeConfig> &charge_configs);
 
+    //! Return an estimate of the memory held by this result in bytes.
+    qint64 memoryUsage() const override
+    {
+      // map nodes hold the config struct, the config lists hold one pointer
+      // sized slot per DB
+      const qint64 node_bytes = sizeof(ChargeConfig) + 3 * sizeof(void*);
+      qint64 bytes = sizeof(*this) + phys_locs.size() * (sizeof(void*) + sizeof(QPointF));
+      for (const ChargeConfig &charge_config : charge_configs)
+        bytes += node_bytes + charge_config.config.size() * sizeof(void*);
+      return bytes;
+    }
+
   private:
 
     //QList<ChargeConfig> charge_configs;   // charge configurations
@@ -26,6 +26,7 @@ namespace comp{
     //! The result type of this job result set.
     enum ResultType{UndefinedResult, DBLocationsResult, ChargeConfigsResult, 
       PotentialLandscapeResult, SQCommandsResult};
+    Q_ENUM(ResultType)
     
     //! Constructor.
     JobResult(ResultType result_type=UndefinedResult);
@@ -36,6 +37,10 @@ namespace comp{
     //! Return the result type.
     ResultType resultType() {return result_type;}
 
+    //! Return an estimate of the memory held by this result in bytes, used
+    //! to keep loaded results within the result memory budget.
+    virtual qint64 memoryUsage() const {return sizeof(*this);}
+
 
   private:
 
@@ -38,9 +38,9 @@ PotentialLandscape::PotentialLandscape(QXmlStreamReader *rs, const QString &resu
   // TODO future proper implementation should have PoisSolver pass paths through
   // SiQADConn
   QDir result_dir(result_dir_path);
-  QString static_plot_file_name = "SiAirBoundary000.png";
-  QString animation_file_name = "SiAirBoundary.gif";
-  QString plot_legend_file_name = "SiAirPlot.png";
+  QString static_plot_file_name = plotFileNames().at(0);
+  QString animation_file_name = plotFileNames().at(1);
+  QString plot_legend_file_name = plotFileNames().at(2);
   if (result_dir.exists(static_plot_file_name))
     static_plot_path = result_dir.absoluteFilePath(static_plot_file_name);
   if (result_dir.exists(animation_file_name))
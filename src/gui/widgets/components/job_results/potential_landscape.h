@@ -48,6 +48,21 @@ namespace comp{
     //! Return the path to the plot legend.
     QString plotLegendPath() {return plot_legend_path;}
 
+    //! Return the file names of the plots looked for next to the result file.
+    static QStringList plotFileNames()
+    {
+      return {"SiAirBoundary000.png", "SiAirBoundary.gif", "SiAirPlot.png"};
+    }
+
+    //! Return an estimate of the memory held by this result in bytes.
+    qint64 memoryUsage() const override
+    {
+      qint64 bytes = sizeof(*this);
+      for (const QVector<float> &vals : potential_vals)
+        bytes += sizeof(void*) + sizeof(QArrayData) + vals.size() * sizeof(float);
+      return bytes;
+    }
+
 
   private:
 
@@ -38,6 +38,15 @@ namespace comp{
     //! Return the SQCommands stored in this set.
     QStringList sqCommands() {return sq_commands;}
 
+    //! Return an estimate of the memory held by this result in bytes.
+    qint64 memoryUsage() const override
+    {
+      qint64 bytes = sizeof(*this);
+      for (const QString &command : sq_commands)
+        bytes += sizeof(void*) + command.size() * sizeof(QChar);
+      return bytes;
+    }
+
   private:
 
     QStringList sq_commands;
@@ -6,23 +6,24 @@
 // @desc:     Plugin engine implementation.
 
 #include "plugin_engine.h"
+#include "profiler.h"
 #include "settings/settings.h"
 
 using namespace comp;
 
 QList<PluginEngine::Service> PluginEngine::official_services;
 
-PluginEngine::PluginEngine(const QString &desc_file_path, QWidget *parent)
+PluginEngine::PluginEngine(const QString &desc_file_path,
+    const QString &preset_root_path, QWidget *parent)
   : QObject(parent), desc_file_path(desc_file_path)
 {
   venv_status_str = "Not needed";
-  l_venv_status = new QLabel(venv_status_str);
-  pb_venv_init_log = new QPushButton;
 
   QFileInfo desc_file_info(desc_file_path);
   plugin_root_path = desc_file_info.absolutePath();
   ready_to_use = true;        // normally immediately ready to use unless venv is needed
   py_use_virtualenv = false;  // only set to true if the physeng file requests
+  venv_use_system_site = false;
   venv_init_success = false;  // only set to true after initialization succeeds
 
   QFile desc_file(desc_file_path);
@@ -117,8 +118,7 @@ PluginEngine::PluginEngine(const QString &desc_file_path, QWidget *parent)
     } else if (rs.name() == "py_use_virtualenv") {
       // introduced in SiQAD v0.2.2
       py_use_virtualenv = rs.readElementText() == "1";
-      venv_status_str = "Pending init";
-      l_venv_status->setText(venv_status_str);
+      setVenvStatus("Pending init");
       ready_to_use = false;
     } else if (rs.name() == "venv_use_system_site_packages") {
       // introduced in SiQAD v0.2.2
@@ -143,6 +143,14 @@ PluginEngine::PluginEngine(const QString &desc_file_path, QWidget *parent)
           unrecognizedXMLElement(rs);
         }
       }
+    } else if (rs.name() == "worker") {
+      while (rs.readNextStartElement()) {
+        if (rs.name() == "program" || rs.name() == "arg") {
+          worker_command_format.append(rs.readElementText());
+        } else {
+          unrecognizedXMLElement(rs);
+        }
+      }
     } else if (rs.name() == "requested_datasets") {
       // TODO remove or implement
       rs.skipCurrentElement();
@@ -163,28 +171,44 @@ PluginEngine::PluginEngine(const QString &desc_file_path, QWidget *parent)
 
   // initialize engine preset storage path if it doesn't already exist
   if (preset_dir_path.isEmpty()) {
-    QDir preset_root_dir(settings::AppSettings::instance()->getPath("plugs/preset_root_path"));
+    QDir preset_root_dir(!preset_root_path.isEmpty() ? preset_root_path
+        : settings::AppSettings::instance()->getPath("plugs/preset_root_path"));
     QDir eng_preset_dir(preset_root_dir.filePath(name()));
     if (!eng_preset_dir.mkpath(".")) {
       qWarning() << tr("Unable to create engine preset directory %1").arg(eng_preset_dir.path());
     }
     preset_dir_path = eng_preset_dir.path();
   }
-
-  // prepare virtual environment if needed
-  if (py_use_virtualenv) {
-    prepareVirtualenv();
-  }
 }
 
 void PluginEngine::prepareVirtualenv()
 {
+  SQ_PROFILE_SCOPE("PluginEngine::prepareVirtualenv");
+
   if (!py_use_virtualenv) {
     return;
   }
 
-  venv_status_str = "Initializing venv";
-  l_venv_status->setText(venv_status_str);
+  // skip venv creation and pip entirely if the venv was last initialized
+  // with the same dependencies
+  QString dep_hash = venvDependencyHash();
+  QFile stamp_file(venvStampPath());
+  if (stamp_file.open(QFile::ReadOnly | QFile::Text)) {
+    QString stamp = QString::fromUtf8(stamp_file.readAll()).trimmed();
+    stamp_file.close();
+    if (stamp == dep_hash && !pythonBin().isEmpty()) {
+      qDebug() << tr("Plugin %1 venv is up to date, skipping initialization.").arg(name());
+      ready_to_use = true;
+      venv_init_success = true;
+      setVenvStatus("Ready");
+      return;
+    }
+  }
+
+  // the stamp is written again once the initialization succeeds
+  QFile::remove(venvStampPath());
+
+  setVenvStatus("Initializing venv");
 
   auto term_out = [this](QProcess *p) {
     connect(p, &QProcess::readyReadStandardOutput,
@@ -197,9 +221,8 @@ void PluginEngine::prepareVirtualenv()
         });
   };
 
-  auto venv_pip = [this, term_out]() {
-    venv_status_str = "Downloading pip packages";
-    l_venv_status->setText(venv_status_str);
+  auto venv_pip = [this, term_out, dep_hash]() {
+    setVenvStatus("Downloading pip packages");
 
     // install pip dependencies
     QProcess *dep_process = new QProcess;
@@ -216,19 +239,26 @@ void PluginEngine::prepareVirtualenv()
     qDebug() << tr("(This may take some time) installing pip dependencies for venv %1...").arg(virtualenvPath());
 
     connect(dep_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-        [this](int ecode, QProcess::ExitStatus estatus)
+        [this, dep_hash](int ecode, QProcess::ExitStatus estatus)
         {
           if (ecode != 0 || estatus != QProcess::NormalExit) {
             qWarning() << tr("Plugin %1 failed to install all pip dependencies, "
                 "exit code %2.").arg(name()).arg(ecode);
-            venv_status_str = "Pip download failed";
-            l_venv_status->setText(venv_status_str);
+            setVenvStatus("Pip download failed");
           } else {
             qDebug() << tr("Plugin %1 finished installing pip dependencies.").arg(name());
             ready_to_use = true;
             venv_init_success = true;
-            venv_status_str = "Ready";
-            l_venv_status->setText(venv_status_str);
+            setVenvStatus("Ready");
+
+            // record the dependencies that the venv was initialized with
+            QFile stamp_file(venvStampPath());
+            if (stamp_file.open(QFile::WriteOnly | QFile::Text)) {
+              stamp_file.write(dep_hash.toUtf8());
+              stamp_file.close();
+            } else {
+              qWarning() << tr("Unable to write venv stamp %1").arg(venvStampPath());
+            }
           }
         });
 
@@ -236,8 +266,7 @@ void PluginEngine::prepareVirtualenv()
   };
 
   if (gui::python_path.isEmpty()) {
-    venv_status_str = "No Python interpreter found";
-    l_venv_status->setText(venv_status_str);
+    setVenvStatus("No Python interpreter found");
     qWarning() << tr("No Python interpreter found, cannot initialize venv for "
         "plugin %1").arg(name());
     return;
@@ -264,13 +293,11 @@ void PluginEngine::prepareVirtualenv()
         if (ecode != 0 || estatus != QProcess::NormalExit) {
           qWarning() << tr("Plugin %1 failed to initialize Python venv, exit "
               "code %2.").arg(name()).arg(ecode);
-          venv_status_str = "Init failed";
-          l_venv_status->setText(venv_status_str);
+          setVenvStatus("Init failed");
         } else if (pythonBin().isEmpty()) {
           qWarning() << tr("No venv Python executable found under the provided "
               "venv base path %1. This plugin will not be able to function.").arg(virtualenvPath());
-          venv_status_str = "Py bin not found after init";
-          l_venv_status->setText(venv_status_str);
+          setVenvStatus("Py bin not found after init");
         } else {
           qDebug() << tr("Plugin %1 finished initializing Python venv, moving "
               "onto pip dependency installation.").arg(name());
@@ -281,6 +308,13 @@ void PluginEngine::prepareVirtualenv()
   term_out(venv_process);
 }
 
+void PluginEngine::setVenvStatus(const QString &status)
+{
+  venv_status_str = status;
+  if (l_venv_status != nullptr)
+    l_venv_status->setText(venv_status_str);
+}
+
 QString PluginEngine::pluginStatusStr()
 {
   if (py_use_virtualenv && !venv_init_success) {
@@ -345,6 +379,36 @@ QString PluginEngine::virtualenvPath()
   return eng_preset_dir.filePath("venv");
 }
 
+QString PluginEngine::venvStampPath()
+{
+  return QDir(virtualenvPath()).filePath("siqad_venv_stamp");
+}
+
+QString PluginEngine::venvDependencyHash() const
+{
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+
+  QFile req_file(QDir(pluginRootPath()).filePath("requirements.txt"));
+  if (req_file.open(QFile::ReadOnly)) {
+    hash.addData(req_file.readAll());
+    req_file.close();
+  }
+
+  // identify the base interpreter by its path, size and modification time,
+  // which change whenever it is upgraded, without having to launch it
+  hash.addData(gui::python_path.toUtf8());
+  QString py_exec = QStandardPaths::findExecutable(gui::python_path.split(',').first());
+  if (!py_exec.isEmpty()) {
+    QFileInfo py_info(QFileInfo(py_exec).canonicalFilePath());
+    hash.addData(QString::number(py_info.size()).toUtf8());
+    hash.addData(py_info.lastModified().toString(Qt::ISODate).toUtf8());
+  }
+
+  hash.addData(plugin_version.toUtf8());
+  hash.addData(QByteArray(venv_use_system_site ? "1" : "0"));
+  return QString::fromLatin1(hash.result().toHex());
+}
+
 QString PluginEngine::pythonBin()
 {
   if (!py_use_virtualenv) {
@@ -367,11 +431,34 @@ QString PluginEngine::pythonBin()
   return "";
 }
 
+QStringList PluginEngine::workerCommand()
+{
+  QMap<QString, QString> replace_map;
+  replace_map["@PYTHON@"] = pythonBin();
+  replace_map["@BINPATH@"] = binaryPath();
+  replace_map["@PHYSENGPATH@"] = QFileInfo(descriptionFilePath()).absolutePath();
+
+  QStringList command = worker_command_format;
+  for (QString &arg : command) {
+    for (auto it = replace_map.cbegin(); it != replace_map.cend(); ++it)
+      arg.replace(it.key(), it.value());
+  }
+  return command;
+}
+
+QLabel *PluginEngine::widgetVenvStatus()
+{
+  if (l_venv_status == nullptr)
+    l_venv_status = new QLabel(venv_status_str);
+  return l_venv_status;
+}
+
 QPushButton *PluginEngine::widgetVenvInitLog()
 {
-  // TODO make required connections for pop-op box creation
-  pb_venv_init_log->setText("Venv Init Log");
-  
+  if (pb_venv_init_log != nullptr)
+    return pb_venv_init_log;
+
+  pb_venv_init_log = new QPushButton("Venv Init Log");
   connect(pb_venv_init_log, &QPushButton::pressed,
       [this](){
         QWidget *wid = new QWidget();
@@ -68,13 +68,19 @@ namespace comp{
       VersionField, RootPathField, BinaryPathField, DependenciesPathField,
       DescriptionPathField, UserPresetDirectoryPathField};
 
-    //! Constructor taking in the description file path to this public.
-    PluginEngine(const QString &desc_file_path, QWidget *parent=nullptr);
+    //! Constructor taking in the description file path to this public. The
+    //! engine doesn't create any widgets until they are requested, so it may
+    //! be constructed on a worker thread and moved to the GUI thread. Pass the
+    //! preset root path in that case, otherwise it is read from AppSettings.
+    //! Call prepareVirtualenv() once the Python path is known.
+    PluginEngine(const QString &desc_file_path,
+        const QString &preset_root_path=QString(), QWidget *parent=nullptr);
 
     //! Destructor.
     ~PluginEngine() {};
 
-    //! Initialize virtualenv and install requirements if needed.
+    //! Initialize virtualenv and install requirements if needed. Nothing is
+    //! launched if the venv stamp matches the current dependency hash.
     void prepareVirtualenv();
 
     //! Return the current plugin status in text.
@@ -116,6 +122,14 @@ namespace comp{
                        command_formats.at(i).second.join(delim));
     }
 
+    //! Return whether the plugin can run as a persistent worker which serves
+    //! many job steps over stdin and stdout.
+    bool supportsWorkers() const {return !worker_command_format.isEmpty();}
+
+    //! Return the command which starts a persistent worker with keyword
+    //! replacement performed. Only job independent keywords are available.
+    QStringList workerCommand();
+
     //! Return a QStringList of services provided by this plugin.
     //! TODO figure out a way to standardize services.
     QStringList services() const {return plugin_services;}
@@ -138,6 +152,15 @@ namespace comp{
     //! Empty string if not set.
     QString pythonBin();
 
+    //! Return the path to the stamp file in the virtual environment, which
+    //! holds the dependency hash of the last successful initialization.
+    QString venvStampPath();
+
+    //! Return a hash of everything that the virtual environment depends on:
+    //! requirements.txt, the base Python interpreter, the plugin version and
+    //! the system site packages flag.
+    QString venvDependencyHash() const;
+
     //! Return the plugin version.
     QString version() const {return plugin_version;}
 
@@ -164,7 +187,7 @@ namespace comp{
     static QList<Service> official_services;
 
     //! Return a QLabel which reflects the venv init status.
-    QLabel *widgetVenvStatus() {return l_venv_status;}
+    QLabel *widgetVenvStatus();
 
     //! Return a QPushButton which creates a pop-up box showing the venv init
     //! log when pressed.
@@ -178,12 +201,18 @@ namespace comp{
 
   private:
 
+    // set the venv status string and update the status label if it exists
+    void setVenvStatus(const QString &status);
+
     // default runtime properties
     gui::PropertyMap default_prop_map;
 
     // preset invocation command formats
     QList<QPair<QString, QStringList>> command_formats;
 
+    // persistent worker invocation command format, empty if not supported
+    QStringList worker_command_format;
+
     // datasets that can be returned by this plugin engine
     QSet<ReturnableDataset> returnable_datasets;
 
@@ -210,8 +239,8 @@ namespace comp{
 
     // widgets served to Plugin Manager
     QString venv_status_str;
-    QLabel *l_venv_status;          // label for venv init status (or N/A if not needed)
-    QPushButton *pb_venv_init_log;  // pushbutton for viewing venv init log
+    QLabel *l_venv_status=nullptr;          // label for venv init status (or N/A if not needed)
+    QPushButton *pb_venv_init_log=nullptr;  // pushbutton for viewing venv init log
   };
 
 }; // end of comp namespace
@@ -0,0 +1,217 @@
+// @file:     plugin_worker.cc
+// @author:   Samuel
+// @created:  2020.06.22
+// @license:  GNU LGPL v3
+//
+// @desc:     PluginWorker and PluginWorkerPool implementation
+
+#include "plugin_worker.h"
+#include "settings/settings.h"
+
+using namespace comp;
+
+// PluginWorker implementation
+const QString PluginWorker::protocol_prefix = "@SQWORKER@ ";
+
+PluginWorker::PluginWorker(PluginEngine *engine, const ResourcePolicy &policy,
+    QObject *parent)
+  : QObject(parent), engine(engine), policy(policy)
+{
+  process = new PolicyProcess(policy, this);
+  connect(process, &QProcess::readyReadStandardOutput,
+          this, &PluginWorker::readStandardOutput);
+  connect(process, &QProcess::readyReadStandardError,
+          [this]()
+          {
+            emit sig_standardError(QString::fromUtf8(process->readAllStandardError()));
+          });
+  connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+          this, &PluginWorker::processExit);
+  connect(process, &QProcess::started,
+          [this]()
+          {
+            emit sig_started(process->processId());
+          });
+  connect(process, &QProcess::errorOccurred,
+          this, &PluginWorker::processLaunchError);
+}
+
+PluginWorker::~PluginWorker()
+{
+  if (isRunning()) {
+    process->kill();
+    process->waitForFinished(1000);
+  }
+}
+
+void PluginWorker::start()
+{
+  QStringList command = engine->workerCommand();
+  qDebug() << tr("Starting %1 worker: %2").arg(engine->name()).arg(command.join(" "));
+  process->setProgram(command.takeFirst());
+  process->setArguments(command);
+  process->start();
+}
+
+void PluginWorker::submit(const QString &problem_path, const QString &result_path,
+    const QString &step_dir)
+{
+  QJsonObject request;
+  request["problem_path"] = problem_path;
+  request["result_path"] = result_path;
+  request["step_dir"] = step_dir;
+  busy = true;
+  process->write(QJsonDocument(request).toJson(QJsonDocument::Compact) + "\n");
+}
+
+void PluginWorker::stop()
+{
+  process->closeWriteChannel();
+}
+
+void PluginWorker::kill()
+{
+  process->kill();
+}
+
+void PluginWorker::readStandardOutput()
+{
+  stdout_buf.append(process->readAllStandardOutput());
+  int line_end;
+  while ((line_end = stdout_buf.indexOf('\n')) != -1) {
+    QString line = QString::fromUtf8(stdout_buf.left(line_end + 1));
+    stdout_buf.remove(0, line_end + 1);
+    if (!line.startsWith(protocol_prefix)) {
+      emit sig_standardOutput(line);
+      continue;
+    }
+
+    QJsonObject msg = QJsonDocument::fromJson(
+        line.mid(protocol_prefix.length()).toUtf8()).object();
+    if (msg.value("status").toString() == "done" && busy) {
+      busy = false;
+      requests_served++;
+      emit sig_requestFinished(msg.value("exit_code").toInt(), QProcess::NormalExit);
+    } else {
+      qWarning() << tr("Unexpected message from %1 worker: %2")
+        .arg(engine->name()).arg(line.trimmed());
+    }
+  }
+}
+
+void PluginWorker::processLaunchError(QProcess::ProcessError error)
+{
+  // other errors are followed by the finished signal
+  if (error != QProcess::FailedToStart)
+    return;
+
+  QString msg = tr("Failed to start %1 worker: %2").arg(engine->name())
+    .arg(process->errorString());
+  qWarning() << msg;
+  if (busy) {
+    busy = false;
+    emit sig_standardError(msg + "\n");
+    emit sig_requestFinished(-1, QProcess::CrashExit);
+  }
+  emit sig_workerExited(this);
+}
+
+void PluginWorker::processExit(int exit_code, QProcess::ExitStatus exit_status)
+{
+  qDebug() << tr("%1 worker exited with code %2 after serving %3 requests.")
+    .arg(engine->name()).arg(exit_code).arg(requests_served);
+  if (!stdout_buf.isEmpty()) {
+    emit sig_standardOutput(QString::fromUtf8(stdout_buf));
+    stdout_buf.clear();
+  }
+  // exiting in the middle of a request is a crash regardless of exit code
+  if (busy) {
+    busy = false;
+    emit sig_requestFinished(exit_code, QProcess::CrashExit);
+  }
+  emit sig_workerExited(this);
+  Q_UNUSED(exit_status);
+}
+
+
+// PluginWorkerPool implementation
+PluginWorkerPool *PluginWorkerPool::instance()
+{
+  static PluginWorkerPool *pool = nullptr;
+  if (pool == nullptr)
+    pool = new PluginWorkerPool(QCoreApplication::instance());
+  return pool;
+}
+
+PluginWorkerPool::PluginWorkerPool(QObject *parent)
+  : QObject(parent)
+{
+  expiry_timer.setInterval(10000);
+  connect(&expiry_timer, &QTimer::timeout,
+          this, &PluginWorkerPool::stopExpiredWorkers);
+  expiry_timer.start();
+}
+
+PluginWorker *PluginWorkerPool::acquire(PluginEngine *engine,
+    const ResourcePolicy &policy)
+{
+  settings::AppSettings *app_settings = settings::AppSettings::instance();
+  if (!engine->supportsWorkers() || !app_settings->get<bool>("plugs/use_workers"))
+    return nullptr;
+
+  // reuse an idle worker if possible
+  int engine_workers = 0;
+  PluginWorker *evictable = nullptr;
+  for (PluginWorker *worker : workers) {
+    if (worker->pluginEngine() != engine || !idle_since.contains(worker)) {
+      engine_workers += worker->pluginEngine() == engine;
+      continue;
+    }
+    if (worker->resourcePolicy().sameLaunchLimits(policy)) {
+      idle_since.remove(worker);
+      return worker;
+    }
+    engine_workers++;
+    evictable = worker;
+  }
+
+  // make room by stopping an idle worker started with other limits
+  if (engine_workers >= app_settings->get<int>("plugs/max_workers_per_engine")) {
+    if (evictable == nullptr)
+      return nullptr;
+    idle_since.remove(evictable);
+    evictable->stop();
+  }
+
+  // requests submitted before the worker has started are buffered by QProcess
+  PluginWorker *worker = new PluginWorker(engine, policy, this);
+  connect(worker, &PluginWorker::sig_workerExited,
+          this, &PluginWorkerPool::removeWorker);
+  workers.append(worker);
+  worker->start();
+  return worker;
+}
+
+void PluginWorkerPool::release(PluginWorker *worker)
+{
+  if (worker->isRunning() && workers.contains(worker))
+    idle_since[worker].start();
+}
+
+void PluginWorkerPool::stopExpiredWorkers()
+{
+  qint64 timeout_ms = 1000LL * settings::AppSettings::instance()->get<int>("plugs/worker_idle_timeout_s");
+  for (PluginWorker *worker : idle_since.keys()) {
+    if (idle_since.value(worker).hasExpired(timeout_ms)) {
+      idle_since.remove(worker);
+      worker->stop();
+    }
+  }
+}
+
+void PluginWorkerPool::removeWorker(PluginWorker *worker)
+{
+  workers.removeAll(worker);
+  idle_since.remove(worker);
+  worker->deleteLater();
+}
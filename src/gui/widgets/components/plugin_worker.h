@@ -0,0 +1,154 @@
+/** @file:     plugin_worker.h
+ *  @author:   Samuel
+ *  @created:  2020.06.22
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Persistent plugin processes which serve many job steps, so that
+ *             interpreter startup and imports are only paid once.
+ */
+
+#ifndef _COMP_PLUGIN_WORKER_H_
+#define _COMP_PLUGIN_WORKER_H_
+
+#include <QtCore>
+#include "plugin_engine.h"
+#include "resource_policy.h"
+
+namespace comp{
+
+  //! A long-lived plugin process started with the worker command in the plugin
+  //! description file. Job requests are written to the worker's stdin as one
+  //! JSON object per line with the keys "problem_path", "result_path" and
+  //! "step_dir". The worker answers each request on stdout with the line
+  //!   @SQWORKER@ {"status": "done", "exit_code": 0}
+  //! once the result has been written. All other output is treated as the
+  //! log of the job being served. The worker is expected to exit when its
+  //! stdin is closed.
+  class PluginWorker : public QObject
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Constructor.
+    PluginWorker(PluginEngine *engine, const ResourcePolicy &policy,
+        QObject *parent=nullptr);
+
+    //! Destructor, kills the worker process if it is still running.
+    ~PluginWorker();
+
+    //! Start the worker process without waiting for it, sig_started or
+    //! sig_workerExited is emitted once the launch succeeded or failed.
+    void start();
+
+    //! Request the worker to serve a job step. The worker must not be busy.
+    void submit(const QString &problem_path, const QString &result_path,
+        const QString &step_dir);
+
+    //! Close the worker's stdin so that it exits after the current request.
+    void stop();
+
+    //! Kill the worker process, a request being served finishes as crashed.
+    void kill();
+
+    //! Return whether a request is being served.
+    bool isBusy() const {return busy;}
+
+    //! Return whether the worker process is starting or running.
+    bool isRunning() const {return process->state() != QProcess::NotRunning;}
+
+    //! Return whether the worker process has finished starting.
+    bool isStarted() const {return process->state() == QProcess::Running;}
+
+    //! Return the process ID of the worker process.
+    qint64 processId() const {return process->processId();}
+
+    //! Return the engine served by this worker.
+    PluginEngine *pluginEngine() const {return engine;}
+
+    //! Return the resource policy the worker was started with.
+    ResourcePolicy resourcePolicy() const {return policy;}
+
+    //! Return the number of requests served so far.
+    int requestsServed() const {return requests_served;}
+
+    //! Protocol prefix of the lines written by the worker to SiQAD.
+    static const QString protocol_prefix;
+
+  signals:
+
+    //! Emit that the worker process has started.
+    void sig_started(qint64 pid);
+
+    //! Standard output of the request being served.
+    void sig_standardOutput(const QString &out);
+
+    //! Standard error of the request being served.
+    void sig_standardError(const QString &err);
+
+    //! Emit the completion of a request.
+    void sig_requestFinished(int exit_code, QProcess::ExitStatus exit_status);
+
+    //! Emit that the worker process has exited.
+    void sig_workerExited(PluginWorker *worker);
+
+  private:
+
+    //! Split the standard output into protocol messages and log lines.
+    void readStandardOutput();
+
+    //! Handle a worker process which failed to start, failing the request
+    //! being served if any.
+    void processLaunchError(QProcess::ProcessError error);
+
+    //! Handle the exit of the worker process.
+    void processExit(int exit_code, QProcess::ExitStatus exit_status);
+
+    PluginEngine *engine;
+    ResourcePolicy policy;
+    QProcess *process;
+    QByteArray stdout_buf;        // incomplete stdout line
+    bool busy=false;              // whether a request is being served
+    int requests_served=0;        // requests finished by this worker
+  };
+
+  //! Pool of persistent workers shared by all jobs. Workers are started on
+  //! demand up to a per engine limit and are stopped after being idle for a
+  //! while. The pool is owned by the application instance.
+  class PluginWorkerPool : public QObject
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Return the pool instance.
+    static PluginWorkerPool *instance();
+
+    //! Return an idle worker of the engine started with the same launch limits
+    //! as the given policy, starting one if the worker limit allows. Returns a
+    //! null pointer if workers are disabled, unsupported by the engine or all
+    //! busy, in which case the job step should be invoked as a process.
+    PluginWorker *acquire(PluginEngine *engine, const ResourcePolicy &policy);
+
+    //! Return a worker to the pool once its request has finished.
+    void release(PluginWorker *worker);
+
+  private:
+
+    //! Constructor.
+    PluginWorkerPool(QObject *parent);
+
+    //! Stop workers which have been idle for longer than the idle timeout.
+    void stopExpiredWorkers();
+
+    //! Remove a worker whose process has exited.
+    void removeWorker(PluginWorker *worker);
+
+    QList<PluginWorker*> workers;                 // all running workers
+    QHash<PluginWorker*, QElapsedTimer> idle_since;  // idle workers and how long they've been idle
+    QTimer expiry_timer;                          // periodic idle timeout check
+  };
+
+} // end of comp namespace
+
+#endif
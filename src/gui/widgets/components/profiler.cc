@@ -0,0 +1,151 @@
+/** @file:     profiler.cc
+ *  @author:   Samuel
+ *  @created:  2020.06.12
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Lightweight scoped timers which record named spans for
+ *             performance tracing, exported as Chrome trace JSON, and
+ *             latency histograms for frequently executed code paths.
+ */
+
+#include "profiler.h"
+
+#include <algorithm>
+
+using namespace comp;
+
+QAtomicInt Profiler::is_enabled(0);
+QElapsedTimer Profiler::timer;
+QMutex Profiler::mutex;
+QVector<Profiler::Span> Profiler::recorded_spans;
+QHash<Qt::HANDLE, int> Profiler::thread_ids;
+QMap<int, QString> Profiler::thread_names;
+
+void Profiler::setEnabled(bool enable)
+{
+  QMutexLocker locker(&mutex);
+  if (enable && !timer.isValid())
+    timer.start();
+  is_enabled.store(enable);
+}
+
+qint64 Profiler::elapsedUs()
+{
+  return timer.nsecsElapsed() / 1000;
+}
+
+void Profiler::recordSpan(const char *name, qint64 start_us, qint64 dur_us)
+{
+  QMutexLocker locker(&mutex);
+  // the scope might have started before recording was disabled
+  if (!is_enabled.load())
+    return;
+  recorded_spans.append(Span{name, start_us, dur_us, threadId()});
+}
+
+void Profiler::setThreadName(const QString &name)
+{
+  QMutexLocker locker(&mutex);
+  thread_names.insert(threadId(), name);
+}
+
+QVector<Profiler::Span> Profiler::spans()
+{
+  QMutexLocker locker(&mutex);
+  return recorded_spans;
+}
+
+bool Profiler::writeChromeTrace(const QString &path)
+{
+  QMutexLocker locker(&mutex);
+
+  QJsonArray events;
+  qint64 pid = QCoreApplication::applicationPid();
+  for (auto it = thread_names.cbegin(); it != thread_names.cend(); ++it) {
+    events.append(QJsonObject{
+        {"name", "thread_name"}, {"ph", "M"}, {"pid", pid}, {"tid", it.key()},
+        {"args", QJsonObject{{"name", it.value()}}}});
+  }
+  for (const Span &span : recorded_spans) {
+    events.append(QJsonObject{
+        {"name", span.name}, {"ph", "X"}, {"pid", pid}, {"tid", span.tid},
+        {"ts", span.start_us}, {"dur", span.dur_us}});
+  }
+
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << QObject::tr("Profiler: unable to write trace to %1: %2")
+      .arg(path).arg(file.errorString());
+    return false;
+  }
+  QJsonObject trace{{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+  file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+  file.close();
+  qDebug() << QObject::tr("Profiler: wrote %1 spans to %2")
+    .arg(recorded_spans.size()).arg(path);
+  return true;
+}
+
+int Profiler::threadId()
+{
+  Qt::HANDLE handle = QThread::currentThreadId();
+  auto it = thread_ids.constFind(handle);
+  if (it != thread_ids.cend())
+    return it.value();
+  int tid = thread_ids.size();
+  thread_ids.insert(handle, tid);
+  return tid;
+}
+
+
+// LatencyHistogram
+
+void LatencyHistogram::record(qint64 value)
+{
+  value = qMax(value, qint64(0));
+  buckets[bucketIndex(value)]++;
+  total_count++;
+  sum += value;
+  max_value = qMax(max_value, value);
+}
+
+qint64 LatencyHistogram::percentile(qreal p) const
+{
+  if (total_count == 0)
+    return 0;
+  qint64 rank = qMax(qint64(1), qint64(qCeil(total_count * p / 100.)));
+  qint64 seen = 0;
+  for (int i=0; i<bucket_count; i++) {
+    seen += buckets[i];
+    if (seen >= rank)
+      return qMin(bucketUpperBound(i), max_value);
+  }
+  return max_value;
+}
+
+void LatencyHistogram::reset()
+{
+  std::fill(buckets, buckets + bucket_count, 0);
+  total_count = 0;
+  sum = 0;
+  max_value = 0;
+}
+
+int LatencyHistogram::bucketIndex(qint64 value)
+{
+  if (value < 8)
+    return static_cast<int>(value);
+  // position of the highest set bit, the two bits below it pick the bucket
+  int msb = 63 - qCountLeadingZeroBits(static_cast<quint64>(value));
+  int sub = static_cast<int>((value >> (msb - 2)) & 3);
+  return qMin(8 + (msb - 3) * 4 + sub, bucket_count - 1);
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+  if (index < 8)
+    return index;
+  int msb = (index - 8) / 4 + 3;
+  int sub = (index - 8) % 4;
+  return ((qint64(5 + sub) << (msb - 2))) - 1;
+}
@@ -0,0 +1,185 @@
+/** @file:     profiler.h
+ *  @author:   Samuel
+ *  @created:  2020.06.12
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Lightweight scoped timers which record named spans for
+ *             performance tracing, exported as Chrome trace JSON, and
+ *             latency histograms for frequently executed code paths.
+ */
+
+#ifndef _COMP_PROFILER_H_
+#define _COMP_PROFILER_H_
+
+#include <QtCore>
+
+// Record the enclosing scope as a span with the given name. The name must be
+// a string literal or otherwise outlive the profiler.
+#define SQ_PROFILE_CONCAT_(a, b) a##b
+#define SQ_PROFILE_CONCAT(a, b) SQ_PROFILE_CONCAT_(a, b)
+#define SQ_PROFILE_SCOPE(name) \
+  comp::ProfileScope SQ_PROFILE_CONCAT(sq_profile_scope_, __LINE__)(name)
+
+namespace comp{
+
+  //! Profiler collects spans recorded by ProfileScope from any thread. It is
+  //! disabled by default, in which case a ProfileScope costs a single branch
+  //! on construction and destruction. Enabling is meant to be done once at
+  //! application start before any other thread is spawned. Recording may be
+  //! disabled at any time, spans ending afterwards are dropped.
+  class Profiler
+  {
+  public:
+
+    //! A recorded span, times in microseconds since the profiler was enabled.
+    struct Span
+    {
+      const char *name;
+      qint64 start_us;
+      qint64 dur_us;
+      int tid;
+    };
+
+    //! Enable or disable recording. Spans recorded so far are kept.
+    static void setEnabled(bool enable);
+
+    //! Return whether recording is enabled.
+    static bool enabled() {return is_enabled.load();}
+
+    //! Return the microseconds elapsed since the profiler was enabled.
+    static qint64 elapsedUs();
+
+    //! Record a span which started at start_us and lasted dur_us unless
+    //! recording has been disabled in the meantime. Thread-safe.
+    static void recordSpan(const char *name, qint64 start_us, qint64 dur_us);
+
+    //! Name the calling thread in the exported trace. Thread-safe.
+    static void setThreadName(const QString &name);
+
+    //! Return a copy of the spans recorded so far.
+    static QVector<Span> spans();
+
+    //! Write the recorded spans to the given path in the Chrome trace event
+    //! format, viewable in chrome://tracing or Perfetto.
+    static bool writeChromeTrace(const QString &path);
+
+  private:
+
+    //! Return a small sequential ID for the calling thread, the mutex must be
+    //! held by the caller.
+    static int threadId();
+
+    static QAtomicInt is_enabled;
+    static QElapsedTimer timer;
+    static QMutex mutex;
+    static QVector<Span> recorded_spans;
+    static QHash<Qt::HANDLE, int> thread_ids;
+    static QMap<int, QString> thread_names;
+  };
+
+  //! Histogram of non-negative values, e.g. latencies in microseconds, with
+  //! logarithmic buckets so that memory and recording cost stay constant.
+  //! Values below 8 are exact, larger values are binned with four buckets per
+  //! power of two which bounds the percentile error at 25%. Not thread-safe.
+  class LatencyHistogram
+  {
+  public:
+
+    //! Record one value.
+    void record(qint64 value);
+
+    //! Return the upper bound of the bucket containing the given percentile
+    //! (0 to 100) of the recorded values, or 0 if nothing was recorded.
+    qint64 percentile(qreal p) const;
+
+    //! Return the number of recorded values.
+    qint64 count() const {return total_count;}
+
+    //! Return the largest recorded value.
+    qint64 max() const {return max_value;}
+
+    //! Return the mean of the recorded values.
+    qreal mean() const {return total_count > 0 ? qreal(sum)/total_count : 0;}
+
+    //! Clear all recorded values.
+    void reset();
+
+  private:
+
+    static const int bucket_count = 8 + 4*60;
+
+    //! Return the bucket index of a value.
+    static int bucketIndex(qint64 value);
+
+    //! Return the largest value that falls into the bucket.
+    static qint64 bucketUpperBound(int index);
+
+    qint64 buckets[bucket_count] = {};
+    qint64 total_count=0;
+    qint64 sum=0;
+    qint64 max_value=0;
+  };
+
+  //! Record the lifetime of this object as a span if the profiler is enabled.
+  class ProfileScope
+  {
+  public:
+
+    //! Constructor, starts the span.
+    ProfileScope(const char *name)
+      : name(name), start_us(Profiler::enabled() ? Profiler::elapsedUs() : -1) {}
+
+    //! Destructor, records the span.
+    ~ProfileScope()
+    {
+      if (start_us >= 0)
+        Profiler::recordSpan(name, start_us, Profiler::elapsedUs() - start_us);
+    }
+
+  private:
+
+    Q_DISABLE_COPY(ProfileScope)
+
+    const char *name;
+    qint64 start_us;
+  };
+
+  //! Record the lifetime of this object in microseconds to the given histogram
+  //! unless it is null. The lifetime is also recorded as a span if the
+  //! profiler is enabled.
+  class HistogramScope
+  {
+  public:
+
+    //! Constructor, starts the timer if there is anything to record to.
+    HistogramScope(LatencyHistogram *hist, const char *name)
+      : hist(hist), name(name)
+    {
+      if (hist != nullptr || Profiler::enabled())
+        timer.start();
+    }
+
+    //! Destructor, records the elapsed time.
+    ~HistogramScope()
+    {
+      if (!timer.isValid())
+        return;
+      qint64 dur_us = timer.nsecsElapsed() / 1000;
+      if (hist != nullptr)
+        hist->record(dur_us);
+      if (Profiler::enabled())
+        Profiler::recordSpan(name, Profiler::elapsedUs() - dur_us, dur_us);
+    }
+
+  private:
+
+    Q_DISABLE_COPY(HistogramScope)
+
+    LatencyHistogram *hist;
+    const char *name;
+    QElapsedTimer timer;
+  };
+
+} // end of comp namespace
+
+#endif
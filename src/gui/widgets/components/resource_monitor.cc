@@ -0,0 +1,360 @@
+// @file:     resource_monitor.cc
+// @author:   Samuel
+// @created:  2020.06.18
+// @license:  GNU LGPL v3
+//
+// @desc:     ResourceUsage and ProcessTreeMonitor implementation
+
+#include "resource_monitor.h"
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+using namespace comp;
+
+namespace {
+
+  // sample interval of the process tree
+  const int sample_interval_ms = 500;
+
+  QString dataSizeString(qint64 bytes)
+  {
+    if (bytes < 1024)
+      return QString("%1 B").arg(bytes);
+    else if (bytes < 1024 * 1024)
+      return QString("%1 KiB").arg(bytes / 1024., 0, 'f', 1);
+    else if (bytes < 1024LL * 1024 * 1024)
+      return QString("%1 MiB").arg(bytes / (1024. * 1024), 0, 'f', 1);
+    return QString("%1 GiB").arg(bytes / (1024. * 1024 * 1024), 0, 'f', 2);
+  }
+
+#ifdef Q_OS_UNIX
+  double timevalSeconds(const timeval &tv)
+  {
+    return tv.tv_sec + tv.tv_usec / 1e6;
+  }
+#endif
+
+#ifdef Q_OS_LINUX
+  // fields of /proc/<pid>/stat used by the monitor
+  struct ProcStat
+  {
+    qint64 ppid=0;
+    qint64 utime=0;     // clock ticks
+    qint64 stime=0;     // clock ticks
+    qint64 starttime=0; // clock ticks since boot
+    qint64 rss=0;       // pages
+  };
+
+  bool readProcStat(const QString &pid, ProcStat &st)
+  {
+    QFile file("/proc/" + pid + "/stat");
+    if (!file.open(QFile::ReadOnly))
+      return false;
+    // the command name may contain spaces and parentheses, the remaining
+    // fields start after the last closing parenthesis
+    QByteArray line = file.readAll();
+    int comm_end = line.lastIndexOf(')');
+    if (comm_end < 0)
+      return false;
+    QList<QByteArray> fields = line.mid(comm_end + 2).split(' ');
+    if (fields.size() < 22)
+      return false;
+    st.ppid = fields.at(1).toLongLong();
+    st.utime = fields.at(11).toLongLong();
+    st.stime = fields.at(12).toLongLong();
+    st.starttime = fields.at(19).toLongLong();
+    st.rss = fields.at(21).toLongLong();
+    return true;
+  }
+
+  // read storage I/O counters, only readable for processes of the same user
+  void readProcIo(const QString &pid, qint64 &read_bytes, qint64 &written_bytes)
+  {
+    QFile file("/proc/" + pid + "/io");
+    if (!file.open(QFile::ReadOnly))
+      return;
+    for (const QByteArray &line : file.readAll().split('\n')) {
+      if (line.startsWith("read_bytes:"))
+        read_bytes = line.mid(11).trimmed().toLongLong();
+      else if (line.startsWith("write_bytes:"))
+        written_bytes = line.mid(12).trimmed().toLongLong();
+    }
+  }
+
+  // peak resident set size of a single process
+  qint64 readProcPeakRssKb(const QString &pid)
+  {
+    QFile file("/proc/" + pid + "/status");
+    if (!file.open(QFile::ReadOnly))
+      return 0;
+    for (const QByteArray &line : file.readAll().split('\n')) {
+      if (line.startsWith("VmHWM:"))
+        return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+    return 0;
+  }
+#endif
+
+}
+
+
+// ResourceUsage implementation
+void ResourceUsage::writeXml(QXmlStreamWriter *ws) const
+{
+  ws->writeStartElement("resources");
+  if (wall_ms >= 0)
+    ws->writeTextElement("wall_time_ms", QString::number(wall_ms));
+  if (user_cpu_s >= 0)
+    ws->writeTextElement("user_cpu_s", QString::number(user_cpu_s));
+  if (sys_cpu_s >= 0)
+    ws->writeTextElement("sys_cpu_s", QString::number(sys_cpu_s));
+  if (peak_rss_kb >= 0)
+    ws->writeTextElement("peak_rss_kb", QString::number(peak_rss_kb));
+  if (read_bytes >= 0)
+    ws->writeTextElement("read_bytes", QString::number(read_bytes));
+  if (written_bytes >= 0)
+    ws->writeTextElement("written_bytes", QString::number(written_bytes));
+  if (process_count >= 0)
+    ws->writeTextElement("process_count", QString::number(process_count));
+  if (peak_process_count >= 0)
+    ws->writeTextElement("peak_process_count", QString::number(peak_process_count));
+  ws->writeEndElement();
+}
+
+void ResourceUsage::readXml(QXmlStreamReader *rs)
+{
+  while (rs->readNextStartElement()) {
+    if (rs->name() == "wall_time_ms") {
+      wall_ms = rs->readElementText().toLongLong();
+    } else if (rs->name() == "user_cpu_s") {
+      user_cpu_s = rs->readElementText().toDouble();
+    } else if (rs->name() == "sys_cpu_s") {
+      sys_cpu_s = rs->readElementText().toDouble();
+    } else if (rs->name() == "peak_rss_kb") {
+      peak_rss_kb = rs->readElementText().toLongLong();
+    } else if (rs->name() == "read_bytes") {
+      read_bytes = rs->readElementText().toLongLong();
+    } else if (rs->name() == "written_bytes") {
+      written_bytes = rs->readElementText().toLongLong();
+    } else if (rs->name() == "process_count") {
+      process_count = rs->readElementText().toInt();
+    } else if (rs->name() == "peak_process_count") {
+      peak_process_count = rs->readElementText().toInt();
+    } else {
+      qWarning() << QObject::tr("Unknown XML element encountered when "
+          "importing resource usage: %1").arg(rs->name().toString());
+      rs->skipCurrentElement();
+    }
+  }
+}
+
+QString ResourceUsage::summary() const
+{
+  if (!isValid())
+    return QObject::tr("Not measured");
+
+  QStringList parts;
+  parts.append(QObject::tr("wall %1 s").arg(wall_ms / 1000., 0, 'f', 2));
+  if (user_cpu_s >= 0 && sys_cpu_s >= 0)
+    parts.append(QObject::tr("CPU %1 s user, %2 s sys")
+        .arg(user_cpu_s, 0, 'f', 2).arg(sys_cpu_s, 0, 'f', 2));
+  if (peak_rss_kb >= 0)
+    parts.append(QObject::tr("peak RSS %1").arg(dataSizeString(peak_rss_kb * 1024)));
+  if (read_bytes >= 0 && written_bytes >= 0)
+    parts.append(QObject::tr("read %1, written %2")
+        .arg(dataSizeString(read_bytes)).arg(dataSizeString(written_bytes)));
+  if (process_count >= 0)
+    parts.append(QObject::tr("%1 processes (%2 at once)")
+        .arg(process_count).arg(peak_process_count));
+  return parts.join(", ");
+}
+
+
+// ProcessTreeMonitor implementation
+QList<ProcessTreeMonitor*> ProcessTreeMonitor::sampled_monitors;
+QTimer *ProcessTreeMonitor::sample_timer = nullptr;
+int ProcessTreeMonitor::active_monitors = 0;
+quint64 ProcessTreeMonitor::launch_count = 0;
+
+struct ProcessTreeMonitor::ProcTable
+{
+  //! Scan /proc, only on Linux.
+  static ProcTable scan();
+
+#ifdef Q_OS_LINUX
+  QHash<qint64, ProcStat> stats;        // every process by ID
+  QMultiHash<qint64, qint64> children;  // child process IDs by parent ID
+#endif
+};
+
+ProcessTreeMonitor::ProcTable ProcessTreeMonitor::ProcTable::scan()
+{
+  ProcTable table;
+#ifdef Q_OS_LINUX
+  // map every process to its parent to find the descendants of the roots
+  QDirIterator it("/proc", QDir::Dirs | QDir::NoDotAndDotDot);
+  while (it.hasNext()) {
+    it.next();
+    bool is_pid;
+    qint64 pid = it.fileName().toLongLong(&is_pid);
+    ProcStat st;
+    if (!is_pid || !readProcStat(it.fileName(), st))
+      continue;
+    table.stats.insert(pid, st);
+    table.children.insert(st.ppid, pid);
+  }
+#endif
+  return table;
+}
+
+ProcessTreeMonitor::ProcessTreeMonitor(QObject *parent)
+  : QObject(parent)
+{
+}
+
+ProcessTreeMonitor::~ProcessTreeMonitor()
+{
+  if (running)
+    stop();
+}
+
+void ProcessTreeMonitor::start(qint64 t_root_pid, bool t_running_before)
+{
+  root_pid = t_root_pid;
+  proc_samples.clear();
+  proc_baselines.clear();
+  res_usage = ResourceUsage();
+  res_usage.wall_ms = 0;
+
+  exclusive = (active_monitors == 0);
+  active_monitors++;
+  launch_id = ++launch_count;
+  running = true;
+
+#ifdef Q_OS_UNIX
+  getrusage(RUSAGE_CHILDREN, &children_start);
+#endif
+
+  wall_timer.start();
+#ifdef Q_OS_LINUX
+  res_usage.user_cpu_s = res_usage.sys_cpu_s = 0;
+  res_usage.peak_rss_kb = res_usage.read_bytes = res_usage.written_bytes = 0;
+  res_usage.process_count = res_usage.peak_process_count = 0;
+  taking_baseline = t_running_before;
+  sample(ProcTable::scan());
+  taking_baseline = false;
+
+  sampled_monitors.removeOne(this);
+  sampled_monitors.append(this);
+  if (sample_timer == nullptr) {
+    sample_timer = new QTimer();
+    sample_timer->setInterval(sample_interval_ms);
+    QObject::connect(sample_timer, &QTimer::timeout, &ProcessTreeMonitor::sampleAll);
+  }
+  if (!sample_timer->isActive())
+    sample_timer->start();
+#endif
+}
+
+void ProcessTreeMonitor::stop()
+{
+  if (!running)
+    return;
+  sampled_monitors.removeOne(this);
+  if (sampled_monitors.isEmpty() && sample_timer != nullptr)
+    sample_timer->stop();
+  running = false;
+  active_monitors--;
+  res_usage.wall_ms = wall_timer.elapsed();
+
+  // the RUSAGE_CHILDREN counters belong to this tree alone only if no other
+  // monitor started or was running in the meantime
+  exclusive = exclusive && launch_id == launch_count;
+
+#ifdef Q_OS_UNIX
+  if (exclusive) {
+    struct rusage children_end;
+    getrusage(RUSAGE_CHILDREN, &children_end);
+    res_usage.user_cpu_s = qMax(res_usage.user_cpu_s,
+        timevalSeconds(children_end.ru_utime) - timevalSeconds(children_start.ru_utime));
+    res_usage.sys_cpu_s = qMax(res_usage.sys_cpu_s,
+        timevalSeconds(children_end.ru_stime) - timevalSeconds(children_start.ru_stime));
+    // ru_maxrss is the largest child ever reaped, it is only attributable to
+    // this tree if it increased
+    if (children_end.ru_maxrss > children_start.ru_maxrss) {
+#ifdef Q_OS_MACOS
+      qint64 maxrss_kb = children_end.ru_maxrss / 1024;
+#else
+      qint64 maxrss_kb = children_end.ru_maxrss;
+#endif
+      res_usage.peak_rss_kb = qMax(res_usage.peak_rss_kb, maxrss_kb);
+    }
+#ifndef Q_OS_LINUX
+    res_usage.read_bytes = 512LL * (children_end.ru_inblock - children_start.ru_inblock);
+    res_usage.written_bytes = 512LL * (children_end.ru_oublock - children_start.ru_oublock);
+#endif
+  }
+#endif
+}
+
+void ProcessTreeMonitor::sampleAll()
+{
+  ProcTable table = ProcTable::scan();
+  for (ProcessTreeMonitor *monitor : sampled_monitors)
+    monitor->sample(table);
+}
+
+void ProcessTreeMonitor::sample(const ProcTable &table)
+{
+#ifdef Q_OS_LINUX
+  static const double clk_tck = sysconf(_SC_CLK_TCK);
+  static const qint64 page_kb = sysconf(_SC_PAGESIZE) / 1024;
+  const QHash<qint64, ProcStat> &stats = table.stats;
+  const QMultiHash<qint64, qint64> &children = table.children;
+
+  QList<qint64> tree;
+  if (stats.contains(root_pid))
+    tree.append(root_pid);
+  for (int i=0; i<tree.size(); i++)
+    tree.append(children.values(tree.at(i)));
+
+  // accumulate per process counters, processes which have exited keep their
+  // last sampled values
+  qint64 tree_rss_kb = 0;
+  for (qint64 pid : tree) {
+    const ProcStat &st = stats.value(pid);
+    QString pid_str = QString::number(pid);
+    QPair<qint64,qint64> proc_key = qMakePair(pid, st.starttime);
+    ProcSample &ps = proc_samples[proc_key];
+    ps.user_cpu_s = st.utime / clk_tck;
+    ps.sys_cpu_s = st.stime / clk_tck;
+    readProcIo(pid_str, ps.read_bytes, ps.written_bytes);
+    tree_rss_kb += st.rss * page_kb;
+    // the peak RSS of processes running before start() may predate it
+    if (taking_baseline)
+      proc_baselines.insert(proc_key, ps);
+    else if (!proc_baselines.contains(proc_key))
+      res_usage.peak_rss_kb = qMax(res_usage.peak_rss_kb, readProcPeakRssKb(pid_str));
+  }
+
+  double user_cpu_s = 0, sys_cpu_s = 0;
+  qint64 read_bytes = 0, written_bytes = 0;
+  for (auto it = proc_samples.cbegin(); it != proc_samples.cend(); ++it) {
+    ProcSample base = proc_baselines.value(it.key());
+    user_cpu_s += it.value().user_cpu_s - base.user_cpu_s;
+    sys_cpu_s += it.value().sys_cpu_s - base.sys_cpu_s;
+    read_bytes += it.value().read_bytes - base.read_bytes;
+    written_bytes += it.value().written_bytes - base.written_bytes;
+  }
+  res_usage.user_cpu_s = user_cpu_s;
+  res_usage.sys_cpu_s = sys_cpu_s;
+  res_usage.read_bytes = read_bytes;
+  res_usage.written_bytes = written_bytes;
+  res_usage.peak_rss_kb = qMax(res_usage.peak_rss_kb, tree_rss_kb);
+  res_usage.process_count = proc_samples.size();
+  res_usage.peak_process_count = qMax(res_usage.peak_process_count, tree.size());
+#endif
+  res_usage.wall_ms = wall_timer.elapsed();
+}
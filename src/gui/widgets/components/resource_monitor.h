@@ -0,0 +1,129 @@
+/** @file:     resource_monitor.h
+ *  @author:   Samuel
+ *  @created:  2020.06.18
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Resource usage telemetry for plugin processes and their
+ *             descendants.
+ */
+
+#ifndef _COMP_RESOURCE_MONITOR_H_
+#define _COMP_RESOURCE_MONITOR_H_
+
+#include <QtCore>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace comp{
+
+  //! Resource usage of a process tree. Negative values denote quantities that
+  //! were not measured on this platform.
+  struct ResourceUsage
+  {
+    //! Return whether any measurement has been recorded.
+    bool isValid() const {return wall_ms >= 0;}
+
+    //! Write the measured quantities as children of a "resources" element.
+    void writeXml(QXmlStreamWriter *ws) const;
+
+    //! Read the quantities from a "resources" element, the reader is expected
+    //! to be positioned at its start element.
+    void readXml(QXmlStreamReader *rs);
+
+    //! Return a one-line human readable summary.
+    QString summary() const;
+
+    qint64 wall_ms=-1;            // wall-clock time
+    double user_cpu_s=-1;         // user CPU time
+    double sys_cpu_s=-1;          // system CPU time
+    qint64 peak_rss_kb=-1;        // peak resident set size of the process tree
+    qint64 read_bytes=-1;         // bytes read from storage
+    qint64 written_bytes=-1;      // bytes written to storage
+    int process_count=-1;         // distinct processes seen in the tree
+    int peak_process_count=-1;    // most processes alive at once
+  };
+
+  //! Measure the resource usage of a process and all of its descendants
+  //! between start() and stop().
+  //!
+  //! On Linux the process tree is sampled from /proc periodically, so
+  //! descendants living shorter than the sample interval may be missed. All
+  //! running monitors are sampled from a single scan of /proc per interval. CPU
+  //! time and peak RSS are additionally taken from getrusage(RUSAGE_CHILDREN)
+  //! when no other monitor was active over the same period, since the counters
+  //! are shared by all children of SiQAD. Other Unix platforms only have the
+  //! getrusage measurements and other platforms only record the wall time.
+  class ProcessTreeMonitor : public QObject
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Constructor.
+    ProcessTreeMonitor(QObject *parent=nullptr);
+
+    //! Destructor.
+    ~ProcessTreeMonitor();
+
+    //! Start monitoring the process tree rooted at the given process ID. If
+    //! the tree has been running before, e.g. a reused plugin worker, set
+    //! t_running_before so that only the usage since start() is reported.
+    //! Counters of processes already alive at start() are then taken as a
+    //! baseline and their lifetime peak RSS is not used, peak RSS is only
+    //! sampled for them.
+    void start(qint64 t_root_pid, bool t_running_before=false);
+
+    //! Stop monitoring and finalize the usage. Intended to be called once the
+    //! root process has finished.
+    void stop();
+
+    //! Return the measured usage.
+    ResourceUsage usage() const {return res_usage;}
+
+  private:
+
+    // snapshot of the process table shared by all monitors of a sample
+    struct ProcTable;
+
+    //! Sample all running monitors from one snapshot of the process table.
+    static void sampleAll();
+
+    //! Sample the process tree from the snapshot.
+    void sample(const ProcTable &table);
+
+    // cumulative counters of a single process
+    struct ProcSample
+    {
+      double user_cpu_s=0;
+      double sys_cpu_s=0;
+      qint64 read_bytes=0;
+      qint64 written_bytes=0;
+    };
+
+    QElapsedTimer wall_timer;     // wall time since start()
+    qint64 root_pid=0;            // root of the monitored tree
+    bool running=false;           // whether start() has been called without stop()
+    QHash<QPair<qint64,qint64>, ProcSample> proc_samples;  // keyed by (pid, start time)
+    QHash<QPair<qint64,qint64>, ProcSample> proc_baselines; // counters at start() of reused processes
+    bool taking_baseline=false;   // whether the current sample records baselines
+    ResourceUsage res_usage;      // usage measured so far
+
+    // periodic sampling, shared among all monitors
+    static QList<ProcessTreeMonitor*> sampled_monitors; // monitors sampled by the timer
+    static QTimer *sample_timer;  // created on first use
+
+    // getrusage bookkeeping, shared among all monitors
+    static int active_monitors;   // monitors currently running
+    static quint64 launch_count;  // monitors started since application start
+    quint64 launch_id=0;          // launch_count when this monitor started
+    bool exclusive=false;         // whether no other monitor ran over this period
+#ifdef Q_OS_UNIX
+    struct rusage children_start; // RUSAGE_CHILDREN at start()
+#endif
+  };
+
+} // end of comp namespace
+
+#endif
@@ -0,0 +1,132 @@
+// @file:     resource_policy.cc
+// @author:   Samuel
+// @created:  2020.06.19
+// @license:  GNU LGPL v3
+//
+// @desc:     ResourcePolicy and PolicyProcess implementation
+
+#include "resource_policy.h"
+#include <algorithm>
+#include "settings/settings.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#endif
+
+using namespace comp;
+
+// ResourcePolicy implementation
+ResourcePolicy ResourcePolicy::fromSettings()
+{
+  settings::AppSettings *app_settings = settings::AppSettings::instance();
+  ResourcePolicy policy;
+  if (!parseCpuList(app_settings->get<QString>("plugs/cpu_affinity"), policy.cpu_affinity)) {
+    qWarning() << "Ignoring invalid default CPU affinity in settings.";
+    policy.cpu_affinity.clear();
+  }
+  policy.nice = app_settings->get<int>("plugs/nice");
+  policy.memory_limit_mb = app_settings->get<int>("plugs/memory_limit_mb");
+  policy.timeout_s = app_settings->get<int>("plugs/timeout_s");
+  return policy;
+}
+
+bool ResourcePolicy::parseCpuList(const QString &cpu_list, QList<int> &cpus)
+{
+  cpus.clear();
+  for (const QString &range : cpu_list.split(',', QString::SkipEmptyParts)) {
+    QStringList bounds = range.trimmed().split('-');
+    bool ok_first, ok_last=true;
+    int first = bounds.first().toInt(&ok_first);
+    int last = bounds.size() == 2 ? bounds.last().toInt(&ok_last) : first;
+    if (bounds.size() > 2 || !ok_first || !ok_last || first < 0 || last < first)
+      return false;
+    for (int cpu=first; cpu<=last; cpu++)
+      if (!cpus.contains(cpu))
+        cpus.append(cpu);
+  }
+  std::sort(cpus.begin(), cpus.end());
+  return true;
+}
+
+QString ResourcePolicy::cpuListString() const
+{
+  // collapse consecutive CPUs into ranges
+  QStringList ranges;
+  for (int i=0; i<cpu_affinity.size(); i++) {
+    int first = cpu_affinity.at(i);
+    while (i+1 < cpu_affinity.size() && cpu_affinity.at(i+1) == cpu_affinity.at(i)+1)
+      i++;
+    int last = cpu_affinity.at(i);
+    ranges.append(first == last ? QString::number(first)
+        : QString("%1-%2").arg(first).arg(last));
+  }
+  return ranges.join(",");
+}
+
+void ResourcePolicy::writeXml(QXmlStreamWriter *ws) const
+{
+  ws->writeStartElement("resource_policy");
+  ws->writeTextElement("cpu_affinity", cpuListString());
+  ws->writeTextElement("nice", QString::number(nice));
+  ws->writeTextElement("memory_limit_mb", QString::number(memory_limit_mb));
+  ws->writeTextElement("timeout_s", QString::number(timeout_s));
+  ws->writeEndElement();
+}
+
+void ResourcePolicy::readXml(QXmlStreamReader *rs)
+{
+  while (rs->readNextStartElement()) {
+    if (rs->name() == "cpu_affinity") {
+      parseCpuList(rs->readElementText(), cpu_affinity);
+    } else if (rs->name() == "nice") {
+      nice = rs->readElementText().toInt();
+    } else if (rs->name() == "memory_limit_mb") {
+      memory_limit_mb = rs->readElementText().toLongLong();
+    } else if (rs->name() == "timeout_s") {
+      timeout_s = rs->readElementText().toInt();
+    } else {
+      qWarning() << QObject::tr("Unknown XML element encountered when "
+          "importing resource policy: %1").arg(rs->name().toString());
+      rs->skipCurrentElement();
+    }
+  }
+}
+
+
+// PolicyProcess implementation
+PolicyProcess::PolicyProcess(const ResourcePolicy &policy, QObject *parent)
+  : QProcess(parent), policy(policy)
+{
+#ifdef Q_OS_LINUX
+  // the set is prepared here since allocating is not safe after fork()
+  if (!policy.cpu_affinity.isEmpty()) {
+    cpu_set = QByteArray(sizeof(cpu_set_t), 0);
+    cpu_set_t *set = reinterpret_cast<cpu_set_t*>(cpu_set.data());
+    for (int cpu : policy.cpu_affinity)
+      if (cpu < CPU_SETSIZE)
+        CPU_SET(cpu, set);
+  }
+#endif
+}
+
+void PolicyProcess::setupChildProcess()
+{
+  // failures are ignored, the process then runs with the inherited settings
+#ifdef Q_OS_UNIX
+  if (policy.nice > 0)
+    setpriority(PRIO_PROCESS, 0, getpriority(PRIO_PROCESS, 0) + policy.nice);
+  if (policy.memory_limit_mb > 0) {
+    struct rlimit limit;
+    limit.rlim_cur = limit.rlim_max = static_cast<rlim_t>(policy.memory_limit_mb) * 1024 * 1024;
+    setrlimit(RLIMIT_AS, &limit);
+  }
+#endif
+#ifdef Q_OS_LINUX
+  if (!cpu_set.isEmpty())
+    sched_setaffinity(0, sizeof(cpu_set_t), reinterpret_cast<const cpu_set_t*>(cpu_set.constData()));
+#endif
+}
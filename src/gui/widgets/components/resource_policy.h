@@ -0,0 +1,87 @@
+/** @file:     resource_policy.h
+ *  @author:   Samuel
+ *  @created:  2020.06.19
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Resource limits and CPU affinity applied to plugin processes.
+ */
+
+#ifndef _COMP_RESOURCE_POLICY_H_
+#define _COMP_RESOURCE_POLICY_H_
+
+#include <QtCore>
+
+namespace comp{
+
+  //! Resource policy applied to a job step process at launch. Zero or empty
+  //! values leave the corresponding resource unrestricted.
+  struct ResourcePolicy
+  {
+    //! Return the default policy from the application settings.
+    static ResourcePolicy fromSettings();
+
+    //! Parse a CPU list such as "0-3,6". Returns whether the list is valid,
+    //! in which case cpus contains the sorted CPU indices.
+    static bool parseCpuList(const QString &cpu_list, QList<int> &cpus);
+
+    //! Return the CPU affinity in the CPU list format.
+    QString cpuListString() const;
+
+    //! Return whether no restriction is set.
+    bool isEmpty() const
+    {
+      return cpu_affinity.isEmpty() && nice == 0 && memory_limit_mb == 0
+        && timeout_s == 0;
+    }
+
+    //! Return whether the limits applied at launch, i.e. all but the timeout,
+    //! are the same as those of the other policy.
+    bool sameLaunchLimits(const ResourcePolicy &other) const
+    {
+      return cpu_affinity == other.cpu_affinity && nice == other.nice
+        && memory_limit_mb == other.memory_limit_mb;
+    }
+
+    //! Write the policy as a "resource_policy" element.
+    void writeXml(QXmlStreamWriter *ws) const;
+
+    //! Read the policy from a "resource_policy" element, the reader is
+    //! expected to be positioned at its start element.
+    void readXml(QXmlStreamReader *rs);
+
+    QList<int> cpu_affinity;      // CPUs the process may run on, Linux only
+    int nice=0;                   // scheduling niceness increment, Unix only
+    qint64 memory_limit_mb=0;     // address space limit per process, Unix only
+    int timeout_s=0;              // wall-clock limit after which the process is terminated
+  };
+
+  //! QProcess which applies the niceness, memory limit and CPU affinity of a
+  //! ResourcePolicy to the child process before the program is executed, so
+  //! that they are inherited by all of its descendants. The timeout is left
+  //! to the owner of the process.
+  class PolicyProcess : public QProcess
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Constructor.
+    PolicyProcess(const ResourcePolicy &policy, QObject *parent=nullptr);
+
+  protected:
+
+    //! Apply the policy, called in the child process after fork() and before
+    //! exec() so only async-signal-safe calls may be made.
+    void setupChildProcess() override;
+
+  private:
+
+    ResourcePolicy policy;
+#ifdef Q_OS_LINUX
+    QByteArray cpu_set;           // prepared cpu_set_t for sched_setaffinity
+#endif
+  };
+
+} // end of comp namespace
+
+#endif
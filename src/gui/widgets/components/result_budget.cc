@@ -0,0 +1,60 @@
+// @file:     result_budget.cc
+// @author:   Samuel
+// @created:  2020.06.25
+// @license:  GNU LGPL v3
+//
+// @desc:     ResultMemoryBudget implementation
+
+#include "result_budget.h"
+#include "sim_job.h"
+#include "settings/settings.h"
+
+using namespace comp;
+
+ResultMemoryBudget *ResultMemoryBudget::instance()
+{
+  static ResultMemoryBudget budget;
+  return &budget;
+}
+
+void ResultMemoryBudget::touch(JobStep *job_step)
+{
+  qint64 bytes = job_step->resultMemoryUsage();
+  used_bytes += bytes - step_bytes.value(job_step, 0);
+  step_bytes.insert(job_step, bytes);
+  lru_steps.removeOne(job_step);
+  lru_steps.prepend(job_step);
+  evict(job_step);
+}
+
+void ResultMemoryBudget::remove(JobStep *job_step)
+{
+  if (!step_bytes.contains(job_step))
+    return;
+  used_bytes -= step_bytes.take(job_step);
+  lru_steps.removeOne(job_step);
+}
+
+void ResultMemoryBudget::setPinnedSteps(const QList<JobStep*> &job_steps)
+{
+  pinned_steps = job_steps.toSet();
+}
+
+void ResultMemoryBudget::evict(JobStep *spared_step)
+{
+  qint64 budget_bytes = settings::AppSettings::instance()->get<int>(
+      "plugs/result_memory_budget_mb") * 1024LL * 1024LL;
+  if (budget_bytes <= 0)
+    return;
+
+  for (int i=lru_steps.size()-1; i>=0 && used_bytes > budget_bytes; i--) {
+    JobStep *job_step = lru_steps.at(i);
+    if (job_step == spared_step || pinned_steps.contains(job_step))
+      continue;
+    qDebug() << QObject::tr("Unloading results of job step %1 (%2 kiB) to meet "
+        "the result memory budget.").arg(job_step->jobStepPlacement())
+      .arg(step_bytes.value(job_step) / 1024);
+    // unloading removes the step from the tracked steps
+    job_step->unloadResults();
+  }
+}
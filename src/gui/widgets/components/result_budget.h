@@ -0,0 +1,62 @@
+/** @file:     result_budget.h
+ *  @author:   Samuel
+ *  @created:  2020.06.25
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Memory budget shared by the job results of all job steps.
+ */
+
+#ifndef _COMP_RESULT_BUDGET_H_
+#define _COMP_RESULT_BUDGET_H_
+
+#include <QtCore>
+
+namespace comp{
+
+  class JobStep;
+
+  //! Keeps the job results held in memory by all job steps within the memory
+  //! budget in the application settings. Job steps report each access to their
+  //! results, and once the budget is exceeded the results of the least
+  //! recently used steps are unloaded. Unloaded results are read from their
+  //! result files again on the next access.
+  class ResultMemoryBudget
+  {
+  public:
+
+    //! Return the budget instance.
+    static ResultMemoryBudget *instance();
+
+    //! Record an access to the loaded results of the job step, making them the
+    //! most recently used, and unload the results of other steps while the
+    //! budget is exceeded.
+    void touch(JobStep *job_step);
+
+    //! Stop tracking the job step, e.g. after its results have been unloaded.
+    void remove(JobStep *job_step);
+
+    //! Protect the results of the given steps from being unloaded, e.g. while
+    //! they are shown. Replaces the previously pinned steps.
+    void setPinnedSteps(const QList<JobStep*> &job_steps);
+
+    //! Return the estimated memory held by loaded results in bytes.
+    qint64 usedBytes() const {return used_bytes;}
+
+  private:
+
+    //! Constructor.
+    ResultMemoryBudget() {};
+
+    //! Unload least recently used results until the budget is met, sparing
+    //! the given step and pinned steps.
+    void evict(JobStep *spared_step);
+
+    QList<JobStep*> lru_steps;            // steps with loaded results, most recently used first
+    QHash<JobStep*, qint64> step_bytes;   // estimated result memory of each step
+    QSet<JobStep*> pinned_steps;          // steps whose results must stay loaded
+    qint64 used_bytes=0;                  // sum of step_bytes
+  };
+
+} // end of comp namespace
+
+#endif
@@ -0,0 +1,202 @@
+// @file:     result_cache.cc
+// @author:   Samuel
+// @created:  2020.06.20
+// @license:  GNU LGPL v3
+//
+// @desc:     ResultCache implementation
+
+#include "result_cache.h"
+#include "settings/settings.h"
+
+using namespace comp;
+
+namespace {
+
+  // elements which don't affect the simulation outcome
+  const QStringList ignored_elements({"visible", "active", "color"});
+
+  // Return the canonical text of the current element and its descendants with
+  // sorted attributes and without ignored elements. The reader is left at the
+  // end element.
+  QString canonicalElement(QXmlStreamReader &rs)
+  {
+    QStringList attrs;
+    for (const QXmlStreamAttribute &attr : rs.attributes())
+      attrs.append(attr.name().toString() + "=" + attr.value().toString());
+    attrs.sort();
+    QString s = "<" + rs.name().toString() + " " + attrs.join(" ") + ">";
+    while (rs.readNext() != QXmlStreamReader::EndElement && !rs.atEnd()) {
+      if (rs.isStartElement()) {
+        if (ignored_elements.contains(rs.name().toString()))
+          rs.skipCurrentElement();
+        else
+          s += canonicalElement(rs);
+      } else if (rs.isCharacters() && !rs.isWhitespace()) {
+        s += rs.text().toString().trimmed();
+      }
+    }
+    return s + "</>";
+  }
+
+  // Append the canonical text of the items in the current design layer to
+  // items, flattening aggregates since grouping doesn't affect simulations.
+  void collectLayerItems(QXmlStreamReader &rs, QStringList &items)
+  {
+    while (rs.readNextStartElement()) {
+      if (rs.name() == "aggregate")
+        collectLayerItems(rs, items);
+      else
+        items.append(canonicalElement(rs));
+    }
+  }
+
+}
+
+QString ResultCache::problemHash(const QString &problem_path,
+    const QString &engine_name, const QString &engine_version,
+    const QStringList &command_format)
+{
+  QFile file(problem_path);
+  if (!file.open(QFile::ReadOnly | QFile::Text)) {
+    qWarning() << QObject::tr("Unable to open problem file for hashing: %1")
+      .arg(problem_path);
+    return QString();
+  }
+
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  auto addField = [&hash](const QString &field)
+  {
+    hash.addData(field.toUtf8());
+    hash.addData("\n", 1);
+  };
+
+  addField(engine_name);
+  addField(engine_version);
+  addField(command_format.join(" "));
+
+  QXmlStreamReader rs(&file);
+  rs.readNextStartElement();  // enter root element
+  while (rs.readNextStartElement()) {
+    if (rs.name() == "program" || rs.name() == "gui") {
+      // file metadata and GUI state
+      rs.skipCurrentElement();
+    } else if (rs.name() == "sim_params") {
+      QMap<QString, QString> sim_params;
+      while (rs.readNextStartElement())
+        sim_params.insert(rs.name().toString(), rs.readElementText().trimmed());
+      for (auto it = sim_params.cbegin(); it != sim_params.cend(); ++it)
+        addField(it.key() + "=" + it.value());
+    } else if (rs.name() == "design") {
+      // layer order is kept but the items within a layer are sorted
+      while (rs.readNextStartElement()) {
+        addField("layer " + rs.attributes().value("type").toString());
+        QStringList items;
+        collectLayerItems(rs, items);
+        items.sort();
+        for (const QString &item : items)
+          addField(item);
+      }
+    } else {
+      addField(canonicalElement(rs));
+    }
+  }
+
+  if (rs.hasError()) {
+    qWarning() << QObject::tr("XML error when hashing problem file %1: %2")
+      .arg(problem_path).arg(rs.errorString());
+    return QString();
+  }
+  return QString::fromLatin1(hash.result().toHex());
+}
+
+QString ResultCache::packedProblemHash(const QByteArray &packed_problem,
+    const QString &engine_name, const QString &engine_version,
+    const QStringList &command_format)
+{
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  for (const QString &field : {engine_name, engine_version, command_format.join(" ")}) {
+    hash.addData(field.toUtf8());
+    hash.addData("\n", 1);
+  }
+  hash.addData(packed_problem);
+  return QString::fromLatin1(hash.result().toHex());
+}
+
+QString ResultCache::packedDesignHash(const QByteArray &packed_problem)
+{
+  // skip the simulation parameters which the packed problem starts with
+  QDataStream ds(packed_problem);
+  ds.setByteOrder(QDataStream::LittleEndian);
+  quint32 param_count = 0;
+  ds >> param_count;
+  for (quint32 i=0; i<2*param_count && ds.status() == QDataStream::Ok; i++) {
+    quint32 length = 0;
+    ds >> length;
+    if (ds.skipRawData(static_cast<int>(length)) != static_cast<int>(length))
+      return QString();
+  }
+  if (ds.status() != QDataStream::Ok)
+    return QString();
+
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  hash.addData(packed_problem.mid(static_cast<int>(ds.device()->pos())));
+  return QString::fromLatin1(hash.result().toHex());
+}
+
+QString ResultCache::lookup(const QString &hash)
+{
+  if (hash.isEmpty())
+    return QString();
+  QString path = QDir(cacheDirPath()).absoluteFilePath(hash + ".xml");
+  return QFileInfo(path).exists() ? path : QString();
+}
+
+bool ResultCache::store(const QString &hash, const QString &result_path)
+{
+  if (hash.isEmpty())
+    return false;
+  QDir cache_dir(cacheDirPath());
+  cache_dir.mkpath(".");
+
+  // copy to a temporary file first so that concurrent lookups never see a
+  // partially written result
+  QString path = cache_dir.absoluteFilePath(hash + ".xml");
+  QString tmp_path = path + ".writing";
+  QFile::remove(tmp_path);
+  if (!QFile::copy(result_path, tmp_path)) {
+    qWarning() << QObject::tr("Unable to copy result %1 to the result cache.")
+      .arg(result_path);
+    return false;
+  }
+  QFile::remove(path);
+  return QFile::rename(tmp_path, path);
+}
+
+void ResultCache::remove(const QString &hash)
+{
+  if (!hash.isEmpty())
+    QFile::remove(QDir(cacheDirPath()).absoluteFilePath(hash + ".xml"));
+}
+
+QFileInfoList ResultCache::cachedResults()
+{
+  return QDir(cacheDirPath()).entryInfoList(QStringList("*.xml"), QDir::Files,
+      QDir::Time | QDir::Reversed);
+}
+
+void ResultCache::removeStaleFiles()
+{
+  // stores in progress elsewhere, e.g. in another instance, are left alone
+  QDateTime stale_time = QDateTime::currentDateTime().addSecs(-3600);
+  for (const QFileInfo &info : QDir(cacheDirPath()).entryInfoList(
+        QStringList("*.xml.writing"), QDir::Files)) {
+    if (info.lastModified() < stale_time)
+      QFile::remove(info.absoluteFilePath());
+  }
+}
+
+QString ResultCache::cacheDirPath()
+{
+  QString tmp_root = settings::AppSettings::instance()->getPath("plugs/runtime_tmp_root_path");
+  return QDir(tmp_root).absoluteFilePath("result_cache");
+}
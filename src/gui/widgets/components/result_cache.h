@@ -0,0 +1,71 @@
+/** @file:     result_cache.h
+ *  @author:   Samuel
+ *  @created:  2020.06.20
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     Content-addressed cache of simulation results keyed by a
+ *             canonical hash of the simulation problem.
+ */
+
+#ifndef _COMP_RESULT_CACHE_H_
+#define _COMP_RESULT_CACHE_H_
+
+#include <QtCore>
+
+namespace comp{
+
+  //! Local cache of job step results in the plugin runtime temp root. Entries
+  //! are keyed by problemHash(), which only depends on the content relevant to
+  //! the simulation outcome: the engine, its command format and simulation
+  //! parameters and the design items, regardless of their order or of file
+  //! metadata such as the export date.
+  class ResultCache
+  {
+  public:
+
+    //! Return the canonical hash of the problem file at the given path for the
+    //! specified engine, or an empty string if the file cannot be read.
+    static QString problemHash(const QString &problem_path,
+        const QString &engine_name, const QString &engine_version,
+        const QStringList &command_format);
+
+
+    //! Return the hash of a problem packed by DesignModel::packedSimProblem(),
+    //! which is canonical by construction, for the specified engine.
+    static QString packedProblemHash(const QByteArray &packed_problem,
+        const QString &engine_name, const QString &engine_version,
+        const QStringList &command_format);
+
+    //! Return the hash of only the design in a packed problem, which
+    //! identifies the same design across engines and simulation parameters.
+    //! Returns an empty string if the packed problem is malformed.
+    static QString packedDesignHash(const QByteArray &packed_problem);
+
+    //! Return the path of the cached result for the given hash, or an empty
+    //! string if there is no cached result.
+    static QString lookup(const QString &hash);
+
+    //! Store a copy of the result file under the given hash and return whether
+    //! it was successful.
+    static bool store(const QString &hash, const QString &result_path);
+
+    //! Remove the cached result for the given hash, e.g. if it turned out to
+    //! be unreadable.
+    static void remove(const QString &hash);
+
+    //! Return the files of all cached results, least recently stored first.
+    //! The cache has no size limit of its own, JobCatalog::cleanUp() counts it
+    //! against the runtime temp quota.
+    static QFileInfoList cachedResults();
+
+    //! Remove partially written files left behind by stores which were
+    //! interrupted at least an hour ago, e.g. by a crash.
+    static void removeStaleFiles();
+
+    //! Return the cache directory.
+    static QString cacheDirPath();
+  };
+
+} // end of comp namespace
+
+#endif
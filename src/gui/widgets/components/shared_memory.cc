@@ -0,0 +1,133 @@
+// @file:     shared_memory.cc
+// @author:   Samuel
+// @created:  2020.06.23
+// @license:  GNU LGPL v3
+//
+// @desc:     PosixSharedMemory implementation
+
+#include "shared_memory.h"
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+using namespace comp;
+
+namespace {
+
+#ifdef Q_OS_UNIX
+  QByteArray shmPath(const QString &name)
+  {
+    return "/" + name.toLatin1();
+  }
+#endif
+
+}
+
+bool PosixSharedMemory::supported()
+{
+#ifdef Q_OS_UNIX
+  return true;
+#else
+  return false;
+#endif
+}
+
+QString PosixSharedMemory::uniqueName(const QString &tag)
+{
+  // short names since macOS limits them to 31 characters
+  static QAtomicInt counter;
+  return QString("sq%1_%2_%3").arg(QCoreApplication::applicationPid())
+    .arg(counter.fetchAndAddRelaxed(1)).arg(tag);
+}
+
+bool PosixSharedMemory::create(const QString &name, const char *magic,
+    quint32 version, const QByteArray &payload)
+{
+#ifdef Q_OS_UNIX
+  int fd = shm_open(shmPath(name).constData(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd == -1) {
+    qWarning() << QObject::tr("Unable to create shared memory segment %1: %2")
+      .arg(name).arg(strerror(errno));
+    return false;
+  }
+
+  size_t size = header_size + payload.size();
+  void *mem = MAP_FAILED;
+  if (ftruncate(fd, size) == 0)
+    mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) {
+    qWarning() << QObject::tr("Unable to map shared memory segment %1: %2")
+      .arg(name).arg(strerror(errno));
+    unlink(name);
+    return false;
+  }
+
+  uchar *bytes = static_cast<uchar*>(mem);
+  memcpy(bytes, magic, 4);
+  qToLittleEndian<quint32>(version, bytes + 4);
+  qToLittleEndian<quint64>(payload.size(), bytes + 8);
+  memcpy(bytes + header_size, payload.constData(), payload.size());
+  munmap(mem, size);
+  return true;
+#else
+  Q_UNUSED(name); Q_UNUSED(magic); Q_UNUSED(version); Q_UNUSED(payload);
+  return false;
+#endif
+}
+
+bool PosixSharedMemory::read(const QString &name, const char *magic,
+    QByteArray &payload)
+{
+#ifdef Q_OS_UNIX
+  int fd = shm_open(shmPath(name).constData(), O_RDONLY, 0);
+  if (fd == -1) {
+    qWarning() << QObject::tr("Unable to open shared memory segment %1: %2")
+      .arg(name).arg(strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  void *mem = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size >= header_size)
+    mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) {
+    qWarning() << QObject::tr("Shared memory segment %1 is too small or "
+        "cannot be mapped.").arg(name);
+    return false;
+  }
+
+  const uchar *bytes = static_cast<const uchar*>(mem);
+  quint64 payload_size = qFromLittleEndian<quint64>(bytes + 8);
+  bool valid = memcmp(bytes, magic, 4) == 0
+    && payload_size <= static_cast<quint64>(st.st_size - header_size);
+  if (valid) {
+    payload = QByteArray(reinterpret_cast<const char*>(bytes + header_size),
+        static_cast<int>(payload_size));
+  } else {
+    qWarning() << QObject::tr("Shared memory segment %1 has an invalid header.")
+      .arg(name);
+  }
+  munmap(mem, st.st_size);
+  return valid;
+#else
+  Q_UNUSED(name); Q_UNUSED(magic); Q_UNUSED(payload);
+  return false;
+#endif
+}
+
+void PosixSharedMemory::unlink(const QString &name)
+{
+#ifdef Q_OS_UNIX
+  shm_unlink(shmPath(name).constData());
+#else
+  Q_UNUSED(name);
+#endif
+}
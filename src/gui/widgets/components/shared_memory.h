@@ -0,0 +1,53 @@
+/** @file:     shared_memory.h
+ *  @author:   Samuel
+ *  @created:  2020.06.23
+ *  @license:  GNU LGPL v3
+ *
+ *  @desc:     POSIX shared memory segments for exchanging simulation problems
+ *             and results with plugins without going through files.
+ */
+
+#ifndef _COMP_SHARED_MEMORY_H_
+#define _COMP_SHARED_MEMORY_H_
+
+#include <QtCore>
+
+namespace comp{
+
+  //! Named POSIX shared memory segments. Unlike QSharedMemory, the segments
+  //! can be opened by plugins written in any language, e.g. with shm_open in
+  //! C or multiprocessing.shared_memory in Python. Names are given without
+  //! the leading slash required by shm_open.
+  //!
+  //! Segments exchanged with plugins start with a 16 byte header made of a
+  //! four character magic, a little-endian uint32 format version and a
+  //! little-endian uint64 size of the payload following the header.
+  class PosixSharedMemory
+  {
+  public:
+
+    //! Return whether shared memory segments are supported on this platform.
+    static bool supported();
+
+    //! Return a segment name which is unique to this SiQAD instance.
+    static QString uniqueName(const QString &tag);
+
+    //! Create a segment holding the header and the payload. Returns whether
+    //! the segment was created, existing segments are not overwritten.
+    static bool create(const QString &name, const char *magic, quint32 version,
+        const QByteArray &payload);
+
+    //! Read the payload of a segment whose header has the given magic. Returns
+    //! whether the segment exists and has a valid header.
+    static bool read(const QString &name, const char *magic, QByteArray &payload);
+
+    //! Remove the segment name, the memory is freed once no process has it
+    //! mapped anymore.
+    static void unlink(const QString &name);
+
+    static const int header_size=16;
+  };
+
+} // end of comp namespace
+
+#endif
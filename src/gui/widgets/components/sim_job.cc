@@ -11,15 +11,25 @@
 #include <iostream>
 #include <algorithm>
 #include "sim_job.h"
+#include "design_model.h"
+#include "result_budget.h"
+#include "job_catalog.h"
 #include "../../../global.h"
 
 using namespace comp;
 
+namespace {
+  // header magic of result segments written by plugins
+  const char *shm_result_magic = "SQRX";
+}
+
 // JobStep implementation
 JobStep::JobStep(PluginEngine *t_engine, QStringList t_command_format,
                  gui::PropertyMap t_job_prop_map)
   : engine(t_engine), command_format(t_command_format)
 {
+  engine_name = engine->name();
+  engine_version = engine->version();
   for (const QString &key : t_job_prop_map.keys()) {
     job_params.insert(key, t_job_prop_map.value(key).value.toString());
   }
@@ -27,6 +37,7 @@ JobStep::JobStep(PluginEngine *t_engine, QStringList t_command_format,
 
 JobStep::JobStep(QXmlStreamReader *rs, QDir job_root_dir)
 {
+  bool result_types_read = false;
   job_tmp_dir_path = job_root_dir.absolutePath();
   while (rs->readNextStartElement()) {
     if (rs->name() == "placement") {
@@ -35,21 +46,61 @@ JobStep::JobStep(QXmlStreamReader *rs, QDir job_root_dir)
       auto&& meta_enum = QMetaEnum::fromType<JobStepState>();
       job_step_state = static_cast<JobStepState>(meta_enum.keyToValue(
             rs->readElementText().toLocal8Bit()));
+    } else if (rs->name() == "engine_name") {
+      engine_name = rs->readElementText();
+    } else if (rs->name() == "engine_version") {
+      engine_version = rs->readElementText();
     } else if (rs->name() == "command") {
       // TODO implement
       rs->skipCurrentElement();
+    } else if (rs->name() == "command_format") {
+      while (rs->readNextStartElement())
+        command_format.append(rs->readElementText());
+    } else if (rs->name() == "sim_params") {
+      while (rs->readNextStartElement()) {
+        QString key = rs->name().toString();
+        job_params.insert(key, rs->readElementText());
+      }
     } else if (rs->name() == "step_dir") {
       js_tmp_dir_path = job_root_dir.absoluteFilePath(rs->readElementText());
     } else if (rs->name() == "problem_path") {
       problem_path = job_root_dir.absoluteFilePath(rs->readElementText());
     } else if (rs->name() == "result_path") {
       result_path = job_root_dir.absoluteFilePath(rs->readElementText());
+    } else if (rs->name() == "resource_policy") {
+      res_policy.readXml(rs);
+    } else if (rs->name() == "timed_out") {
+      timed_out = rs->readElementText().toInt();
+    } else if (rs->name() == "problem_hash") {
+      problem_hash = rs->readElementText();
+    } else if (rs->name() == "design_hash") {
+      design_hash = rs->readElementText();
+    } else if (rs->name() == "from_cache") {
+      from_cache = rs->readElementText().toInt();
+    } else if (rs->name() == "resources") {
+      res_usage.readXml(rs);
+    } else if (rs->name() == "result_types") {
+      auto&& meta_enum = QMetaEnum::fromType<JobResult::ResultType>();
+      while (rs->readNextStartElement()) {
+        bool ok;
+        int type = meta_enum.keyToValue(rs->readElementText().toLatin1(), &ok);
+        if (ok)
+          result_types.append(static_cast<JobResult::ResultType>(type));
+      }
+      result_types_read = true;
     } else {
       qWarning() << tr("Unknown XML element encountered when importing JobStep:"
          " %1").arg(rs->name().toString());
       rs->skipCurrentElement();
     }
   }
+  if (job_step_state == Running)
+    job_step_state = FinishedWithError;
+
+  // results and logs are only read once they're needed
+  logs_imported = false;
+  if (!result_types_read)
+    scanResultTypes();
   qDebug() << tr("JobStep info: problem path %1, result_path %2").arg(problem_path).arg(result_path);
 }
 
@@ -57,6 +108,8 @@ JobStep::~JobStep()
 {
   if (process != nullptr)
     delete process;
+  unlinkSharedMemory();
+  unloadResults();
 }
 
 void JobStep::writeManifest(QXmlStreamWriter *ws)
@@ -64,17 +117,50 @@ void JobStep::writeManifest(QXmlStreamWriter *ws)
   ws->writeStartElement("job_step");
   ws->writeTextElement("placement", QString::number(placement));
   ws->writeTextElement("state", QVariant::fromValue(job_step_state).toString());
+  ws->writeTextElement("engine_name", engine_name);
+  ws->writeTextElement("engine_version", engine_version);
 
   ws->writeStartElement("command");
   for (QString line : command)
     ws->writeTextElement("line", line);
   ws->writeEndElement();
 
+  // the command format and parameters allow the step to be invoked again when
+  // the job is resumed
+  ws->writeStartElement("command_format");
+  for (const QString &line : command_format)
+    ws->writeTextElement("line", line);
+  ws->writeEndElement();
+  ws->writeStartElement("sim_params");
+  for (auto it = job_params.cbegin(); it != job_params.cend(); ++it)
+    ws->writeTextElement(it.key(), it.value());
+  ws->writeEndElement();
+
   QDir job_root_dir = QDir(job_tmp_dir_path);
   ws->writeComment("Paths below are relative to SimJob manifest");
   ws->writeTextElement("step_dir", job_root_dir.relativeFilePath(js_tmp_dir_path));
   ws->writeTextElement("problem_path", job_root_dir.relativeFilePath(problem_path));
   ws->writeTextElement("result_path", job_root_dir.relativeFilePath(result_path));
+
+  if (!res_policy.isEmpty())
+    res_policy.writeXml(ws);
+  if (timed_out)
+    ws->writeTextElement("timed_out", "1");
+  if (!problem_hash.isEmpty())
+    ws->writeTextElement("problem_hash", problem_hash);
+  if (!design_hash.isEmpty())
+    ws->writeTextElement("design_hash", design_hash);
+  if (from_cache)
+    ws->writeTextElement("from_cache", "1");
+  if (res_usage.isValid())
+    res_usage.writeXml(ws);
+  if (!resultTypes().isEmpty()) {
+    auto&& meta_enum = QMetaEnum::fromType<JobResult::ResultType>();
+    ws->writeStartElement("result_types");
+    for (JobResult::ResultType type : resultTypes())
+      ws->writeTextElement("type", meta_enum.valueToKey(type));
+    ws->writeEndElement();
+  }
   ws->writeEndElement();
 }
 
@@ -102,6 +188,13 @@ void JobStep::prepareJobStep(const int &t_placement,
   result_path = !t_result_path.isEmpty()    ? t_result_path
     : js_tmp_dir.absoluteFilePath(tr("sim_result_%1.xml").arg(placement));
 
+  // name the shared memory segments, they are created once the problem is
+  // exported (problem) or by the plugin (result)
+  if (usesSharedMemoryProblem())
+    shm_problem_name = PosixSharedMemory::uniqueName(QString("p%1").arg(placement));
+  if (usesSharedMemoryResult())
+    shm_result_name = PosixSharedMemory::uniqueName(QString("r%1").arg(placement));
+
   // other pre-invocation settings
   if (command_format.isEmpty()) {
     // default command format
@@ -118,8 +211,13 @@ bool JobStep::invokeBinary()
     return false;
   }
 
-  // check if problem file exists
-  if (!QFileInfo(problem_path).exists()) {
+  // check if the problem has been exported
+  if (usesSharedMemoryProblem()) {
+    if (packed_problem_hash.isEmpty()) {
+      qDebug() << tr("SimJob: problem segment '%1' hasn't been created.").arg(shm_problem_name);
+      return false;
+    }
+  } else if (!QFileInfo(problem_path).exists()) {
     qDebug() << tr("SimJob: problem file '%1' doesn't exist.").arg(problem_path);
     return false;
   }
@@ -132,30 +230,39 @@ bool JobStep::invokeBinary()
 
   job_step_state = Running;
 
+  // serve the step with a persistent worker if the plugin supports them and
+  // the step uses the default command, workers don't take per step commands
+  // and only exchange files
+  if (!engine->commandFormats().isEmpty()
+      && command_format == engine->commandFormats().first().second
+      && !usesSharedMemoryProblem() && !usesSharedMemoryResult()) {
+    worker = PluginWorkerPool::instance()->acquire(engine, res_policy);
+    if (worker != nullptr)
+      return invokeWorker();
+  }
+
   qDebug() << tr("Job step %1 about to execute command: %2")
     .arg(placement).arg(command.join(" "));
 
-  // set up process
-  process = new QProcess();
+  // set up process, the resource policy is applied to the child before the
+  // program is executed
+  process = new PolicyProcess(res_policy);
   process->setProcessChannelMode(QProcess::MergedChannels); // TODO doesn't seem to be working now, check
   process->setProgram(command.takeFirst());
   process->setArguments(command);
 
-  start_time = QDateTime::currentDateTime();
-
-  qDebug() << tr("Starting step step process %1").arg(placement);
-  process->start();
-
-  // block SiQAD process until the plugin process has started
-  qDebug() << tr("Waiting for process start success signal...");
-  if (!process->waitForStarted()) {
-    qCritical() << tr("Failed to start plugin process.");
-    return false;
-  } else {
-    qDebug() << "Job step process started successfully.";
-  }
+  // the launch completes asynchronously, a failure to start is reported
+  // through the finish state signal like any other failure
+  connect(process, &QProcess::started,
+          [this]()
+          {
+            qDebug() << tr("Job step %1 process started successfully.").arg(placement);
+            startMonitoring(process->processId());
+          });
+  connect(process, &QProcess::errorOccurred,
+          this, &JobStep::processLaunchError);
 
-  // connect signals for error and finish
+  // connect signals for finish
   connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
           this, &JobStep::processJobStepCompletion);
 
@@ -171,9 +278,58 @@ bool JobStep::invokeBinary()
             std_err.append(QString::fromUtf8(process->readAllStandardError()));
           });
 
+  start_time = QDateTime::currentDateTime();
+  qDebug() << tr("Starting job step process %1").arg(placement);
+  process->start();
   return true;
 }
 
+bool JobStep::invokeWorker()
+{
+  qDebug() << tr("Job step %1 served by %2 worker with PID %3")
+    .arg(placement).arg(engine->name()).arg(worker->processId());
+
+  start_time = QDateTime::currentDateTime();
+  // workers serve several steps, only usage since now belongs to this one
+  if (worker->isStarted())
+    startMonitoring(worker->processId(), true);
+  else
+    connect(worker, &PluginWorker::sig_started,
+            this, [this](qint64 pid) {startMonitoring(pid, true);});
+
+  connect(worker, &PluginWorker::sig_standardOutput,
+          this, [this](const QString &out) {std_out.append(out);});
+  connect(worker, &PluginWorker::sig_standardError,
+          this, [this](const QString &err) {std_err.append(err);});
+  connect(worker, &PluginWorker::sig_requestFinished, this,
+          [this](int t_exit_code, QProcess::ExitStatus t_exit_status)
+          {
+            // return the worker first so that the next step can reuse it
+            disconnect(worker, nullptr, this, nullptr);
+            PluginWorkerPool::instance()->release(worker);
+            worker = nullptr;
+            processJobStepCompletion(t_exit_code, t_exit_status);
+          });
+
+  worker->submit(problem_path, result_path, js_tmp_dir_path);
+  return true;
+}
+
+void JobStep::startMonitoring(qint64 pid, bool reused_process)
+{
+  // monitor the resource usage of the process and its descendants
+  res_monitor = new ProcessTreeMonitor(this);
+  res_monitor->start(pid, reused_process);
+
+  // enforce the wall-clock limit
+  if (res_policy.timeout_s > 0) {
+    timeout_timer = new QTimer(this);
+    timeout_timer->setSingleShot(true);
+    connect(timeout_timer, &QTimer::timeout, this, &JobStep::processTimeout);
+    timeout_timer->start(qMin(res_policy.timeout_s, INT_MAX / 1000) * 1000);
+  }
+}
+
 bool JobStep::readResults(bool attempt_import_logs)
 {
   if (results_read) {
@@ -181,15 +337,14 @@ bool JobStep::readResults(bool attempt_import_logs)
     return true;
   }
 
-  QFile result_file(result_path);
-
-  if(!result_file.open(QFile::ReadOnly | QFile::Text)){
-    qDebug() << tr("Error when opening job step result file to read: %1").arg(result_file.errorString());
+  QScopedPointer<QIODevice> result_file(openFile(result_path));
+  if (result_file.isNull()) {
+    qDebug() << tr("Error when opening job step result file to read: %1").arg(result_path);
     return false;
   }
 
-  QXmlStreamReader rs(&result_file);
-  qDebug() << tr("Reading simulation results from %1...").arg(result_file.fileName());
+  QXmlStreamReader rs(result_file.data());
+  qDebug() << tr("Reading simulation results from %1...").arg(result_path);
 
   // TODO store the following variables to the class itself
   QString engine_name = "";
@@ -236,6 +391,13 @@ bool JobStep::readResults(bool attempt_import_logs)
       job_results.insert(comp::JobResult::ChargeConfigsResult,
                          new comp::ChargeConfigSet(&rs));
     } else if (rs.name() == "potential_map") {
+      // plots are passed on by path so they have to be extracted
+      if (archive != nullptr) {
+        QDir result_dir = QFileInfo(result_path).absoluteDir();
+        for (const QString &plot_file_name : comp::PotentialLandscape::plotFileNames())
+          if (archive->contains(result_dir.absoluteFilePath(plot_file_name)))
+            archive->extract(result_dir.absoluteFilePath(plot_file_name));
+      }
       job_results.insert(comp::JobResult::PotentialLandscapeResult,
                          new comp::PotentialLandscape(&rs, QFileInfo(resultPath()).absolutePath()));
     } else if (rs.name() == "sqcommands") {
@@ -265,30 +427,108 @@ bool JobStep::readResults(bool attempt_import_logs)
   // try to read std out and std error from log files if indicated (normally 
   // these are acquired from the QProcess, so only applicable when importing 
   // a job from manifest.)
-  auto importLogFromFilePath = [](QString &s, const QString &fpath)
+  if (attempt_import_logs)
+    importLogs();
+
+  qDebug() << tr("Successfully read job step result.");
+  result_file->close();
+
+  results_read = true;
+  result_types = job_results.keys();
+  ResultMemoryBudget::instance()->touch(this);
+  return true;
+}
+
+QMap<comp::JobResult::ResultType, comp::JobResult*> JobStep::jobResults()
+{
+  if (!results_read && !result_types.isEmpty()) {
+    if (!readResults()) {
+      // don't attempt to read an unreadable result file again
+      qWarning() << tr("Results of job step %1 are unavailable.").arg(placement);
+      result_types.clear();
+    }
+  } else if (results_read) {
+    ResultMemoryBudget::instance()->touch(this);
+  }
+  return job_results;
+}
+
+qint64 JobStep::resultMemoryUsage() const
+{
+  qint64 bytes = 0;
+  for (JobResult *result : job_results)
+    bytes += result->memoryUsage();
+  return bytes;
+}
+
+void JobStep::unloadResults()
+{
+  ResultMemoryBudget::instance()->remove(this);
+  qDeleteAll(job_results);
+  job_results.clear();
+  results_read = false;
+}
+
+QIODevice *JobStep::openFile(const QString &path) const
+{
+  if (archive != nullptr)
+    return archive->open(path, QIODevice::ReadOnly | QIODevice::Text);
+
+  QFile *file = new QFile(path);
+  if (!file->open(QFile::ReadOnly | QFile::Text)) {
+    delete file;
+    return nullptr;
+  }
+  return file;
+}
+
+void JobStep::importLogs()
+{
+  auto importLogFromFilePath = [this](QString &s, const QString &fpath)
   {
-    QFile file(fpath);
-    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+    QScopedPointer<QIODevice> file(openFile(fpath));
+    if (file.isNull()) {
       qWarning() << tr("File cannot be opened for reading: %1").arg(fpath);
       return;
     }
-    s = QString(file.readAll());
+    s = QString(file->readAll());
   };
-  if (attempt_import_logs) {
-    QDir js_tmp_dir(js_tmp_dir_path);
-    importLogFromFilePath(std_out, js_tmp_dir.absoluteFilePath("runtime_stdout.log"));
-    importLogFromFilePath(std_err, js_tmp_dir.absoluteFilePath("runtime_stderr.log"));
-  }
+  QDir js_tmp_dir(js_tmp_dir_path);
+  importLogFromFilePath(std_out, js_tmp_dir.absoluteFilePath("runtime_stdout.log"));
+  importLogFromFilePath(std_err, js_tmp_dir.absoluteFilePath("runtime_stderr.log"));
+  logs_imported = true;
+}
 
-  qDebug() << tr("Successfully read job step result.");
-  result_file.close();
+void JobStep::scanResultTypes()
+{
+  QScopedPointer<QIODevice> result_file(openFile(result_path));
+  if (result_file.isNull())
+    return;
 
-  results_read = true;
-  return true;
+  // element names as handled by readResults
+  static const QMap<QString, JobResult::ResultType> element_types = {
+    {"physloc", JobResult::DBLocationsResult},
+    {"elec_dist", JobResult::ChargeConfigsResult},
+    {"potential_map", JobResult::PotentialLandscapeResult},
+    {"sqcommands", JobResult::SQCommandsResult}
+  };
+
+  QXmlStreamReader rs(result_file.data());
+  rs.readNextStartElement();  // enter root element
+  while (rs.readNextStartElement()) {
+    QString name = rs.name().toString();
+    if (element_types.contains(name) && !result_types.contains(element_types.value(name)))
+      result_types.append(element_types.value(name));
+    rs.skipCurrentElement();
+  }
 }
 
 void JobStep::exportTerminalOutputs(QString std_out_path, QString std_err_path)
 {
+  // logs of imported steps which haven't been read are already in place
+  if (!logs_imported)
+    return;
+
   // store std out and std error into file log
   auto writeToFilePath = [](const QString &s, const QString &fpath)
   {
@@ -306,6 +546,15 @@ void JobStep::exportTerminalOutputs(QString std_out_path, QString std_err_path)
 
 void JobStep::terminateJobStep()
 {
+  // the worker is lost as well since it can't be interrupted otherwise
+  if (worker != nullptr) {
+    worker->kill();
+    return;
+  }
+
+  // steps reusing cached results have no process
+  if (process == nullptr)
+    return;
 #ifdef _WIN32
   process->kill();
 #else
@@ -313,6 +562,141 @@ void JobStep::terminateJobStep()
 #endif
 }
 
+bool JobStep::updateJobParameters(const QMap<QString, QString> &params)
+{
+  if (params == job_params)
+    return true;
+  if (usesSharedMemoryProblem()) {
+    qWarning() << tr("Parameters of job step %1 can't be updated since its "
+        "problem was only placed in shared memory.").arg(placement);
+    return false;
+  }
+
+  // rewrite the exported problem with the new parameters
+  DesignModel problem;
+  if (!problem.loadFromFile(problem_path)) {
+    qWarning() << tr("Unable to read problem file %1").arg(problem_path);
+    return false;
+  }
+  QList<QPair<QString,QString>> sim_params;
+  for (auto it = params.cbegin(); it != params.cend(); ++it)
+    sim_params.append(qMakePair(it.key(), it.value()));
+  if (!problem.writeSimProblem(problem_path, sim_params))
+    return false;
+  setExportedProblem(problem.packedSimProblem(sim_params));
+  job_params = params;
+  return true;
+}
+
+bool JobStep::resetForResume()
+{
+  if (engine == nullptr) {
+    qWarning() << tr("Job step %1 can't be resumed, plugin %2 is not available.")
+      .arg(placement).arg(engine_name);
+    return false;
+  }
+  if (engine->version() != engine_version) {
+    qWarning() << tr("Job step %1 was run with %2 version %3 and is resumed "
+        "with version %4.").arg(placement).arg(engine_name)
+      .arg(engine_version).arg(engine->version());
+    engine_version = engine->version();
+  }
+  if (usesSharedMemoryProblem() || !QFileInfo(problem_path).exists()) {
+    qWarning() << tr("Job step %1 can't be resumed, its problem file %2 is "
+        "not available.").arg(placement).arg(problem_path);
+    return false;
+  }
+
+  // discard the previous run, files in the step directory are left alone
+  if (process != nullptr) {
+    process->deleteLater();
+    process = nullptr;
+  }
+  delete res_monitor;
+  res_monitor = nullptr;
+  delete timeout_timer;
+  timeout_timer = nullptr;
+  unloadResults();
+  result_types.clear();
+  logs_imported = true;
+  job_step_state = NotInvoked;
+  start_time = end_time = QDateTime();
+  std_out.clear();
+  std_err.clear();
+  exit_code = -1;
+  res_usage = ResourceUsage();
+  timed_out = false;
+  from_cache = false;
+  QFile::remove(result_path);
+
+  // regenerate the command, e.g. for a plugin which has moved since
+  prepareJobStep(placement, job_tmp_dir_path, js_tmp_dir_path, problem_path,
+      result_path);
+  return true;
+}
+
+bool JobStep::setSharedMemoryProblem(const QByteArray &packed_problem)
+{
+  packed_problem_hash.clear();
+  PosixSharedMemory::unlink(shm_problem_name);
+  if (!PosixSharedMemory::create(shm_problem_name, DesignModel::packed_problem_magic,
+        DesignModel::packed_problem_version, packed_problem))
+    return false;
+  setExportedProblem(packed_problem);
+  return true;
+}
+
+void JobStep::setExportedProblem(const QByteArray &packed_problem)
+{
+  packed_problem_hash = ResultCache::packedProblemHash(packed_problem,
+      engine_name, engine_version, command_format);
+  design_hash = ResultCache::packedDesignHash(packed_problem);
+}
+
+void JobStep::computeProblemHash()
+{
+  if (!packed_problem_hash.isEmpty()) {
+    problem_hash = packed_problem_hash;
+    return;
+  }
+  // e.g. imported steps from before problem hashes were recorded
+  if (problem_hash.isEmpty())
+    problem_hash = ResultCache::problemHash(problem_path, engine_name,
+        engine_version, command_format);
+}
+
+bool JobStep::reuseCachedResult()
+{
+  QString cached_path = ResultCache::lookup(problem_hash);
+  if (cached_path.isEmpty())
+    return false;
+
+  qDebug() << tr("Job step %1 reusing cached result %2").arg(placement)
+    .arg(cached_path);
+  QFile::remove(result_path);
+  if (!QFile::copy(cached_path, result_path) || !readResults()) {
+    qWarning() << tr("Cached result %1 is unusable, removing it from the cache.")
+      .arg(cached_path);
+    ResultCache::remove(problem_hash);
+    return false;
+  }
+
+  from_cache = true;
+  unlinkSharedMemory();
+  start_time = end_time = QDateTime::currentDateTime();
+  exit_code = 0;
+  exit_status = QProcess::NormalExit;
+  job_step_state = FinishedNormally;
+  std_out = tr("Result reused from the result cache: %1\n").arg(cached_path);
+
+  // keep the completion asynchronous like a process invocation
+  QTimer::singleShot(0, this, [this]()
+      {
+        emit sig_jobStepFinishState(placement, true);
+      });
+  return true;
+}
+
 void JobStep::processJobStepCompletion(int t_exit_code, QProcess::ExitStatus t_exit_status)
 {
   exit_code = t_exit_code, exit_status = t_exit_status;
@@ -321,14 +705,98 @@ void JobStep::processJobStepCompletion(int t_exit_code, QProcess::ExitStatus t_e
     .arg(placement).arg(exit_code).arg(str_exit_status);
   end_time = QDateTime::currentDateTime();
 
-  bool successful = (exit_code == 0) && (exit_status == QProcess::NormalExit);
-  if (successful)
+  if (timeout_timer != nullptr)
+    timeout_timer->stop();
+
+  if (res_monitor != nullptr) {
+    res_monitor->stop();
+    res_usage = res_monitor->usage();
+    qDebug() << tr("Job step %1 resource usage: %2").arg(placement)
+      .arg(res_usage.summary());
+  }
+
+  bool successful = (exit_code == 0) && (exit_status == QProcess::NormalExit)
+    && !timed_out;
+  if (successful && usesSharedMemoryResult())
+    successful = readSharedMemoryResult();
+  unlinkSharedMemory();
+  job_step_state = successful ? FinishedNormally : FinishedWithError;
+  if (successful) {
     readResults();
+    // only results which could be read are worth reusing
+    if (cache_result && results_read && !problem_hash.isEmpty())
+      ResultCache::store(problem_hash, result_path);
+  }
 
   // inform the parent of the success state.
   emit sig_jobStepFinishState(placement, successful);
 }
 
+bool JobStep::readSharedMemoryResult()
+{
+  QByteArray result_xml;
+  if (!PosixSharedMemory::read(shm_result_name, shm_result_magic, result_xml)) {
+    std_err.append(tr("The plugin didn't write a valid result segment %1.\n")
+        .arg(shm_result_name));
+    return false;
+  }
+
+  QFile result_file(result_path);
+  if (!result_file.open(QFile::WriteOnly)) {
+    qWarning() << tr("Unable to write result file %1").arg(result_path);
+    return false;
+  }
+  result_file.write(result_xml);
+  return true;
+}
+
+void JobStep::unlinkSharedMemory()
+{
+  if (!shm_problem_name.isEmpty())
+    PosixSharedMemory::unlink(shm_problem_name);
+  if (!shm_result_name.isEmpty())
+    PosixSharedMemory::unlink(shm_result_name);
+}
+
+void JobStep::processLaunchError(QProcess::ProcessError error)
+{
+  // other errors are followed by the finished signal
+  if (error != QProcess::FailedToStart)
+    return;
+
+  QString msg = tr("Failed to start the process of job step %1: %2")
+    .arg(placement).arg(process->errorString());
+  qCritical() << msg;
+  std_err.append(msg + "\n");
+  end_time = QDateTime::currentDateTime();
+  job_step_state = FinishedWithError;
+  unlinkSharedMemory();
+  emit sig_jobStepFinishState(placement, false);
+}
+
+void JobStep::processTimeout()
+{
+  if (worker == nullptr
+      && (process == nullptr || process->state() == QProcess::NotRunning))
+    return;
+
+  timed_out = true;
+  QString msg = tr("Job step %1 exceeded the wall-clock limit of %2 s, "
+      "terminating.").arg(placement).arg(res_policy.timeout_s);
+  qWarning() << msg;
+  std_err.append(msg + "\n");
+  terminateJobStep();
+  if (process == nullptr)
+    return;
+
+  // kill the process if it ignores the termination request
+  QTimer::singleShot(5000, process, [this]()
+      {
+        if (process->state() != QProcess::NotRunning)
+          process->kill();
+      });
+}
+
 bool JobStep::commandKeywordReplacement()
 {
   // keywords are not properly initialized if prepareJobStep hasn't been called
@@ -345,6 +813,8 @@ bool JobStep::commandKeywordReplacement()
   replace_map["@PHYSENGPATH@"] = QFileInfo(engine->descriptionFilePath()).absolutePath();
   replace_map["@PROBLEMPATH@"] = problem_path;
   replace_map["@RESULTPATH@"] = result_path;
+  replace_map["@SHMPROBLEM@"] = shm_problem_name;
+  replace_map["@SHMRESULT@"] = shm_result_name;
   replace_map["@JOBTMP@"] = job_tmp_dir_path;
   replace_map["@STEPTMP@"] = js_tmp_dir_path;
 
@@ -369,35 +839,24 @@ bool JobStep::commandKeywordReplacement()
 // SimJob implementation
 
 SimJob::SimJob(const QString &nm, QWidget *parent)
-  : QObject(parent), job_state(NotInvoked), job_name(nm), gui_ctrl_elems(this)
+  : QObject(parent), job_state(NotInvoked), job_name(nm),
+    status_text(tr("Not Started"))
 {}
 
 SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override, 
     QWidget *parent)
-  : QObject(parent), job_state(FinishedNormally), gui_ctrl_elems(this),
-    imported(true)
+  : QObject(parent), job_state(FinishedNormally), imported(true),
+    from_import(true)
 {
   QString manifest_path;
-  gui_ctrl_elems.pb_terminate->setDisabled(true);
-
-  auto find_manifest = [](QDir xdir)
-  {
-    QDirIterator it(xdir, QDirIterator::Subdirectories);
-    while (it.hasNext()) {
-      it.next();
-      if (it.fileInfo().fileName() == "manifest.xml") {
-        return it.fileInfo().absoluteFilePath();
-      }
-    }
-    return QString();
-  };
 
   // lambda function for importing job steps
-  auto importJobSteps = [this](QXmlStreamReader &rs, QFile &file)
+  auto importJobSteps = [this](QXmlStreamReader &rs, const QDir &job_dir)
   {
     while (rs.readNextStartElement()) {
       if (rs.name() == "job_step") {
-        job_steps.append(new JobStep(&rs, QFileInfo(file).dir()));
+        job_steps.append(new JobStep(&rs, job_dir));
+        job_steps.last()->setArchive(archive);
       } else {
         qWarning() << tr("Unknown XML tag encountered when importing job steps:"
            " %1").arg(rs.name().toString());
@@ -406,34 +865,43 @@ SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override,
     }
   };
 
-  // decompress the archive if dcmp flag is true
+  // read archives in place if dcmp flag is true, files are only extracted
+  // when they're needed on disk
   if (dcmp) {
-    qDebug() << "Decompressing SimJob archive...";
+    qDebug() << "Opening SimJob archive...";
     QString tmpd = settings::AppSettings::instance()->getPath("plugs/runtime_tmp_root_path");
     QDir xdir(QDir(tmpd).absoluteFilePath("IM_" + QDateTime::currentDateTime().toString("yyMMdd_HHmmss")));
-    zipper::Unzipper unzipper(fpath.toStdString());
-    unzipper.extract(xdir.absolutePath().toStdString());
-    qDebug() << "Searching for SimJob manifest...";
-    manifest_path = find_manifest(xdir);
-    if (manifest_path.isEmpty()) {
+    archive.reset(new JobArchive(fpath, xdir.absolutePath()));
+    if (!archive->isValid()) {
       QMessageBox msg;
       msg.setText("manifest.xml not found in the provided archive. Import halted.");
       msg.exec();
       job_state = FinishedWithError;
-      gui_ctrl_elems.pb_terminate->setText("Import Error");
+      setStatusText(tr("Import Error"));
       return;
     }
+    manifest_path = archive->manifestPath();
   } else {
     manifest_path = fpath;
   }
 
   // get file and XML stream
-  QFile file(manifest_path);
-  if (!file.open(QFile::ReadOnly | QFile::Text)) {
-    qWarning() << tr("Error when opening file to read: %1").arg(file.errorString());
-    return;
+  QByteArray manifest_data;
+  if (archive != nullptr) {
+    if (!archive->read(manifest_path, manifest_data)) {
+      qWarning() << tr("Error when reading manifest from archive %1").arg(fpath);
+      return;
+    }
+  } else {
+    QFile file(manifest_path);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+      qWarning() << tr("Error when opening file to read: %1").arg(file.errorString());
+      return;
+    }
+    manifest_data = file.readAll();
+    file.close();
   }
-  QXmlStreamReader rs(&file);
+  QXmlStreamReader rs(manifest_data);
 
   // read manifest from stream
   qDebug() << "Reading SimJob manifest";
@@ -461,8 +929,10 @@ SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override,
     } else if (rs.name() == "time_end") {
       // TODO implement
       rs.skipCurrentElement();
+    } else if (rs.name() == "use_result_cache") {
+      use_result_cache = rs.readElementText().toInt();
     } else if (rs.name() == "job_steps") {
-      importJobSteps(rs, file);
+      importJobSteps(rs, QFileInfo(manifest_path).absoluteDir());
     } else {
       qWarning() << tr("Unknown XML tag encountered when importing SimJob: %1")
         .arg(rs.name().toString());
@@ -477,18 +947,22 @@ SimJob::SimJob(const QString &fpath, bool dcmp, QString name_override,
     job_name = name_override;
   }
 
-  // import results
-  qDebug() << "Reading JobStep results";
+  // results are read when they're first accessed, only their types are
+  // needed up front
   for (JobStep *js : job_steps) {
-    js->readResults(true);
-    for (comp::JobResult::ResultType type : js->jobResults().keys()) {
+    for (comp::JobResult::ResultType type : js->resultTypes()) {
       result_type_step_map.insert(type, js);
     }
   }
-  gui_ctrl_elems.pb_terminate->setText("Imported");
+  setStatusText(tr("Imported"));
 
-  // clean up
-  file.close();
+  // a job which was still running when its manifest was last written has
+  // been interrupted
+  if (job_state == Running)
+    job_state = FinishedWithError;
+
+  // step paths are relative to the manifest, resumed steps run in place
+  job_tmp_dir_path = QFileInfo(manifest_path).absolutePath();
 }
 
 SimJob::~SimJob()
@@ -528,6 +1002,7 @@ void SimJob::writeManifest(QXmlStreamWriter *ws)
   if (end_time.isValid()) {
     ws->writeTextElement("time_end", QVariant::fromValue(end_time).toString());
   }
+  ws->writeTextElement("use_result_cache", QString::number(use_result_cache));
 
   // all job steps
   ws->writeStartElement("job_steps");
@@ -580,8 +1055,9 @@ bool SimJob::beginJob()
 
   qDebug() << "Beginning job step invocation.";
   job_state = Running;
-  curr_step = job_steps.at(0);
-  return job_steps.at(0)->invokeBinary();
+  setStatusText(tr("Running"));
+  JobCatalog::instance()->record(this);
+  return invokeJobStep(job_steps.at(0));
 }
 
 void SimJob::continueJob(int prev_step_ind, bool prev_step_successful)
@@ -594,17 +1070,16 @@ void SimJob::continueJob(int prev_step_ind, bool prev_step_successful)
 
   qDebug() << tr("Received step completion notice from job step %1.").arg(prev_step_ind);
 
-  qDebug() << tr("Prev step engine name %1").arg(job_steps[0]->pluginEngine()->name());
+  qDebug() << tr("Prev step engine name %1").arg(job_steps[prev_step_ind]->engineName());
   qDebug() << tr("job_steps.length=%1").arg(job_steps.length());
 
-  for (comp::JobResult::ResultType type : job_steps.at(prev_step_ind)->jobResults().keys())
+  for (comp::JobResult::ResultType type : job_steps.at(prev_step_ind)->resultTypes())
     result_type_step_map.insert(type, job_steps.at(prev_step_ind));
 
   int i = prev_step_ind + 1;
   if (i < job_steps.length()) {
     // invoke next step if any
-    job_steps.at(i)->invokeBinary();
-    curr_step = job_steps.at(i);
+    invokeJobStep(job_steps.at(i));
   } else {
     // wrap up job if no more steps
     curr_step = nullptr;
@@ -613,30 +1088,102 @@ void SimJob::continueJob(int prev_step_ind, bool prev_step_successful)
   writeManifest();
 }
 
+bool SimJob::invokeJobStep(JobStep *job_step)
+{
+  curr_step = job_step;
+  job_step->computeProblemHash();
+  job_step->setCacheResult(use_result_cache);
+  if (use_result_cache && job_step->reuseCachedResult())
+    return true;
+  if (!job_step->invokeBinary()) {
+    qWarning() << tr("Job step %1 could not be invoked, ceasing job.")
+      .arg(job_step->jobStepPlacement());
+    jobFinishActions(FinishedWithError);
+    return false;
+  }
+  return true;
+}
+
+int SimJob::firstUnfinishedStep() const
+{
+  for (int i=0; i<job_steps.length(); i++)
+    if (job_steps.at(i)->jobStepState() != JobStep::FinishedNormally)
+      return i;
+  return -1;
+}
+
+bool SimJob::resumeJob()
+{
+  int first_step = firstUnfinishedStep();
+  if (!resumable())
+    return false;
+
+  // resumed jobs run and are exported from the job directory, so the rest of
+  // an archived job has to be extracted
+  if (archive != nullptr) {
+    if (!archive->extractDir(job_tmp_dir_path)) {
+      qWarning() << tr("Unable to extract job %1 for resuming.").arg(job_name);
+      return false;
+    }
+  }
+
+  for (int i=first_step; i<job_steps.length(); i++) {
+    if (!job_steps.at(i)->resetForResume())
+      return false;
+  }
+
+  // results of finished steps are kept, the others are read once they finish
+  result_type_step_map.clear();
+  for (int i=0; i<first_step; i++) {
+    for (comp::JobResult::ResultType type : job_steps.at(i)->resultTypes())
+      result_type_step_map.insert(type, job_steps.at(i));
+  }
+
+  // imported steps haven't been connected
+  for (JobStep *job_step : job_steps) {
+    connect(job_step, &comp::JobStep::sig_jobStepFinishState,
+            this, &SimJob::continueJob, Qt::UniqueConnection);
+  }
+
+  placement_confirmed = true;
+  imported = false;
+  end_time = QDateTime();
+
+  qDebug() << tr("Resuming job %1 from step %2.").arg(job_name).arg(first_step);
+  job_state = Running;
+  setStatusText(tr("Running"));
+  writeManifest();
+  JobCatalog::instance()->record(this);
+  return invokeJobStep(job_steps.at(first_step));
+}
+
 void SimJob::terminateJob()
 {
   if (curr_step != nullptr)
     curr_step->terminateJobStep();
 }
 
+void SimJob::setStatusText(const QString &t_status_text)
+{
+  status_text = t_status_text;
+  emit sig_statusChanged(this);
+}
+
 void SimJob::jobFinishActions(JobState t_job_state)
 {
   job_state = t_job_state;
   switch(job_state)
   {
     case FinishedWithError:
-      gui_ctrl_elems.pb_terminate->setText("Error");
+      setStatusText(tr("Error"));
       break;
     case FinishedNormally:
-    {
-      gui_ctrl_elems.pb_terminate->setText("Finished");
-      gui_ctrl_elems.pb_export_results->setEnabled(true);
+      setStatusText(tr("Finished"));
       break;
-    }
     default:
       break;
   }
-  gui_ctrl_elems.pb_terminate->setDisabled(true);
+  JobCatalog::instance()->record(this);
   emit sig_jobFinishState(this, job_state);
 }
 
@@ -765,6 +1312,12 @@ bool SimJob::exportJob(QString out_path)
     msg.exec();
     return false;
   }
+  if (exporting()) {
+    QMessageBox msg;
+    msg.setText("The SimJob is already being exported.");
+    msg.exec();
+    return false;
+  }
   if (out_path.isNull()) {
     out_path = QFileDialog::getSaveFileName(nullptr, 
         tr("Export SimJob"), name() + ".sqjx.zip");
@@ -781,12 +1334,41 @@ bool SimJob::exportJob(QString out_path)
         js_tmp_dir.absoluteFilePath("runtime_stderr.log"));
   }
 
-  // throw everything to archive
-  zipper::Zipper zipper(out_path.toStdString());
-  zipper.add(job_tmp_dir_path.toStdString());
-  zipper.close();
-
-  qDebug() << tr("SimJob exported successfully to %1").arg(out_path);
+  // compress on a worker thread, the dialog deletes itself when closed and
+  // the export is deleted once it has ended
+  job_export = new JobExport(job_tmp_dir_path, out_path,
+      JobExport::Options::fromSettings(), this);
+  QProgressDialog *pd_export = new QProgressDialog(
+      tr("Exporting %1...").arg(name()), tr("Cancel"), 0, 0);
+  pd_export->setAttribute(Qt::WA_DeleteOnClose);
+  pd_export->setWindowTitle(tr("Export SimJob"));
+  pd_export->setMinimumDuration(500);
+  pd_export->setAutoReset(false);
+  pd_export->setAutoClose(false);
+  JobExport *exp = job_export;
+  connect(pd_export, &QProgressDialog::canceled, exp, &JobExport::cancel);
+  connect(exp, &QObject::destroyed, pd_export, &QWidget::close);
+  connect(exp, &JobExport::sig_progress, pd_export,
+          [pd_export](int files_done, int files_total)
+          {
+            pd_export->setMaximum(files_total);
+            pd_export->setValue(files_done);
+          });
+  connect(exp, &JobExport::sig_finished, this,
+          [this, exp, pd_export](bool success, bool cancelled)
+          {
+            if (success)
+              qDebug() << tr("SimJob exported successfully to %1").arg(exp->outPath());
+            else if (cancelled)
+              qDebug() << tr("Export of SimJob %1 was cancelled").arg(name());
+            else
+              qWarning() << tr("Export of SimJob %1 failed").arg(name());
+            pd_export->close();
+            exp->deleteLater();
+            emit sig_exportFinished(this, success);
+          });
+  job_export->start();
+  emit sig_statusChanged(this);
 
   return true;
 }
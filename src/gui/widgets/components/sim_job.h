@@ -13,6 +13,14 @@
 #include <QtWidgets>
 #include <QtCore>
 #include "plugin_engine.h"
+#include "resource_monitor.h"
+#include "resource_policy.h"
+#include "result_cache.h"
+#include "plugin_worker.h"
+#include "shared_memory.h"
+#include "result_budget.h"
+#include "job_archive.h"
+#include "job_export.h"
 #include "job_results/job_result_types.h"
 #include "settings/settings.h" // TODO probably need this later
 #include <tuple> //std::tuple for 3+ article data structure, std::get for accessing the tuples
@@ -60,9 +68,63 @@ namespace comp{
     //! Invoke the job step binary and return whether the process set-up 
     //! procedure was successful. Cannot be invoked if confirmJobStepsPlacement()
     //! has not been called or was unsuccessful in the parent sim job.
-    //! Returns whether the binary has been invoked successfully.
+    //! The step is served by a persistent worker instead if the plugin
+    //! supports them and the step uses the default command.
+    //! The process is started without waiting for it, a failure to start is
+    //! reported through sig_jobStepFinishState.
     bool invokeBinary();
 
+    //! Return whether the command hands the problem to the plugin as a shared
+    //! memory segment (@SHMPROBLEM@) instead of a problem file.
+    bool usesSharedMemoryProblem() const
+    {
+      return command_format.join(" ").contains("@SHMPROBLEM@");
+    }
+
+    //! Return whether the plugin writes the result to a shared memory segment
+    //! (@SHMRESULT@) instead of the result file.
+    bool usesSharedMemoryResult() const
+    {
+      return command_format.join(" ").contains("@SHMRESULT@");
+    }
+
+    //! Place the problem packed by DesignModel::packedSimProblem() in the
+    //! problem segment, replacing the problem file export for steps which use
+    //! shared memory problems. Returns whether the segment was created.
+    bool setSharedMemoryProblem(const QByteArray &packed_problem);
+
+    //! Record the exported problem in the form packed by
+    //! DesignModel::packedSimProblem(). The problem hash is computed from it
+    //! so that the problem file doesn't have to be read again.
+    void setExportedProblem(const QByteArray &packed_problem);
+
+    //! Replace the simulation parameters of a step whose problem has already
+    //! been exported, rewriting the problem file. Returns whether successful.
+    bool updateJobParameters(const QMap<QString, QString> &params);
+
+    //! Discard the run state, results and outputs of an unfinished step of an
+    //! imported job so that it can be invoked again. Files in the step
+    //! directory are kept, so plugins may continue from checkpoint files they
+    //! left in @STEPTMP@. The plugin engine must have been set and the
+    //! problem file must still exist. Returns whether the step can be invoked.
+    bool resetForResume();
+
+    //! Compute the canonical hash of the exported problem. The hash recorded
+    //! with setExportedProblem() or read from the manifest is used if
+    //! available, the problem file is only parsed for steps lacking both.
+    void computeProblemHash();
+
+    //! Set whether a successful result is stored in the result cache, which
+    //! requires a problem hash.
+    void setCacheResult(bool cache) {cache_result = cache;}
+
+    //! Look up the result of an identical problem in the result cache and
+    //! reuse it instead of invoking the binary. Returns whether a cached
+    //! result was reused, in which case the completion signal is emitted
+    //! once control returns to the event loop. computeProblemHash() must have
+    //! been called.
+    bool reuseCachedResult();
+
     //! Process the job finish signal.
     void processJobStepCompletion(int t_exit_code, QProcess::ExitStatus t_exit_status);
 
@@ -83,6 +145,19 @@ namespace comp{
     //! Return the engine pointer.
     PluginEngine *pluginEngine() {return engine;}
 
+    //! Set the engine of an imported job step, which only knows the engine
+    //! name and version, before the job is resumed.
+    void setPluginEngine(PluginEngine *t_engine) {engine = t_engine;}
+
+    //! Return the job step state.
+    JobStepState jobStepState() const {return job_step_state;}
+
+    //! Return the engine name, also available for imported job steps.
+    QString engineName() const {return engine_name;}
+
+    //! Return the engine version, also available for imported job steps.
+    QString engineVersion() const {return engine_version;}
+
     //! Return the simulation parameters.
     QMap<QString, QString> jobParameters() {return job_params;}
 
@@ -98,9 +173,35 @@ namespace comp{
     //! Return the end time.
     QDateTime endTime() {return end_time;}
 
+    //! Return the resource usage of the job step process tree.
+    ResourceUsage resourceUsage() const {return res_usage;}
+
+    //! Set the resource policy applied when the binary is invoked.
+    void setResourcePolicy(const ResourcePolicy &policy) {res_policy = policy;}
+
+    //! Return the resource policy.
+    ResourcePolicy resourcePolicy() const {return res_policy;}
+
+    //! Return whether the process was terminated for exceeding the wall-clock
+    //! limit of the resource policy.
+    bool timedOut() const {return timed_out;}
+
+    //! Return the canonical problem hash, empty if it hasn't been computed.
+    QString problemHash() const {return problem_hash;}
+
+    //! Return the hash of only the design of the exported problem, see
+    //! ResultCache::packedDesignHash(). Empty if the problem wasn't exported
+    //! in this or a recorded session.
+    QString designHash() const {return design_hash;}
+
+    //! Return whether the result was reused from the result cache.
+    bool fromCache() const {return from_cache;}
+
     //! Return the terminal output from the specified channel.
     QString terminalOutput(QProcess::ProcessChannel channel)
     {
+      if (!logs_imported)
+        importLogs();
       switch (channel) {
         case QProcess::StandardOutput:
           return std_out;
@@ -111,12 +212,41 @@ namespace comp{
       }
     }
 
-    //! Return the job results.
-    QMap <comp::JobResult::ResultType, comp::JobResult*> jobResults() {return job_results;}
+    //! Return the job results, reading them from the result file if they
+    //! haven't been read yet or have been unloaded to meet the result memory
+    //! budget.
+    QMap <comp::JobResult::ResultType, comp::JobResult*> jobResults();
+
+    //! Return whether the results are currently loaded, i.e. jobResults()
+    //! doesn't have to read the result file.
+    bool resultsLoaded() const {return results_read;}
+
+    //! Return the types of the job results without reading them.
+    QList<comp::JobResult::ResultType> resultTypes() const
+    {
+      return results_read ? job_results.keys() : result_types;
+    }
+
+    //! Return an estimate of the memory held by the loaded results in bytes.
+    qint64 resultMemoryUsage() const;
+
+    //! Release the loaded results, they are read again on the next access.
+    void unloadResults();
 
     //! Return the job step tmp directory path.
     QString jobStepTempDirPath() const {return js_tmp_dir_path;}
 
+    //! Set the archive an imported job step is read from.
+    void setArchive(QSharedPointer<JobArchive> t_archive) {archive = t_archive;}
+
+    //! Make sure that a file of this step, e.g. the problem file, exists on
+    //! disk by extracting it if the step is read from an archive. Returns
+    //! whether the file exists.
+    bool ensureLocalFile(const QString &path)
+    {
+      return QFileInfo(path).exists() || (archive && archive->extract(path));
+    }
+
   signals:
 
     //! Emit job step completion status.
@@ -130,8 +260,45 @@ namespace comp{
     //! replacements can be done to a certain path.
     bool commandKeywordReplacement();
 
+    //! Open a file of this step for reading, from the archive if the step is
+    //! read from one and the file hasn't been extracted. Returns a null
+    //! pointer on failure, the caller takes ownership of the device.
+    QIODevice *openFile(const QString &path) const;
+
+    //! Read the terminal outputs of an imported step from the log files in
+    //! the step directory.
+    void importLogs();
+
+    //! Determine the result types of an imported step from the top level
+    //! elements of its result file, for manifests which don't record them.
+    void scanResultTypes();
+
+    //! Serve the job step with the acquired persistent worker.
+    bool invokeWorker();
+
+    //! Copy the result segment written by the plugin to the result file, so
+    //! that results are read, cached and exported as usual. Returns whether
+    //! the segment was valid.
+    bool readSharedMemoryResult();
+
+    //! Unlink the shared memory segments of this step, if any.
+    void unlinkSharedMemory();
+
+    //! Start monitoring the resource usage and wall-clock limit of the
+    //! process serving this step. Set reused_process for processes which
+    //! served other requests before, see ProcessTreeMonitor::start().
+    void startMonitoring(qint64 pid, bool reused_process=false);
+
+    //! Report a process which failed to start as a failed job step.
+    void processLaunchError(QProcess::ProcessError error);
+
+    //! Terminate the process once the wall-clock limit is exceeded.
+    void processTimeout();
+
     // variables from GUI/initial setup
-    PluginEngine *engine;
+    PluginEngine *engine=nullptr;
+    QString engine_name;                    // engine name, kept for imported steps
+    QString engine_version;                 // engine version, kept for imported steps
     QStringList command_format;
     QMap<QString, QString> job_params;
 
@@ -140,10 +307,16 @@ namespace comp{
     JobStepState job_step_state=NotInvoked; // job step run state
     QStringList command;                    // the invocation command
     QProcess *process=nullptr;              // the program process
+    PluginWorker *worker=nullptr;           // persistent worker serving this step, if any
     QString job_tmp_dir_path;               // temp directory shared among steps
     QString js_tmp_dir_path;                // temp directory dedicated to this job step
     QString problem_path;                   // problem file path
     QString result_path;                    // result file path
+    QSharedPointer<JobArchive> archive;     // archive an imported step is read from, if any
+    QString shm_problem_name;               // problem segment name if @SHMPROBLEM@ is used
+    QString shm_result_name;                // result segment name if @SHMRESULT@ is used
+    QString packed_problem_hash;            // hash of the exported problem in packed form
+    ResourcePolicy res_policy;              // limits applied to the process
 
     // post-invocation, runtime-related variables
     QDateTime start_time;                   // start time of this job step
@@ -152,9 +325,19 @@ namespace comp{
     QString std_err;                        // stderr from process
     int exit_code=-1;                       // exit code of the process, -1 if haven't invoked nor finished
     QProcess::ExitStatus exit_status;       // exit status of the process (normal or crashed)
+    ProcessTreeMonitor *res_monitor=nullptr;// resource usage monitor of the running process
+    ResourceUsage res_usage;                // resource usage of the process tree
+    QTimer *timeout_timer=nullptr;          // enforces the wall-clock limit
+    bool timed_out=false;                   // whether the wall-clock limit was exceeded
+    QString problem_hash;                   // canonical problem hash, key in the result cache
+    QString design_hash;                    // hash of the design of the exported problem
+    bool from_cache=false;                  // whether the result was reused from the result cache
+    bool cache_result=false;                // whether to store the result in the result cache
 
     // post-invocation, results-related variables
     bool results_read=false;                // indicates whether results have been read
+    bool logs_imported=true;                // false for imported steps until their logs are read
+    QList<comp::JobResult::ResultType> result_types;  // result types, known without reading the results
     QMap<comp::JobResult::ResultType, comp::JobResult*> job_results;  // store job results
   };
 
@@ -168,39 +351,6 @@ namespace comp{
 
   public:
 
-    struct GuiControlElems {
-      GuiControlElems(SimJob *job) : job(job)
-      {
-        pb_terminate = new QPushButton("Terminate");
-        pb_job_terminal = new QPushButton("Log");
-        pb_sim_visualize = new QPushButton("Visualize Results");
-        pb_export_results = new QPushButton("Export Results");
-
-        connect(pb_job_terminal, &QPushButton::clicked,
-                [job](){job->terminalOutputDialog()->show();});
-        connect(pb_terminate, &QPushButton::clicked,
-                [job](){
-                  QMessageBox msg;
-                  msg.setText("Are you sure that you would like to terminate the job?\nNote: multi-threaded plugins may leave behind orphaned children processes depending on implementation.");
-                  msg.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-                  msg.setDefaultButton(QMessageBox::No);
-                  if (msg.exec() == QMessageBox::Yes) {
-                    job->terminateJob();
-                  }
-                });
-        connect(pb_sim_visualize, &QPushButton::clicked,
-                [job](){emit job->sig_requestJobVisualization(job);});
-        connect(pb_export_results, &QPushButton::clicked,
-                [job](){job->exportJob();});
-      }
-
-      SimJob *job=nullptr;
-      QPushButton *pb_terminate=nullptr;
-      QPushButton *pb_job_terminal=nullptr;
-      QPushButton *pb_sim_visualize=nullptr;
-      QPushButton *pb_export_results=nullptr;
-    };
-
     enum JobState{NotInvoked, Running, FinishedWithError, FinishedNormally};
     Q_ENUM(JobState);
 
@@ -249,6 +399,13 @@ namespace comp{
     //! Return the inclusion area.
     gui::DesignInclusionArea inclusionArea() {return inclusion_area;}
 
+    //! Set whether job steps may reuse results of identical problems from the
+    //! result cache instead of invoking their binaries.
+    void setUseResultCache(bool use) {use_result_cache = use;}
+
+    //! Return whether job steps may reuse cached results.
+    bool useResultCache() const {return use_result_cache;}
+
 
     // JOB EXECUTION
 
@@ -267,6 +424,28 @@ namespace comp{
     //! Continue the job if previous step was successful, stop it otherwise.
     void continueJob(int prev_step_ind, bool prev_step_successful);
 
+    //! Reuse the cached result of the job step if allowed and available,
+    //! invoke its binary otherwise. Returns whether either was successful,
+    //! the job is finished with error if not.
+    //! Results of invoked binaries are stored in the result cache either way.
+    bool invokeJobStep(JobStep *job_step);
+
+    //! Return the index of the first job step which hasn't finished normally,
+    //! -1 if all have.
+    int firstUnfinishedStep() const;
+
+    //! Return whether the job can be resumed, i.e. it isn't running and has
+    //! a step which hasn't finished normally.
+    bool resumable() const
+    {
+      return job_state != Running && firstUnfinishedStep() != -1;
+    }
+
+    //! Resume the job from the first unfinished step, keeping the results of
+    //! the steps before it. Engines of imported steps must have been set with
+    //! JobStep::setPluginEngine(). Returns whether the job has resumed.
+    bool resumeJob();
+
     //! Terminal the running job step process and prevent remaining job steps 
     //! from executing.
     void terminateJob();
@@ -311,6 +490,10 @@ namespace comp{
     //! Runtime temporary directory (all job steps share the same dir).
     QString runtimeTempPath();
 
+    //! Return the job directory without creating it, empty if the job hasn't
+    //! been prepared yet.
+    QString jobTempDirPath() const {return job_tmp_dir_path;}
+
     //! Return the overall start time of the job (start time of the first step).
     QDateTime startTime() const {return job_steps.first()->startTime();}
 
@@ -320,8 +503,11 @@ namespace comp{
     //! Return the current job state.
     JobState jobState() const {return job_state;}
 
-    //! Return GUI control elements.
-    GuiControlElems guiControlElems() const {return gui_ctrl_elems;}
+    //! Return a short description of the job state shown in the job view.
+    QString statusText() const {return status_text;}
+
+    //! Return whether the job can be terminated.
+    bool terminable() const {return job_state == Running;}
 
     //! Return a QMap of result types mapped to job steps that have that type
     //! of result.
@@ -330,10 +516,22 @@ namespace comp{
     //! Show a dialog containing the job's terminal output.
     QWidget *terminalOutputDialog(QWidget *parent=nullptr, Qt::WindowFlags w_flags=Qt::Dialog);
 
-    //! Export the finished SimJob into an archive and return whether the export 
-    //! was successful.
+    //! Return whether the job was imported rather than run in this session,
+    //! which remains true when an imported job is resumed.
+    bool fromImport() const {return from_import;}
+
+    //! Return whether the job can be exported, i.e. it finished normally and
+    //! wasn't imported.
+    bool exportable() const {return !imported && job_state == FinishedNormally;}
+
+    //! Export the finished SimJob into an archive in the background, showing
+    //! its progress in a dialog which allows cancelling it. Asks for the
+    //! output path if none is given. Returns whether the export was started.
     bool exportJob(QString outpath=QString());
 
+    //! Return whether the job is being exported.
+    bool exporting() const {return !job_export.isNull() && job_export->isRunning();}
+
 
   signals:
 
@@ -346,21 +544,34 @@ namespace comp{
     //! Request the job results to be shown.
     void sig_requestJobVisualization(SimJob *job);
 
+    //! Emitted when the status text has changed.
+    void sig_statusChanged(SimJob *job);
+
+    //! Emitted once a job export has ended.
+    void sig_exportFinished(SimJob *job, bool success);
+
 
   private:
 
+    //! Set the status text and notify the job view.
+    void setStatusText(const QString &t_status_text);
+
     // variables
     JobState job_state;                 // the state of the job
     QList<JobStep*> job_steps;          // list of steps in this simulation job, each step invokes one simulation
     QMultiMap<comp::JobResult::ResultType, JobStep*> result_type_step_map;  // all result types contained in job steps
     bool placement_confirmed=false;     // the job steps execution order has been confirmed, must be true before execution begins
     gui::DesignInclusionArea inclusion_area=gui::IncludeEntireDesign;       // the inclusion area for this job
+    bool use_result_cache=true;         // whether job steps may reuse cached results
     QString job_name;                   // job name for identification
     QString job_tmp_dir_path;           // job directory for storing runtime data
     QDateTime start_time, end_time;     // start and end times of the job
     JobStep *curr_step=nullptr;
-    GuiControlElems gui_ctrl_elems;     // store GUI control elements
+    QString status_text;                // job state shown in the job view
     bool imported=false;
+    bool from_import=false;             // imported, resumed or not
+    QSharedPointer<JobArchive> archive; // archive the job was imported from, if any
+    QPointer<JobExport> job_export;     // export in progress, if any
 
     // read xml
     QStringList ignored_xml_elements; // XML elements to ignore when reading results
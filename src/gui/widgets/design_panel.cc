@@ -8,8 +8,10 @@
 
 #include "design_panel.h"
 #include "settings/settings.h"
+#include "components/profiler.h"
 
 #include <algorithm>
+#include <functional>
 
 QColor gui::DesignPanel::background_col;
 QColor gui::DesignPanel::background_col_publish;
@@ -72,6 +74,8 @@ void gui::DesignPanel::initDesignPanel(QString lattice_file_path, bool init_laye
   undo_stack = new QUndoStack();
   connect(undo_stack, SIGNAL(cleanChanged(bool)),
           this, SLOT(emitUndoStackCleanChanged(bool)));
+  connect(undo_stack, &QUndoStack::indexChanged,
+          this, &gui::DesignPanel::flushJournal);
 
   // initialize contained widgets
   layman = new LayerManager(this);
@@ -192,6 +196,9 @@ void gui::DesignPanel::deselectAll()
 // clear design panel
 void gui::DesignPanel::clearDesignPanel(bool reset)
 {
+  // stop journaling, the journal no longer applies to the design
+  setJournal(nullptr);
+
   // destroy DB previews
   destroyDBPreviews();
 
@@ -266,6 +273,8 @@ void gui::DesignPanel::addItem(prim::Item *item, int layer_index, int ind)
   // add Item
   layer->addItem(item, ind);
   scene->addItem(item);
+  journalItem(comp::DesignJournal::AddItem, layman->indexOf(layer),
+              ind < 0 ? layer->getItems().size()-1 : ind);
 
   updateSceneRect();
 
@@ -284,6 +293,10 @@ void gui::DesignPanel::removeItem(prim::Item *item, int layer_index, bool retain
 
 void gui::DesignPanel::removeItem(prim::Item *item, prim::Layer *layer, bool retain_item)
 {
+  if (journal != nullptr)
+    journalItem(comp::DesignJournal::RemoveItem, layman->indexOf(layer),
+                layer->getItems().indexOf(item));
+
   // if layer contains the item, delete and remove froms scene, otherwise
   // do nothing
   if(layer->removeItem(item)){
@@ -381,6 +394,7 @@ QList<prim::DBDot*> gui::DesignPanel::getAllDBs() const
 
 void gui::DesignPanel::buildLattice(QString fname)
 {
+  SQ_PROFILE_SCOPE("DesignPanel::buildLattice");
   if (fname.isEmpty()) {
     fname = settings::LatticeSettings::instance()->get<QString>("lattice/default_lattice_file_path");
   }
@@ -625,6 +639,108 @@ void gui::DesignPanel::writeToXmlStream(QXmlStreamWriter *ws,
   ws->writeEndElement(); // end of design node
 }
 
+comp::DesignModel gui::DesignPanel::designModel(DesignInclusionArea inclusion_area,
+                                                bool include_overlays) const
+{
+  comp::DesignModel model;
+
+  // displayed region in angstrom
+  QPointF tlpt = mapToScene(mapFromParent(rect().topLeft()));
+  QPointF brpt = mapToScene(mapFromParent(rect().bottomRight()));
+  model.setDisplayedRegion(QRectF(tlpt / prim::Item::scale_factor,
+                                  brpt / prim::Item::scale_factor));
+  model.setPixelsPerAngstrom(prim::Item::scale_factor);
+
+  // lattice definition
+  prim::Lattice *lat = layman->getLattice(true);
+  if (lat != nullptr) {
+    comp::DesignModel::LatticeDef lat_def;
+    lat_def.name = lat->latticeName();
+    lat_def.a[0] = lat->latticeVector(0);
+    lat_def.a[1] = lat->latticeVector(1);
+    lat_def.b = lat->siteVectors().toVector();
+    model.setLattice(lat_def);
+  }
+
+  // recursively add items, aggregate children are included if the aggregate is
+  std::function<void(prim::Item*, int, int)> addItemToModel;
+  addItemToModel = [&model, &addItemToModel](prim::Item *item, int lay, int agg)
+  {
+    switch (item->item_type) {
+      case prim::Item::DBDot:
+      {
+        prim::DBDot *db = static_cast<prim::DBDot*>(item);
+        prim::LatticeCoord lc = db->latticeCoord();
+        model.addDB(lc.n, lc.m, lc.l, lay, db->getCurrentFillColor().rgba(), agg);
+        break;
+      }
+      case prim::Item::Aggregate:
+      {
+        int agg_ind = model.addAggregate(lay, agg);
+        for (prim::Item *child : static_cast<prim::Aggregate*>(item)->getChildren())
+          addItemToModel(child, lay, agg_ind);
+        break;
+      }
+      case prim::Item::Electrode:
+      {
+        prim::Electrode *elec = static_cast<prim::Electrode*>(item);
+        comp::DesignModel::ElectrodeRecord rec;
+        rec.layer = lay;
+        rec.rect = QRectF(elec->sceneRect().topLeft() / prim::Item::scale_factor,
+                          elec->sceneRect().bottomRight() / prim::Item::scale_factor);
+        rec.angle = elec->getAngleDegrees();
+        rec.color = elec->getCurrentFillColor().rgba();
+        gui::PropertyMap props = elec->properties();
+        for (const QString &key : props.keys())
+          rec.properties.append(qMakePair(key, props[key].value.toString()));
+        model.addElectrode(rec);
+        break;
+      }
+      default:
+      {
+        // other top level items are kept as they would be saved
+        if (agg != -1)
+          break;
+        QByteArray xml;
+        QXmlStreamWriter ws(&xml);
+        item->saveItems(&ws);
+        if (!xml.isEmpty())
+          model.addXmlItem(lay, xml);
+        break;
+      }
+    }
+  };
+
+  for (int i=0; i<layman->layerCount(); i++) {
+    prim::Layer *layer = layman->getLayer(i);
+    if (layer == nullptr || layer->role() == prim::Layer::Result
+        || (layer->role() == prim::Layer::Overlay && !include_overlays))
+      continue;
+
+    comp::DesignModel::LayerRecord rec;
+    rec.name = layer->getName();
+    rec.type = layer->contentTypeString();
+    rec.role = layer->roleString();
+    rec.zoffset = layer->zOffset();
+    rec.zheight = layer->zHeight();
+    rec.visible = layer->isVisible();
+    rec.active = layer->isActive();
+    rec.layer_id = layer->layerID();
+    int lay = model.addLayer(rec);
+
+    if (layer->contentType() == prim::Layer::DB)
+      model.reserveDBs(model.dbCount() + layer->getItems().size());
+
+    for (prim::Item *item : layer->getItems()) {
+      if (inclusion_area == gui::IncludeSelectedItems && !item->isSelected())
+        continue;
+      addItemToModel(item, lay, -1);
+    }
+  }
+
+  return model;
+}
+
 void gui::DesignPanel::loadFromFile(QXmlStreamReader *rs, bool is_sim_result)
 {
   if (!is_sim_result) {
@@ -696,6 +812,367 @@ void gui::DesignPanel::loadFromFile(QXmlStreamReader *rs, bool is_sim_result)
 }
 
 
+void gui::DesignPanel::loadFromModel(const comp::DesignModel &model)
+{
+  typedef comp::DesignModel DM;
+
+  // reset the design panel state
+  resetDesignPanel("", false);
+
+  // lattice
+  if (model.lattice().isValid()) {
+    const DM::LatticeDef &lat_def = model.lattice();
+    QVector<QPointF> lat_vec({lat_def.a[0], lat_def.a[1]});
+    lattice->constructFromParams(lat_def.name, lat_def.b.toList(), lat_vec);
+  }
+
+  // layers, model layer index to design panel layer
+  QVector<prim::Layer*> layers(model.layers().size(), nullptr);
+  for (int i=0; i<model.layers().size(); i++) {
+    const DM::LayerRecord &rec = model.layers()[i];
+    prim::Layer::LayerType layer_type = static_cast<prim::Layer::LayerType>(
+        QMetaEnum::fromType<prim::Layer::LayerType>().keyToValue(
+          rec.type.toLatin1().constData()));
+    prim::Layer *lay;
+    switch (layer_type) {
+      case prim::Layer::Lattice:
+        lay = lattice;
+        lay->setZOffset(rec.zoffset);
+        lay->setZHeight(rec.zheight);
+        break;
+      case prim::Layer::DB:
+        lay = layman->addDBLayer(lattice, rec.name, prim::Layer::Design);
+        break;
+      default:
+        lay = layman->addLayer(rec.name, layer_type, prim::Layer::Design,
+            rec.zoffset, rec.zheight);
+        break;
+    }
+    if (lay == nullptr) {
+      qFatal("Layer initialization unsuccessful, please check the logs.");
+    }
+    lay->setVisible(rec.visible);
+    lay->setActive(rec.active);
+    layers[i] = lay;
+  }
+
+  // suspend scene indexing and view updates while items are inserted
+  setUpdatesEnabled(false);
+  scene->blockSignals(true);
+  QGraphicsScene::ItemIndexMethod index_method = scene->itemIndexMethod();
+  scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+
+  // DBs and child aggregates of each aggregate, in the order they were added
+  QVector<QList<int>> agg_dbs(model.aggregates().size());
+  QVector<QList<int>> agg_subaggs(model.aggregates().size());
+  for (int i=0; i<model.dbs().size(); i++)
+    if (model.dbs()[i].aggregate != -1)
+      agg_dbs[model.dbs()[i].aggregate].append(i);
+  for (int i=0; i<model.aggregates().size(); i++)
+    if (model.aggregates()[i].parent != -1)
+      agg_subaggs[model.aggregates()[i].parent].append(i);
+
+  auto createDB = [&model, &layers](int db_ind) -> prim::Item*
+  {
+    const DM::DBRecord &rec = model.dbs()[db_ind];
+    prim::Layer *lay = layers.value(rec.layer);
+    if (lay == nullptr || lay->contentType() != prim::Layer::DB)
+      return nullptr;
+    prim::Lattice *db_lat = static_cast<prim::DBLayer*>(lay)->getLattice();
+    prim::LatticeCoord lc(rec.n, rec.m, rec.l);
+    prim::DBDot *dbdot = new prim::DBDot(lc, lay->layerID());
+    if (qAlpha(rec.color) != 0)
+      dbdot->setColor(QColor::fromRgba(rec.color));
+    dbdot->setPos(db_lat->latticeCoord2ScenePos(lc));
+    db_lat->setOccupied(lc, dbdot);
+    return dbdot;
+  };
+
+  auto createElectrode = [&model, &layers](int elec_ind) -> prim::Item*
+  {
+    const DM::ElectrodeRecord &rec = model.electrodes()[elec_ind];
+    prim::Layer *lay = layers.value(rec.layer);
+    if (lay == nullptr)
+      return nullptr;
+    prim::Electrode *elec = new prim::Electrode(lay->layerID(),
+        QRectF(rec.rect.topLeft() * prim::Item::scale_factor,
+               rec.rect.bottomRight() * prim::Item::scale_factor));
+    if (qAlpha(rec.color) != 0)
+      elec->setColor(QColor::fromRgba(rec.color));
+    elec->setRotation(rec.angle);
+    gui::PropertyMap props = elec->properties();
+    for (const QPair<QString,QString> &prop : rec.properties) {
+      if (props.contains(prop.first))
+        elec->setProperty(prop.first, gui::PropertyMap::string2Type2QVariant(
+              prop.second, props.value(prop.first).value.userType()));
+    }
+    return elec;
+  };
+
+  // aggregates are formed from their children first, empty ones are dropped
+  std::function<prim::Item*(int)> createAggregate;
+  createAggregate = [&model, &layers, &agg_dbs, &agg_subaggs, &createDB,
+                     &createAggregate](int agg_ind) -> prim::Item*
+  {
+    const DM::AggregateRecord &rec = model.aggregates()[agg_ind];
+    prim::Layer *lay = layers.value(rec.layer);
+    if (lay == nullptr)
+      return nullptr;
+    QStack<prim::Item*> children;
+    for (int db_ind : agg_dbs[agg_ind])
+      if (prim::Item *child = createDB(db_ind))
+        children.push(child);
+    for (int subagg_ind : agg_subaggs[agg_ind])
+      if (prim::Item *child = createAggregate(subagg_ind))
+        children.push(child);
+    if (children.isEmpty())
+      return nullptr;
+    return new prim::Aggregate(lay->layerID(), children);
+  };
+
+  // top level items of each layer in the order of the model, items only kept
+  // as XML aren't instantiated just like when loading the file directly
+  QVector<QList<prim::Item*>> layer_items(layers.size());
+  for (const DM::ItemRef &ref : model.topLevelItems()) {
+    prim::Item *item = nullptr;
+    int lay = -1;
+    switch (ref.kind) {
+      case DM::DBItem:
+        item = createDB(ref.index);
+        lay = model.dbs()[ref.index].layer;
+        break;
+      case DM::ElectrodeItem:
+        item = createElectrode(ref.index);
+        lay = model.electrodes()[ref.index].layer;
+        break;
+      case DM::AggregateItem:
+        item = createAggregate(ref.index);
+        lay = model.aggregates()[ref.index].layer;
+        break;
+      default:
+        break;
+    }
+    if (item != nullptr)
+      layer_items[lay].append(item);
+  }
+
+  // add to layers and scene
+  for (int i=0; i<layers.size(); i++) {
+    if (layers[i] == nullptr || layer_items[i].isEmpty())
+      continue;
+    layers[i]->addItems(layer_items[i]);
+    for (prim::Item *item : layer_items[i])
+      scene->addItem(item);
+  }
+
+  scene->setItemIndexMethod(index_method);
+  scene->blockSignals(false);
+  setUpdatesEnabled(true);
+
+  initLayers();   // init missing layers
+  itman->updateTableAdd();
+
+  QRectF visrect;
+  if (!model.displayedRegion().isNull()) {
+    visrect = QRectF(model.displayedRegion().topLeft() * prim::Item::scale_factor,
+                     model.displayedRegion().bottomRight() * prim::Item::scale_factor);
+  }
+  updateSceneRect(visrect);
+  if (!visrect.isNull())
+    fitInView(visrect, Qt::KeepAspectRatio);
+
+  updateBackground();
+  informZoomUpdate();
+  layman->populateLayerTable();
+}
+
+bool gui::DesignPanel::replayJournal(const QVector<QVector<comp::DesignJournal::Op>> &records)
+{
+  typedef comp::DesignJournal DJ;
+
+  // changes made by the replay itself are not journaled
+  setJournal(nullptr);
+
+  // vacate the lattice sites of DBs contained in the given item
+  std::function<void(prim::Item*)> vacateSites;
+  vacateSites = [this, &vacateSites](prim::Item *item)
+  {
+    if (item->item_type == prim::Item::DBDot) {
+      prim::DBDot *db = static_cast<prim::DBDot*>(item);
+      if (lattice->dbAt(db->latticeCoord()) == db)
+        lattice->setUnoccupied(db->latticeCoord());
+    } else if (item->item_type == prim::Item::Aggregate) {
+      for (prim::Item *child : static_cast<prim::Aggregate*>(item)->getChildren())
+        vacateSites(child);
+    }
+  };
+
+  bool success = true;
+  for (const QVector<DJ::Op> &ops : records) {
+    for (const DJ::Op &op : ops) {
+      prim::Layer *layer = (op.layer > 0 && op.layer < layman->layerCount())
+          ? layman->getLayer(op.layer) : nullptr;
+      int item_count = layer ? layer->getItems().size() : 0;
+      if (layer == nullptr || op.index < 0 || op.index > item_count
+          || (op.type != DJ::AddItem && op.index == item_count)) {
+        qWarning() << tr("Journal replay: invalid item address, layer %1 item %2")
+          .arg(op.layer).arg(op.index);
+        success = false;
+        continue;
+      }
+
+      // removals and updates both remove the existing item first
+      if (op.type != DJ::AddItem) {
+        prim::Item *item = layer->getItem(op.index);
+        vacateSites(item);
+        removeItem(item, layer);
+      }
+
+      if (op.type != DJ::RemoveItem) {
+        QXmlStreamReader rs(op.item_xml);
+        rs.readNextStartElement();
+        if (layer->loadItem(&rs, scene, op.index) == 0) {
+          qWarning() << tr("Journal replay: unable to load item %1 on layer %2")
+            .arg(op.index).arg(op.layer);
+          success = false;
+        }
+      }
+    }
+  }
+
+  itman->updateTableAdd();
+  updateSceneRect();
+  return success;
+}
+
+void gui::DesignPanel::setJournal(comp::DesignJournal *t_journal)
+{
+  journal = t_journal;
+  journal_ops.clear();
+}
+
+void gui::DesignPanel::setHotPathTracing(bool enable)
+{
+  if (enable == hotPathTracing())
+    return;
+
+  if (enable) {
+    hot_path_hists.fill(comp::LatencyHistogram(), HotPathCount);
+    painted_item_counts.reset();
+    if (hot_path_overlay == nullptr) {
+      hot_path_overlay = new QLabel(viewport());
+      hot_path_overlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+      hot_path_overlay->setStyleSheet("QLabel {background-color: rgba(0,0,0,160);"
+          "color: white; font-family: monospace; padding: 4px;}");
+      hot_path_overlay->move(8, 8);
+      connect(&hot_path_overlay_timer, &QTimer::timeout,
+              this, &gui::DesignPanel::updateHotPathOverlay);
+    }
+    updateHotPathOverlay();
+    hot_path_overlay->show();
+    // the overlay is refreshed on a timer rather than on paint so that it
+    // doesn't distort the measurements
+    hot_path_overlay_timer.start(500);
+  } else {
+    hot_path_overlay_timer.stop();
+    hot_path_overlay->hide();
+    hot_path_hists.clear();
+  }
+}
+
+QJsonObject gui::DesignPanel::hotPathStats() const
+{
+  static const char *path_names[HotPathCount] = {"mouseMoveEvent", "wheelZoom",
+    "applyZoom", "updateBackground", "snapGhost", "rubberBandSelect", "paint"};
+
+  auto histJson = [](const comp::LatencyHistogram &hist)
+  {
+    return QJsonObject{{"count", hist.count()}, {"mean", hist.mean()},
+      {"p50", hist.percentile(50)}, {"p99", hist.percentile(99)},
+      {"max", hist.max()}};
+  };
+
+  QJsonObject stats;
+  if (!hotPathTracing())
+    return stats;
+  QJsonObject latencies;
+  for (int i=0; i<HotPathCount; i++)
+    latencies.insert(path_names[i], histJson(hot_path_hists[i]));
+  stats.insert("latency_us", latencies);
+  stats.insert("items_painted_per_frame", histJson(painted_item_counts));
+  // summed per layer rather than scene->items(), which would build a list of
+  // every item between the frames being measured
+  stats.insert("item_count", layman->itemCount());
+  return stats;
+}
+
+bool gui::DesignPanel::exportHotPathStats(const QString &path) const
+{
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    qWarning() << tr("Unable to write hot path statistics to %1: %2")
+      .arg(path).arg(file.errorString());
+    return false;
+  }
+  file.write(QJsonDocument(hotPathStats()).toJson());
+  file.close();
+  qDebug() << tr("Hot path statistics written to %1").arg(path);
+  return true;
+}
+
+void gui::DesignPanel::updateHotPathOverlay()
+{
+  if (!hotPathTracing())
+    return;
+
+  QJsonObject stats = hotPathStats();
+  QJsonObject latencies = stats.value("latency_us").toObject();
+  QStringList lines;
+  lines << tr("%1 %2 %3 %4").arg("path", -18).arg("n", 8).arg("p50 us", 9).arg("p99 us", 9);
+  for (const QString &name : latencies.keys()) {
+    QJsonObject hist = latencies.value(name).toObject();
+    lines << tr("%1 %2 %3 %4").arg(name, -18)
+      .arg(hist.value("count").toInt(), 8)
+      .arg(hist.value("p50").toInt(), 9)
+      .arg(hist.value("p99").toInt(), 9);
+  }
+  QJsonObject painted = stats.value("items_painted_per_frame").toObject();
+  lines << tr("items painted per frame: p50 %1, p99 %2 (of %3)")
+    .arg(painted.value("p50").toInt())
+    .arg(painted.value("p99").toInt())
+    .arg(stats.value("item_count").toInt());
+  hot_path_overlay->setText(lines.join("\n"));
+  hot_path_overlay->adjustSize();
+}
+
+void gui::DesignPanel::journalItem(comp::DesignJournal::OpType type,
+                                   int layer_index, int item_index)
+{
+  if (journal == nullptr || !journal->isOpen() || item_index < 0)
+    return;
+
+  comp::DesignJournal::Op op{type, layer_index, item_index, QByteArray()};
+  if (type != comp::DesignJournal::RemoveItem) {
+    prim::Item *item = layman->getLayer(layer_index)->getItem(item_index);
+    if (item == 0) {
+      qWarning() << tr("Journal: no item %1 on layer %2").arg(item_index).arg(layer_index);
+      return;
+    }
+    QXmlStreamWriter ws(&op.item_xml);
+    ws.setAutoFormatting(true);
+    item->saveItems(&ws);
+  }
+  journal_ops.append(op);
+}
+
+void gui::DesignPanel::flushJournal()
+{
+  if (journal != nullptr && !journal_ops.isEmpty())
+    journal->append(journal_ops);
+  journal_ops.clear();
+}
+
+
 void gui::DesignPanel::loadGUIFlags(QXmlStreamReader *rs, QRectF &visrect)
 {
   qDebug() << "Loading GUI flags";
@@ -1008,6 +1485,8 @@ void gui::DesignPanel::latticeCoord2PhysLoc(int n, int m, int l, QPointF &physlo
 
 void gui::DesignPanel::updateBackground()
 {
+  comp::HistogramScope trace(hotPathHist(UpdateBackgroundPath), "DesignPanel::updateBackground");
+
   QColor col = (display_mode == gui::ScreenshotMode) ? background_col_publish : background_col;
   bool lattice_visible = true;
   prim::Lattice *lat = layman->getLattice(!layman->isSimLayerMode());
@@ -1100,6 +1579,8 @@ void gui::DesignPanel::mousePressEvent(QMouseEvent *e)
 // the middle mouse button to always pan and right click for context menus.
 void gui::DesignPanel::mouseMoveEvent(QMouseEvent *e)
 {
+  comp::HistogramScope trace(hotPathHist(MouseMovePath), "DesignPanel::mouseMoveEvent");
+
   QPoint mouse_pos_del;
   qreal dx, dy;
   emit sig_cursorPhysLoc(mapToScene(e->pos()) / prim::Item::scale_factor_nm);
@@ -1388,8 +1869,26 @@ void gui::DesignPanel::duplicateSelection()
   }
 }
 
+void gui::DesignPanel::paintEvent(QPaintEvent *e)
+{
+  if (!hotPathTracing()) {
+    QGraphicsView::paintEvent(e);
+    return;
+  }
+
+  {
+    comp::HistogramScope trace(hotPathHist(PaintPath), "DesignPanel::paint");
+    QGraphicsView::paintEvent(e);
+  }
+  // the scene index query is only paid for while tracing
+  painted_item_counts.record(items(e->region().boundingRect(),
+      Qt::IntersectsItemBoundingRect).size());
+}
+
 void gui::DesignPanel::wheelZoom(QWheelEvent *e, bool boost)
 {
+  comp::HistogramScope trace(hotPathHist(WheelZoomPath), "DesignPanel::wheelZoom");
+
   settings::GUISettings *gui_settings = settings::GUISettings::instance();
 
   // base zoom factor
@@ -1414,6 +1913,8 @@ void gui::DesignPanel::stepZoom(const bool &zoom_in)
 
 void gui::DesignPanel::applyZoom(qreal ds, QWheelEvent *e)
 {
+  comp::HistogramScope trace(hotPathHist(ApplyZoomPath), "DesignPanel::applyZoom");
+
   // assert scale limitations
   boundZoom(ds);
 
@@ -1714,6 +2215,8 @@ void gui::DesignPanel::rubberBandUpdate(QPoint pos){
 
 
 void gui::DesignPanel::rubberBandSelect(){
+  comp::HistogramScope trace(hotPathHist(RubberBandSelectPath), "DesignPanel::rubberBandSelect");
+
   if (rb == nullptr)
     return;
 
@@ -1775,6 +2278,8 @@ void gui::DesignPanel::clearGhost()
 
 bool gui::DesignPanel::snapGhost(QPointF scene_pos, prim::LatticeCoord &offset)
 {
+  comp::HistogramScope trace(hotPathHist(SnapGhostPath), "DesignPanel::snapGhost");
+
   bool is_all_floating = true;
 
   // check if holding any non-floating objects
@@ -2104,6 +2609,7 @@ void gui::DesignPanel::EditTextLabel::undo()
     text_lab->setText(text_orig);
   else
     text_lab->setText(text_new);
+  dp->journalItem(comp::DesignJournal::UpdateItem, layer_index, item_index);
 }
 
 void gui::DesignPanel::EditTextLabel::redo()
@@ -2114,6 +2620,7 @@ void gui::DesignPanel::EditTextLabel::redo()
     text_lab->setText(text_new);
   else
     text_lab->setText(text_orig);
+  dp->journalItem(comp::DesignJournal::UpdateItem, layer_index, item_index);
 }
 
 
@@ -2186,6 +2693,7 @@ void gui::DesignPanel::ResizeItem::undo()
 
   item->resize(-top_left_delta.x(), -top_left_delta.y(),
                -bottom_right_delta.x(), -bottom_right_delta.y(), true);
+  dp->journalItem(comp::DesignJournal::UpdateItem, layer_index, item_index);
 }
 
 void gui::DesignPanel::ResizeItem::redo()
@@ -2196,11 +2704,13 @@ void gui::DesignPanel::ResizeItem::redo()
   // if the user resized manually, then the area is already the right size
   if (manual) {
     manual = false;
+    dp->journalItem(comp::DesignJournal::UpdateItem, layer_index, item_index);
     return;
   }
 
   item->resize(top_left_delta.x(), top_left_delta.y(),
                bottom_right_delta.x(), bottom_right_delta.y(), true);
+  dp->journalItem(comp::DesignJournal::UpdateItem, layer_index, item_index);
 }
 
 
@@ -2219,12 +2729,14 @@ void gui::DesignPanel::RotateItem::undo()
 {
   prim::Item *item = dp->layman->getLayer(layer_index)->getItem(item_index);
   item->setRotation(init_ang);
+  dp->journalItem(comp::DesignJournal::UpdateItem, layer_index, item_index);
 }
 
 void gui::DesignPanel::RotateItem::redo()
 {
   prim::Item *item = dp->layman->getLayer(layer_index)->getItem(item_index);
   item->setRotation(fin_ang);
+  dp->journalItem(comp::DesignJournal::UpdateItem, layer_index, item_index);
 }
 
 // ChangeColor class
@@ -2243,6 +2755,7 @@ void gui::DesignPanel::ChangeColor::undo()
   prim::Item *item = dp->layman->getLayer(layer_index)->getItem(item_index);
   item->setColor(init_col);
   item->update();
+  dp->journalItem(comp::DesignJournal::UpdateItem, layer_index, item_index);
 }
 
 void gui::DesignPanel::ChangeColor::redo()
@@ -2250,6 +2763,7 @@ void gui::DesignPanel::ChangeColor::redo()
   prim::Item *item = dp->layman->getLayer(layer_index)->getItem(item_index);
   item->setColor(fin_col);
   item->update();
+  dp->journalItem(comp::DesignJournal::UpdateItem, layer_index, item_index);
 }
 
 
@@ -2332,6 +2846,7 @@ void gui::DesignPanel::FormAggregate::form()
   // remove the items from the Layer stack in reverse order
   QStack<prim::Item*> items;
   for(int i=item_inds.count()-1; i>=0; i--) {
+    dp->journalItem(comp::DesignJournal::RemoveItem, layer_index, item_inds.at(i));
     items.push(layer->takeItem(item_inds.at(i)));
   }
 
@@ -2350,6 +2865,8 @@ void gui::DesignPanel::FormAggregate::form()
 void gui::DesignPanel::FormAggregate::split()
 {
   prim::Layer *layer = dp->layman->getLayer(layer_index);
+  dp->journalItem(comp::DesignJournal::RemoveItem, layer_index,
+                  agg_index < 0 ? layer->getItems().size()-1 : agg_index);
   prim::Item *item = layer->takeItem(agg_index);
 
   if(item->item_type != prim::Item::Aggregate)
@@ -2411,6 +2928,7 @@ void gui::DesignPanel::MoveItem::move(bool invert)
   QRectF old_rect = item->boundingRect();
   // move the item
   moveItem(item, delta);
+  dp->journalItem(comp::DesignJournal::UpdateItem, layer_index, item_index);
 
   // redraw old and new bounding rects to handle artifacts
   item->scene()->update(old_rect);
@@ -32,6 +32,9 @@
 #include "primitives/items.h"
 #include "primitives/emitter.h"
 #include "components/sim_job.h"
+#include "components/design_model.h"
+#include "components/design_journal.h"
+#include "components/profiler.h"
 
 namespace gui{
 
@@ -49,6 +52,11 @@ namespace gui{
 
     class UndoCommand;
 
+    //! Interaction code paths instrumented by hot path tracing.
+    enum HotPath{MouseMovePath, WheelZoomPath, ApplyZoomPath,
+                 UpdateBackgroundPath, SnapGhostPath, RubberBandSelectPath,
+                 PaintPath, HotPathCount};
+
     //! constructor
     DesignPanel(QWidget *parent=0);
 
@@ -176,6 +184,14 @@ namespace gui{
     //! Save layers and items into the given write stream.
     void writeToXmlStream(QXmlStreamWriter *, DesignInclusionArea);
 
+    //! Return a DesignModel containing the design layers and items, which can
+    //! be processed without access to the scene (e.g. for simulation problem
+    //! export). Overlay layers are left out unless include_overlays is set,
+    //! in which case the model layers match the layer indices of the layer
+    //! manager as long as result layers come last.
+    comp::DesignModel designModel(DesignInclusionArea inclusion_area=IncludeEntireDesign,
+                                  bool include_overlays=false) const;
+
 
     // LOAD
 
@@ -184,6 +200,48 @@ namespace gui{
     //! and instead only load into separately tracked Result layers.
     void loadFromFile(QXmlStreamReader *, bool is_sim_result=false);
 
+    //! Load layers and items from a DesignModel, usually parsed from file on
+    //! a worker thread. Items are inserted into the scene in one batch with
+    //! scene indexing and view updates suspended.
+    void loadFromModel(const comp::DesignModel &model);
+
+    //! Replay journal records on top of the current design, used to recover a
+    //! design from an autosave checkpoint. Returns whether all operations were
+    //! applied.
+    bool replayJournal(const QVector<QVector<comp::DesignJournal::Op>> &records);
+
+    //! Mark the design as modified, e.g. after recovering a design which has
+    //! not been saved to any file.
+    void markModified() {undo_stack->resetClean();}
+
+
+    // JOURNAL
+
+    //! Record the item changes made by undo stack commands to the given
+    //! journal, one record per undo stack index change. Set to nullptr to stop
+    //! journaling, which also happens when the design panel is reset.
+    void setJournal(comp::DesignJournal *t_journal);
+
+
+
+    // HOT PATH TRACING
+
+    //! Enable or disable latency tracing of the interaction hot paths. While
+    //! enabled, an overlay on the viewport shows the p50/p99 latencies and
+    //! the number of items painted per frame. Statistics are reset when
+    //! tracing is enabled.
+    void setHotPathTracing(bool enable);
+
+    //! Return whether hot path tracing is enabled.
+    bool hotPathTracing() const {return !hot_path_hists.isEmpty();}
+
+    //! Return the hot path statistics recorded since tracing was enabled as
+    //! a JSON object keyed by hot path name.
+    QJsonObject hotPathStats() const;
+
+    //! Write the hot path statistics to a JSON file at the given path.
+    bool exportHotPathStats(const QString &path) const;
+
     //! Load GUI flags.
     void loadGUIFlags(QXmlStreamReader *, QRectF &);
 
@@ -319,6 +377,8 @@ namespace gui{
 
     void wheelEvent(QWheelEvent *e) Q_DECL_OVERRIDE;
 
+    void paintEvent(QPaintEvent *e) Q_DECL_OVERRIDE;
+
     void keyPressEvent(QKeyEvent *e) Q_DECL_OVERRIDE;
     void keyReleaseEvent(QKeyEvent *e) Q_DECL_OVERRIDE;
 
@@ -340,6 +400,22 @@ namespace gui{
     gui::ToolType tool_type;  // current cursor tool type
     gui::DisplayMode display_mode=DesignMode; // current display mode
     QUndoStack *undo_stack;   // undo stack
+    comp::DesignJournal *journal=nullptr;         // journal of design changes
+    QVector<comp::DesignJournal::Op> journal_ops; // changes of the current command
+
+    // hot path tracing, histograms are only allocated while tracing
+    QVector<comp::LatencyHistogram> hot_path_hists; // latencies in us by HotPath
+    comp::LatencyHistogram painted_item_counts;     // items painted per frame
+    QLabel *hot_path_overlay=nullptr;
+    QTimer hot_path_overlay_timer;
+
+    //! Return the histogram of the given hot path, or nullptr if tracing is
+    //! disabled.
+    comp::LatencyHistogram *hotPathHist(HotPath path)
+      {return hot_path_hists.isEmpty() ? nullptr : &hot_path_hists[path];}
+
+    //! Update the text of the hot path tracing overlay.
+    void updateHotPathOverlay();
 
     // contained widgets
     gui::LayerManager *layman=nullptr;
@@ -559,6 +635,13 @@ namespace gui{
 
     // move the selected items to the current Ghost, returns True if successful
     bool moveToGhost(bool kill=false);
+
+    // record a change of the item at the given layer and item index to the
+    // pending journal record, does nothing if journaling is disabled
+    void journalItem(comp::DesignJournal::OpType type, int layer_index, int item_index);
+
+    // write the pending journal record, called on undo stack index changes
+    void flushJournal();
   };
 
 
@@ -8,6 +8,8 @@
 
 #include "item_manager.h"
 
+#include <algorithm>
+
 namespace gui{
 
 ItemManager::ItemManager(QWidget *parent, LayerManager* layman_in)
@@ -19,7 +21,6 @@ ItemManager::ItemManager(QWidget *parent, LayerManager* layman_in)
 
 ItemManager::~ItemManager()
 {
-  clearItemTable();
   layman = 0;
   delete item_table;
   delete main_vl;
@@ -27,12 +28,25 @@ ItemManager::~ItemManager()
 
 void ItemManager::initItemManager()
 {
-  // item_table = new QTableWidget(this);
+  item_model = new ItemTableModel(layman, this);
   item_table = new TableWidget(this);
+  item_table->setModel(item_model);
   connect(item_table, SIGNAL(sig_update_selection()),
           this, SLOT(updateItemSelection()));
   connect(item_table, SIGNAL(sig_delete_selection()),
           this, SLOT(deleteItemSelection()));
+
+  // buttons are painted rather than being widgets in each row
+  ItemPropertiesDelegate *properties_delegate = new ItemPropertiesDelegate(item_table);
+  item_table->setItemDelegateForColumn(static_cast<int>(Properties), properties_delegate);
+  connect(properties_delegate, &ItemPropertiesDelegate::sig_clicked,
+          this, &ItemManager::showProperties);
+
+  refresh_timer = new QTimer(this);
+  refresh_timer->setSingleShot(true);
+  refresh_timer->setInterval(0);
+  connect(refresh_timer, &QTimer::timeout, this, &ItemManager::refreshTable);
+
   main_vl = new QVBoxLayout;
   main_vl->addWidget(item_table);
   initItemTableHeaders();
@@ -43,9 +57,10 @@ void ItemManager::updateItemSelection()
 {
   //deselect all items
   emit sig_deselect();
-  for (QTableWidgetItem *item : item_table->selectedItems()){
-    ItemTableRowContent* content = table_row_contents[item->row()];
-    content->item->setSelected(true);
+  for (const QModelIndex &index : item_table->selectionModel()->selectedRows()){
+    prim::Item *item = item_model->itemAt(index.row());
+    if (item != 0)
+      item->setSelected(true);
   }
 }
 
@@ -55,116 +70,211 @@ void ItemManager::deleteItemSelection()
   // qDebug() << "Deleting item";
 }
 
-void ItemManager::clearItemTable()
-{
-  while (!table_row_contents.isEmpty()) {
-    ItemTableRowContent *row_content = table_row_contents.takeLast();
-    row_content->bt_show_properties->disconnect();
-    delete row_content;
-  }
-  item_table->setRowCount(0);  // delete all rows from layer table
-}
-
 void ItemManager::initItemTableHeaders()
 {
   qDebug() << "Initializing item table headers";
-  QStringList table_headers;
-
-  // TODO take enum type instead of this stringlist
-  table_headers <<
-    "Type" <<       // item_type QString
-    "Layer Name" <<      // owning layer's index
-    "Layer ID" <<      // owning layer's index
-    "Index" <<      // item's index within the layer
-    "Properties"; // button to show properties
-
-  item_table->setColumnCount(table_headers.length());
-  item_table->setHorizontalHeaderLabels(table_headers);
   item_table->resizeColumnToContents(static_cast<int>(Type)); // reduce width of visibility column
   item_table->resizeColumnToContents(static_cast<int>(LayerName)); // reduce width of visibility column
   item_table->resizeColumnToContents(static_cast<int>(LayerID)); // reduce width of visibility column
   item_table->resizeColumnToContents(static_cast<int>(Index)); // reduce width of visibility column
   item_table->resizeColumnToContents(static_cast<int>(Properties)); // reduce width of visibility column
-
-  // header tooltips
-  item_table->horizontalHeaderItem(static_cast<int>(Type))->
-      setToolTip("Item type: DBDot, Electrode, etc.");
-  item_table->horizontalHeaderItem(static_cast<int>(LayerName))->
-      setToolTip("Layer Name");
-  item_table->horizontalHeaderItem(static_cast<int>(LayerID))->
-      setToolTip("Layer ID");
-  item_table->horizontalHeaderItem(static_cast<int>(Index))->
-      setToolTip("Item index");
-  item_table->horizontalHeaderItem(static_cast<int>(Properties))->
-      setToolTip("Show properties");
 }
 
 void ItemManager::updateTableAdd()
 {
-  for (int i=0;i < layman->layerCount(); i++) {
-    prim::Layer* layer = layman->getLayer(i);
-    for (prim::Item* item : layer->getItems()) {
-      addItemRow(item);
-    }
-  }
+  table_outdated = true;
+  if (isVisible())
+    refresh_timer->start();
+}
+
+void ItemManager::updateTableRemove(prim::Item *)
+{
+  // rows are read from the layers, so removals only change the row count
+  updateTableAdd();
+}
+
+void ItemManager::showEvent(QShowEvent *e)
+{
+  refreshTable();
+  QWidget::showEvent(e);
+}
+
+void ItemManager::refreshTable()
+{
+  if (!table_outdated)
+    return;
+  item_model->refresh();
+  table_outdated = false;
 }
 
-void ItemManager::addItemRow(prim::Item *item)
+void ItemManager::showProperties(const QModelIndex &index)
 {
+  prim::Item *item = item_model->itemAt(index.row());
   if (item == 0)
     return;
-  for (ItemTableRowContent* row_content: table_row_contents) {
-    if (row_content->item == item) {
-      return;
-    }
+  //the QString must be exactly "Show properties" in order to trigger showProps() from items
+  QAction temp_action;
+  temp_action.setText("Show properties");
+  item->performAction(&temp_action);
+}
+
+ItemTableModel::ItemTableModel(LayerManager *layman, QObject *parent)
+  : QAbstractTableModel(parent), layman(layman)
+{
+  layer_offsets.append(0);
+}
+
+void ItemTableModel::refresh()
+{
+  beginResetModel();
+  layer_offsets.clear();
+  int row_count = 0;
+  for (int i=0; i < layman->layerCount(); i++) {
+    layer_offsets.append(row_count);
+    row_count += layman->getLayer(i)->getItems().size();
   }
-  ItemTableRowContent *new_content = new ItemTableRowContent();
-  new_content->item = item;
-  new_content->type = new QTableWidgetItem(item->getQStringItemType());
-  new_content->layer_name = new QTableWidgetItem(layman->getLayer(item->layer_id)->getName());
-  new_content->layer_id = new QTableWidgetItem(QString::number(item->layer_id));
-  new_content->index = new QTableWidgetItem(QString::number(layman->getLayer(item->layer_id)->getItemIndex(item)));
-  //the QString in buttons must be exactly "Show properties" in order to trigger showProps() from items
-  new_content->bt_show_properties = new QPushButton(QString("Show properties"), this);
-  connect(new_content->bt_show_properties, &QAbstractButton::clicked, this, &ItemManager::showProperties);
-
-  table_row_contents.append(new_content);
-  int curr_row = item_table->rowCount();
-  item_table->insertRow(curr_row);
-  item_table->setItem(curr_row, static_cast<int>(Type), new_content->type);
-  item_table->setItem(curr_row, static_cast<int>(LayerName), new_content->layer_name);
-  item_table->setItem(curr_row, static_cast<int>(LayerID), new_content->layer_id);
-  item_table->setItem(curr_row, static_cast<int>(Index), new_content->index);
-  item_table->setCellWidget(curr_row, static_cast<int>(Properties), new_content->bt_show_properties);
-}
-
-
-void ItemManager::showProperties()
-{
-  for (ItemTableRowContent* row_content: table_row_contents) {
-    if (row_content->bt_show_properties == static_cast<QPushButton *>(sender())) {
-      QAction temp_action;
-      temp_action.setText(row_content->bt_show_properties->text());
-      row_content->item->performAction(&temp_action);
-      return;
-    }
+  layer_offsets.append(row_count);
+  endResetModel();
+}
+
+prim::Item *ItemTableModel::itemAt(int row) const
+{
+  int layer_ind = layerOfRow(row);
+  if (layer_ind < 0 || layer_ind >= layman->layerCount())
+    return 0;
+  prim::Layer *layer = layman->getLayer(layer_ind);
+  int item_ind = row - layer_offsets.at(layer_ind);
+  // the layers may have changed since the last refresh
+  if (layer == 0 || item_ind >= layer->getItems().size())
+    return 0;
+  return layer->getItems().at(item_ind);
+}
+
+int ItemTableModel::rowCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : layer_offsets.last();
+}
+
+int ItemTableModel::columnCount(const QModelIndex &parent) const
+{
+  return parent.isValid() ? 0 : static_cast<int>(ItemManager::Properties) + 1;
+}
+
+QVariant ItemTableModel::data(const QModelIndex &index, int role) const
+{
+  if (!index.isValid() || role != Qt::DisplayRole)
+    return QVariant();
+  prim::Item *item = itemAt(index.row());
+  if (item == 0)
+    return QVariant();
+
+  int layer_ind = layerOfRow(index.row());
+  switch (static_cast<ItemManager::ItemManagerColumn>(index.column())) {
+    case ItemManager::Type:
+      return item->getQStringItemType();
+    case ItemManager::LayerName:
+      return layman->getLayer(layer_ind)->getName();
+    case ItemManager::LayerID:
+      return item->layer_id;
+    case ItemManager::Index:
+      return index.row() - layer_offsets.at(layer_ind);
+    default:
+      return QVariant();
   }
 }
 
-void ItemManager::updateTableRemove(prim::Item *item)
+QVariant ItemTableModel::headerData(int section, Qt::Orientation orientation,
+    int role) const
 {
-  for (ItemTableRowContent* row_content: table_row_contents) {
-    if (row_content->item == item) {
-      table_row_contents.removeAt(table_row_contents.indexOf(row_content));
-      item_table->removeRow(item_table->row(row_content->type));
-      row_content->bt_show_properties->disconnect();
-      return;
+  if (orientation != Qt::Horizontal)
+    return QVariant();
+
+  if (role == Qt::DisplayRole) {
+    switch (static_cast<ItemManager::ItemManagerColumn>(section)) {
+      case ItemManager::Type:
+        return "Type";          // item_type QString
+      case ItemManager::LayerName:
+        return "Layer Name";    // owning layer's name
+      case ItemManager::LayerID:
+        return "Layer ID";      // owning layer's index
+      case ItemManager::Index:
+        return "Index";         // item's index within the layer
+      case ItemManager::Properties:
+        return "Properties";    // button to show properties
+      default:
+        return QVariant();
     }
+  } else if (role == Qt::ToolTipRole) {
+    switch (static_cast<ItemManager::ItemManagerColumn>(section)) {
+      case ItemManager::Type:
+        return "Item type: DBDot, Electrode, etc.";
+      case ItemManager::LayerName:
+        return "Layer Name";
+      case ItemManager::LayerID:
+        return "Layer ID";
+      case ItemManager::Index:
+        return "Item index";
+      case ItemManager::Properties:
+        return "Show properties";
+      default:
+        return QVariant();
+    }
+  }
+  return QVariant();
+}
+
+int ItemTableModel::layerOfRow(int row) const
+{
+  if (row < 0 || row >= layer_offsets.last())
+    return -1;
+  // last layer whose first row is not after the row, skipping empty layers
+  auto it = std::upper_bound(layer_offsets.constBegin(), layer_offsets.constEnd(), row);
+  return static_cast<int>(it - layer_offsets.constBegin()) - 1;
+}
+
+void ItemPropertiesDelegate::paint(QPainter *painter,
+    const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+  QStyledItemDelegate::paint(painter, option, index);
+  QStyle *style = option.widget ? option.widget->style() : QApplication::style();
+  QStyleOptionButton button;
+  button.rect = option.rect;
+  button.text = "Show properties";
+  button.fontMetrics = option.fontMetrics;
+  button.state = QStyle::State_Enabled | QStyle::State_Raised;
+  if (pressed_index == index)
+    button.state |= QStyle::State_Sunken;
+  style->drawControl(QStyle::CE_PushButton, &button, painter, option.widget);
+}
+
+bool ItemPropertiesDelegate::editorEvent(QEvent *event, QAbstractItemModel *model,
+    const QStyleOptionViewItem &option, const QModelIndex &index)
+{
+  if (event->type() != QEvent::MouseButtonPress
+      && event->type() != QEvent::MouseButtonRelease)
+    return QStyledItemDelegate::editorEvent(event, model, option, index);
+
+  QMouseEvent *mouse_event = static_cast<QMouseEvent*>(event);
+  if (mouse_event->button() != Qt::LeftButton)
+    return QStyledItemDelegate::editorEvent(event, model, option, index);
+
+  QAbstractItemView *view = qobject_cast<QAbstractItemView*>(parent());
+  bool in_button = option.rect.contains(mouse_event->pos());
+  if (event->type() == QEvent::MouseButtonPress) {
+    pressed_index = in_button ? QPersistentModelIndex(index) : QPersistentModelIndex();
+  } else {
+    bool clicked = in_button && pressed_index == index;
+    pressed_index = QPersistentModelIndex();
+    if (clicked)
+      emit sig_clicked(index);
   }
+  if (view != nullptr)
+    view->viewport()->update(option.rect);
+  return in_button;
 }
 
 TableWidget::TableWidget(QWidget *parent)
-  :QTableWidget(parent)
+  :QTableView(parent)
 {
   initTableWidget();
   delete_action = menu.addAction("Delete", this, SLOT(deleteItems()));
@@ -174,6 +284,8 @@ void TableWidget::initTableWidget()
 {
   //hide the left hand column of numbers
   verticalHeader()->hide();
+  //uniform row heights so that rows are never measured
+  verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
   //force full row selection
   setSelectionBehavior(QAbstractItemView::SelectRows);
 }
@@ -186,7 +298,7 @@ void TableWidget::deleteItems()
 void TableWidget::showContextMenu(const QPoint& p)
 {
   QPoint p_global = mapToGlobal(p);
-  if (selectedItems().length() == 0)
+  if (!selectionModel()->hasSelection())
   {
     delete_action->setEnabled(false);
   } else {
@@ -201,12 +313,12 @@ void TableWidget::mousePressEvent(QMouseEvent *e)
     case Qt::RightButton:
     {
       // qDebug() << "Right Clicked!";
-      QTableWidget::mousePressEvent(e);
+      QTableView::mousePressEvent(e);
       break;
     }
     default:
     {
-      QTableWidget::mousePressEvent(e);
+      QTableView::mousePressEvent(e);
       break;
     }
   }
@@ -221,22 +333,22 @@ void TableWidget::mouseReleaseEvent(QMouseEvent *e)
       //catch the release off the left mouse button.
       //Update selection of items on the scene according to the
       //selected items in the manager.
-      QTableWidget::mouseReleaseEvent(e);
+      QTableView::mouseReleaseEvent(e);
       emit sig_update_selection();
       break;
     }
     case Qt::RightButton:
     {
       // qDebug() << "Right Clicked!";
-      // QTableWidget::mouseReleaseEvent(e);
-      QTableWidget::mouseReleaseEvent(e);
+      // QTableView::mouseReleaseEvent(e);
+      QTableView::mouseReleaseEvent(e);
       emit sig_update_selection();
       showContextMenu(e->pos());
       break;
     }
     default:
     {
-      QTableWidget::mouseReleaseEvent(e);
+      QTableView::mouseReleaseEvent(e);
       break;
     }
   }
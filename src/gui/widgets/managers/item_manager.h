@@ -15,6 +15,9 @@
 #include "layer_manager.h"
 
 namespace gui{
+
+  class ItemTableModel;
+
   class ItemManager : public QWidget
   {
     Q_OBJECT
@@ -30,40 +33,106 @@ namespace gui{
 
     // bool eventFilter(QObject *object, QEvent *event);
 
-    struct ItemTableRowContent
-    {
-      prim::Item *item;
-      QTableWidgetItem *type;
-      QTableWidgetItem *layer_name;
-      QTableWidgetItem *layer_id;
-      QTableWidgetItem *index;
-      QPushButton *bt_show_properties;
-    };
-
   signals:
     void sig_deselect();
     void sig_delete_selected();
 
   public slots:
+    //! Notify the item manager that items were added to layers. The table is
+    //! refreshed once control returns to the event loop, or when the item
+    //! manager is shown if it is hidden, so bulk additions cost one refresh.
     void updateTableAdd();
+
+    //! Notify the item manager that an item was removed from its layer. The
+    //! item may have been deleted already.
     void updateTableRemove(prim::Item* item);
-    void showProperties();
+
+    void showProperties(const QModelIndex &index);
     void updateItemSelection();
     void deleteItemSelection();
 
+  protected:
+    void showEvent(QShowEvent *e) override;
+
   private:
     void initItemManager();
     void initItemTableHeaders();
-    void addItemRow(prim::Item *item);
-    void clearItemTable();
+
+    //! Refresh the table if the layers changed since the last refresh.
+    void refreshTable();
 
     LayerManager *layman;
-    QTableWidget *item_table;
-    QList<ItemTableRowContent*> table_row_contents;
+    QTableView *item_table;
+    ItemTableModel *item_model;
+    QTimer *refresh_timer;        // coalesces table refreshes
+    bool table_outdated=false;    // layers changed since the last refresh
     QVBoxLayout *main_vl;
   };
 
-  class TableWidget: public QTableWidget
+  //! Table model listing the items of all design layers in layer order. Rows
+  //! are read directly from the layer storage, only the first row of each
+  //! layer is stored, so a row maps to its item in O(log(layer count)).
+  class ItemTableModel : public QAbstractTableModel
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Constructor.
+    ItemTableModel(LayerManager *layman, QObject *parent=nullptr);
+
+    //! Read the layer sizes again and reset the model.
+    void refresh();
+
+    //! Return the item in the row, or a null pointer if the row is invalid.
+    prim::Item *itemAt(int row) const;
+
+    // QAbstractTableModel interface
+    int rowCount(const QModelIndex &parent=QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent=QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+        int role=Qt::DisplayRole) const override;
+
+  private:
+
+    //! Return the index of the layer holding the row, -1 if out of range.
+    int layerOfRow(int row) const;
+
+    LayerManager *layman;
+    QVector<int> layer_offsets;   // first row of each layer followed by the row count
+  };
+
+  //! Paints a "Show properties" button in the properties column of the item
+  //! table and reports clicks on it, without creating a widget per row.
+  class ItemPropertiesDelegate : public QStyledItemDelegate
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Constructor.
+    ItemPropertiesDelegate(QObject *parent=nullptr) : QStyledItemDelegate(parent) {};
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+        const QModelIndex &index) const override;
+
+  signals:
+
+    //! Emitted when the button in the cell has been clicked.
+    void sig_clicked(const QModelIndex &index);
+
+  protected:
+
+    bool editorEvent(QEvent *event, QAbstractItemModel *model,
+        const QStyleOptionViewItem &option, const QModelIndex &index) override;
+
+  private:
+
+    QPersistentModelIndex pressed_index;  // cell of the button being pressed
+  };
+
+  class TableWidget: public QTableView
   {
     Q_OBJECT
   public:
@@ -20,6 +20,9 @@ JobManager::JobManager(PluginManager *plugin_manager, SimVisualizer *sim_visuali
     sim_visualizer(sim_visualizer)
 {
   initJobManagerGUI();
+
+  // directories of jobs from previous sessions may exceed the quota
+  cleanUpJobDirs();
 }
 
 JobManager::~JobManager()
@@ -50,27 +53,7 @@ void JobManager::addJob(comp::SimJob *job)
             }
           });
 
-  // update job list
-  // TODO better implementation in the future, current implementation is a quick hack
-  QList<QStandardItem*> row_job_info;
-  row_job_info.append(new QStandardItem(job->name()));
-  job_view_model->insertRow(0, row_job_info); // prepend row
-
-  QList<QWidget*> row_widgets({
-        job->guiControlElems().pb_terminate,
-        job->guiControlElems().pb_sim_visualize,
-        job->guiControlElems().pb_job_terminal,
-        job->guiControlElems().pb_export_results
-      });
-
-  tv_job_view->resizeColumnToContents(0);
-  QModelIndex mi_back = job_view_model->indexFromItem(row_job_info.back());
-  int col_start = mi_back.column() + 1;
-  for (int col=col_start; col < col_start + row_widgets.size(); col++) {
-    tv_job_view->setIndexWidget(job_view_model->index(mi_back.row(), 
-          col), row_widgets[col-col_start]);
-    tv_job_view->resizeColumnToContents(col);
-  }
+  job_view_model->addJob(job);
 }
 
 void JobManager::runJob(comp::SimJob *job)
@@ -85,13 +68,17 @@ void JobManager::processFinishedJob(comp::SimJob *job, comp::SimJob::JobState)
   // a flag in job steps to facilitate this)
 
   // update GUI elements in job manager
+  job_view_model->refreshJob(job);
 
+  cleanUpJobDirs();
 
   // execute SQCommands if any is available
   // TODO allow users to make execution manual and prompt user before execution
   for (comp::JobStep *js : job->jobSteps()) {
-    if (js->jobResults().uniqueKeys().contains(comp::JobResult::SQCommandsResult)) {
+    if (js->resultTypes().contains(comp::JobResult::SQCommandsResult)) {
       comp::JobResult *sq_commands_result = js->jobResults().value(comp::JobResult::SQCommandsResult);
+      if (sq_commands_result == nullptr)
+        continue;
       QStringList commands = static_cast<comp::SQCommands*>(sq_commands_result)->sqCommands();
       for (const QString &command : commands) {
         // TODO add convenient function to commander to take QStringList of commands
@@ -109,6 +96,15 @@ void JobManager::processFinishedJob(comp::SimJob *job, comp::SimJob::JobState)
   }
 }
 
+void JobManager::cleanUpJobDirs()
+{
+  QSet<QString> in_use_dir_paths;
+  for (comp::SimJob *job : sim_jobs)
+    if (!job->jobTempDirPath().isEmpty())
+      in_use_dir_paths.insert(job->jobTempDirPath());
+  comp::JobCatalog::instance()->cleanUp(in_use_dir_paths);
+}
+
 bool JobManager::eligibleForSimVisualizer(comp::SimJob *job)
 {
   for (comp::JobResult::ResultType type : job->resultTypeStepMap().keys())
@@ -296,6 +292,12 @@ QWidget *JobManager::initJobSetupPanel()
     QList<QStandardItem*> row_si = engine->standardItemRow(eng_list_fields);
     eng_model->appendRow(row_si);
   }
+  // plugins are discovered in the background, add them as they arrive
+  connect(plugin_manager, &PluginManager::sig_pluginEngineAdded,
+          [this](comp::PluginEngine *engine)
+          {
+            eng_model->appendRow(engine->standardItemRow(eng_list_fields));
+          });
   // set the engine list model as the filtered proxy model
   eng_filter_proxy_model = new QSortFilterProxyModel();
   eng_filter_proxy_model->setSourceModel(eng_model);
@@ -490,6 +492,7 @@ QWidget *JobManager::initJobSetupPanel()
             // create sim job and submit to application
             comp::SimJob *new_job = new comp::SimJob(job_details.name, nullptr);
             new_job->setInclusionArea(job_details.inclusion_area);
+            new_job->setUseResultCache(job_details.use_result_cache);
             for (int i=0; i<job_steps_model->rowCount(); i++) {
               QStandardItem *si_job_step = job_steps_model->item(i);
               EngineDataset *eng_dataset = static_cast<JobStepViewListItem*>(si_job_step)->eng_dataset;
@@ -509,9 +512,11 @@ QWidget *JobManager::initJobSetupPanel()
                 return;
               }
               // create a sim job step and add it to the job
-              new_job->addJobStep(new comp::JobStep(eng_dataset->engine,
-                                                    eng_dataset->command_format.split("\n"),
-                                                    eng_dataset->prop_form->finalProperties()));
+              comp::JobStep *job_step = new comp::JobStep(eng_dataset->engine,
+                                                          eng_dataset->command_format.split("\n"),
+                                                          eng_dataset->prop_form->finalProperties());
+              job_step->setResourcePolicy(eng_dataset->res_policy);
+              new_job->addJobStep(job_step);
             }
             runJob(new_job);
           });
@@ -540,21 +545,43 @@ QWidget *JobManager::initJobSetupPanel()
 
 QWidget *JobManager::initJobViewPanel()
 {
-  job_view_model = new QStandardItemModel();
-  job_view_model->setColumnCount(5);  // TODO make dynamic
+  job_view_model = new JobViewModel(this);
   tv_job_view = new QTreeView();
   tv_job_view->header()->setStretchLastSection(false);
   tv_job_view->setModel(job_view_model);
+  tv_job_view->setUniformRowHeights(true);
+  tv_job_view->setColumnWidth(JobViewModel::NameColumn, 250);
+  tv_job_view->setColumnWidth(JobViewModel::StatusColumn, 250);
+
+  // job actions are painted as buttons rather than being widgets
+  JobActionDelegate *job_action_delegate = new JobActionDelegate(tv_job_view);
+  tv_job_view->setItemDelegateForColumn(JobViewModel::ActionsColumn, job_action_delegate);
+  QStyleOptionViewItem view_option;
+  view_option.initFrom(tv_job_view);
+  tv_job_view->setColumnWidth(JobViewModel::ActionsColumn,
+      job_action_delegate->actionsSize(view_option).width());
+  connect(job_action_delegate, &JobActionDelegate::sig_actionTriggered,
+          this, &JobManager::triggerJobAction);
+  tv_job_view->setSelectionMode(QAbstractItemView::ExtendedSelection);
   // TODO QTreeView with multiple columns
   // TODO job details (start and end times, job step count, list of invocation commands for job steps)
   // TODO allow sorting, sort by newest by default
 
   QPushButton *pb_close = new QPushButton("Close", this);
   QPushButton *pb_import_job_results = new QPushButton("Import Past Results", this);
+  QPushButton *pb_engine_stats = new QPushButton("Engine Statistics", this);
+  QPushButton *pb_resume_job = new QPushButton("Resume Job", this);
+  pb_resume_job->setToolTip(tr("Rerun the selected job from its first "
+        "unfinished step, keeping the results of the steps before it."));
+  QPushButton *pb_export_jobs = new QPushButton("Export Jobs", this);
+  pb_export_jobs->setToolTip(tr("Export all selected jobs into a directory."));
   pb_close->setShortcut(Qt::Key_Escape);
   QDialogButtonBox *dbb_job_view_buttons = new QDialogButtonBox();
   dbb_job_view_buttons->addButton(pb_close, QDialogButtonBox::RejectRole);
   dbb_job_view_buttons->addButton(pb_import_job_results, QDialogButtonBox::ActionRole);
+  dbb_job_view_buttons->addButton(pb_engine_stats, QDialogButtonBox::ActionRole);
+  dbb_job_view_buttons->addButton(pb_resume_job, QDialogButtonBox::ActionRole);
+  dbb_job_view_buttons->addButton(pb_export_jobs, QDialogButtonBox::ActionRole);
 
   vl_job_view = new QVBoxLayout();
   vl_job_view->addWidget(tv_job_view);
@@ -573,11 +600,94 @@ QWidget *JobManager::initJobViewPanel()
           emit sig_showJob(j);
         }
       });
+  connect(pb_engine_stats, &QPushButton::clicked,
+          this, &JobManager::showEngineResourceStats);
+  connect(pb_resume_job, &QPushButton::clicked,
+          this, &JobManager::resumeSelectedJob);
+  connect(pb_export_jobs, &QPushButton::clicked,
+          this, &JobManager::exportSelectedJobs);
 
   //return tv_job_view;
   return vl_job_view_widget;
 }
 
+}
+
+void JobManager::showEngineResourceStats()
+{
+  // accumulated usage of one engine, each quantity is averaged over the steps
+  // on which it was measured
+  struct EngineStats
+  {
+    int steps=0;
+    double wall_s=0;
+    double cpu_s=0;   int cpu_n=0;
+    qint64 peak_rss_kb=-1;
+    double io_mib=0;  int io_n=0;
+  };
+
+  QMap<QString, EngineStats> eng_stats;
+  for (comp::SimJob *job : sim_jobs) {
+    for (comp::JobStep *js : job->jobSteps()) {
+      comp::ResourceUsage usage = js->resourceUsage();
+      if (!usage.isValid())
+        continue;
+      EngineStats &es = eng_stats[tr("%1 %2").arg(js->engineName())
+        .arg(js->engineVersion()).trimmed()];
+      es.steps++;
+      es.wall_s += usage.wall_ms / 1000.;
+      if (usage.user_cpu_s >= 0 && usage.sys_cpu_s >= 0) {
+        es.cpu_s += usage.user_cpu_s + usage.sys_cpu_s;
+        es.cpu_n++;
+      }
+      es.peak_rss_kb = qMax(es.peak_rss_kb, usage.peak_rss_kb);
+      if (usage.read_bytes >= 0 && usage.written_bytes >= 0) {
+        es.io_mib += (usage.read_bytes + usage.written_bytes) / (1024. * 1024);
+        es.io_n++;
+      }
+    }
+  }
+
+  auto numItem = [](double val, bool measured)
+  {
+    QTableWidgetItem *item = new QTableWidgetItem(measured
+        ? QString::number(val, 'f', 2) : QString("-"));
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+  };
+
+  QTableWidget *tw_stats = new QTableWidget(eng_stats.size(), 6);
+  tw_stats->setHorizontalHeaderLabels({tr("Engine"), tr("Steps"),
+      tr("Mean wall time (s)"), tr("Mean CPU time (s)"),
+      tr("Max peak RSS (MiB)"), tr("Mean I/O (MiB)")});
+  tw_stats->verticalHeader()->hide();
+  tw_stats->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  int row = 0;
+  for (auto it = eng_stats.cbegin(); it != eng_stats.cend(); ++it, ++row) {
+    const EngineStats &es = it.value();
+    tw_stats->setItem(row, 0, new QTableWidgetItem(it.key()));
+    tw_stats->setItem(row, 1, new QTableWidgetItem(QString::number(es.steps)));
+    tw_stats->setItem(row, 2, numItem(es.wall_s / es.steps, true));
+    tw_stats->setItem(row, 3, numItem(es.cpu_s / qMax(1, es.cpu_n), es.cpu_n > 0));
+    tw_stats->setItem(row, 4, numItem(es.peak_rss_kb / 1024., es.peak_rss_kb >= 0));
+    tw_stats->setItem(row, 5, numItem(es.io_mib / qMax(1, es.io_n), es.io_n > 0));
+  }
+  tw_stats->resizeColumnsToContents();
+
+  QDialog *d_stats = new QDialog(this);
+  d_stats->setAttribute(Qt::WA_DeleteOnClose);
+  d_stats->setWindowTitle(tr("Engine Resource Usage"));
+  QDialogButtonBox *dbb_stats = new QDialogButtonBox(QDialogButtonBox::Close);
+  connect(dbb_stats, &QDialogButtonBox::rejected, d_stats, &QDialog::reject);
+  QVBoxLayout *vl_stats = new QVBoxLayout(d_stats);
+  vl_stats->addWidget(new QLabel(tr("Resource usage of finished job steps, "
+          "including all processes spawned by the engine.")));
+  vl_stats->addWidget(tw_stats);
+  vl_stats->addWidget(dbb_stats);
+  d_stats->resize(720, 300);
+  d_stats->show();
+}
+
 comp::PluginEngine *JobManager::selectedEngine()
 {
   QModelIndex model_index = lv_engines->currentIndex();
@@ -602,6 +712,7 @@ JobSetupDetailsPane::JobSetupDetailsPane(QWidget *parent)
   QGroupBox *gb_plugin_props = new QGroupBox("Plugin Invocation");
   QGroupBox *gb_plugin_status = new QGroupBox("Plugin Status");
   QGroupBox *gb_plugin_params = new QGroupBox("Plugin Runtime Parameters");
+  QGroupBox *gb_res_policy = new QGroupBox("Resource Limits");
 
   // Job
   le_job_name = new QLineEdit();
@@ -613,6 +724,11 @@ JobSetupDetailsPane::JobSetupDetailsPane(QWidget *parent)
   QCheckBox *cb_auto_job_name = new QCheckBox("Auto job name");
   cb_auto_job_name->setChecked(true);
   cbb_inclusion_area = new QComboBox();
+  cb_use_result_cache = new QCheckBox("Reuse cached results");
+  cb_use_result_cache->setChecked(settings::AppSettings::instance()->get<bool>("plugs/result_cache"));
+  cb_use_result_cache->setToolTip("Reuse the results of previous runs of identical "
+      "problems with the same engine and parameters instead of running the "
+      "simulation again. Uncheck to force the simulation to run.");
 
   // response to auto job name checkbox
   auto autoJobNameResponse = [this](int check_state)
@@ -639,6 +755,7 @@ JobSetupDetailsPane::JobSetupDetailsPane(QWidget *parent)
   fl_job_props->addRow(new QLabel("Job name"), le_job_name);
   fl_job_props->addRow(hl_auto_job_name);
   fl_job_props->addRow(new QLabel("Inclusion area"), cbb_inclusion_area);
+  fl_job_props->addRow(cb_use_result_cache);
   fl_job_props->setSizeConstraint(QLayout::SetMinimumSize);
   gb_job_props->setLayout(fl_job_props);
 
@@ -703,12 +820,71 @@ JobSetupDetailsPane::JobSetupDetailsPane(QWidget *parent)
   vl_plugin_params = new QVBoxLayout();
   gb_plugin_params->setLayout(vl_plugin_params);
 
+  // Resource Limits
+  le_cpu_affinity = new QLineEdit();
+  le_cpu_affinity->setPlaceholderText("All CPUs");
+  le_cpu_affinity->setValidator(new QRegExpValidator(
+        QRegExp("(\\d+(-\\d+)?)?(,\\d+(-\\d+)?)*"), le_cpu_affinity));
+  le_cpu_affinity->setToolTip("CPUs that the plugin process may run on, e.g. "
+      "0-3,6. Only applied on Linux.");
+  sb_nice = new QSpinBox();
+  sb_nice->setRange(0, 19);
+  sb_nice->setToolTip("Niceness increment of the plugin process, higher values "
+      "yield to other processes. Not applied on Windows.");
+  sb_memory_limit = new QSpinBox();
+  sb_memory_limit->setRange(0, INT_MAX);
+  sb_memory_limit->setSuffix(" MiB");
+  sb_memory_limit->setSpecialValueText("No limit");
+  sb_memory_limit->setToolTip("Address space limit of each plugin process. "
+      "Not applied on Windows.");
+  sb_timeout = new QSpinBox();
+  sb_timeout->setRange(0, INT_MAX / 1000);
+  sb_timeout->setSuffix(" s");
+  sb_timeout->setSpecialValueText("No limit");
+  sb_timeout->setToolTip("Wall-clock time after which the plugin process is "
+      "terminated.");
+
+  QFormLayout *fl_res_policy = new QFormLayout();
+  fl_res_policy->addRow(new QLabel("CPU affinity"), le_cpu_affinity);
+  fl_res_policy->addRow(new QLabel("Niceness"), sb_nice);
+  fl_res_policy->addRow(new QLabel("Memory limit"), sb_memory_limit);
+  fl_res_policy->addRow(new QLabel("Timeout"), sb_timeout);
+  gb_res_policy->setLayout(fl_res_policy);
+
+  // update the resource policy in engine dataset
+  connect(le_cpu_affinity, &QLineEdit::textChanged,
+          [this](const QString &text)
+          {
+            QList<int> cpus;
+            if (eng_dataset != nullptr && comp::ResourcePolicy::parseCpuList(text, cpus))
+              eng_dataset->res_policy.cpu_affinity = cpus;
+          });
+  connect(sb_nice, QOverload<int>::of(&QSpinBox::valueChanged),
+          [this](int val)
+          {
+            if (eng_dataset != nullptr)
+              eng_dataset->res_policy.nice = val;
+          });
+  connect(sb_memory_limit, QOverload<int>::of(&QSpinBox::valueChanged),
+          [this](int val)
+          {
+            if (eng_dataset != nullptr)
+              eng_dataset->res_policy.memory_limit_mb = val;
+          });
+  connect(sb_timeout, QOverload<int>::of(&QSpinBox::valueChanged),
+          [this](int val)
+          {
+            if (eng_dataset != nullptr)
+              eng_dataset->res_policy.timeout_s = val;
+          });
+
   QVBoxLayout *vl_pane = new QVBoxLayout();
   vl_pane->addWidget(gb_job_props);
   vl_pane->addWidget(gb_plugin_info);
   vl_pane->addWidget(gb_plugin_props);
   vl_pane->addWidget(gb_plugin_status);
   vl_pane->addWidget(gb_plugin_params);
+  vl_pane->addWidget(gb_res_policy);
   vl_pane->addStretch();
   setLayout(vl_pane);
 }
@@ -803,6 +979,14 @@ void JobSetupDetailsPane::setEngineDataset(JobManager::EngineDataset *t_eng_data
 
   te_command->setText(eng_dataset->command_format);
 
+  // show the resource policy of this dataset, the dataset pointer is already
+  // updated so the change handlers write the same values back
+  le_cpu_affinity->setText(eng_dataset->res_policy.cpuListString());
+  sb_nice->setValue(eng_dataset->res_policy.nice);
+  sb_memory_limit->setValue(static_cast<int>(qMin<qint64>(
+          eng_dataset->res_policy.memory_limit_mb, INT_MAX)));
+  sb_timeout->setValue(eng_dataset->res_policy.timeout_s);
+
   // update engine command preset menu
   menu_command_preset->clear();
   for (auto cmd_format : eng_dataset->engine->commandFormats()) {
@@ -820,3 +1004,160 @@ void JobSetupDetailsPane::setEngineDataset(JobManager::EngineDataset *t_eng_data
   // show new property form
   vl_plugin_params->addWidget(eng_dataset->prop_form);
 }
+
+void JobManager::resumeSelectedJob()
+{
+  comp::SimJob *job = job_view_model->jobAt(tv_job_view->currentIndex());
+
+  auto showMessage = [this](const QString &text)
+  {
+    QMessageBox *msg = new QMessageBox(this);
+    msg->setAttribute(Qt::WA_DeleteOnClose);
+    msg->setText(text);
+    msg->open();
+  };
+
+  if (job == nullptr || !job->resumable()) {
+    showMessage(tr("Please select a job which has unfinished steps and isn't "
+          "running."));
+    return;
+  }
+
+  // imported steps only know the name of their engine
+  for (int i=job->firstUnfinishedStep(); i<job->jobSteps().length(); i++) {
+    comp::JobStep *js = job->getJobStep(i);
+    if (js->pluginEngine() != nullptr)
+      continue;
+    for (comp::PluginEngine *engine : plugin_manager->pluginEngines()) {
+      if (engine->name() == js->engineName() && engine->readyToUse()) {
+        js->setPluginEngine(engine);
+        break;
+      }
+    }
+    if (js->pluginEngine() == nullptr) {
+      showMessage(tr("Plugin %1 used by step %2 is not available, the job "
+            "can't be resumed.").arg(js->engineName()).arg(i));
+      return;
+    }
+  }
+
+  if (!editJobStepParameters(job->getJobStep(job->firstUnfinishedStep())))
+    return;
+
+  // results of the steps being rerun are discarded
+  if (sim_visualizer->shownJob() == job)
+    sim_visualizer->clearJob();
+  if (!job->resumeJob()) {
+    showMessage(tr("Job %1 could not be resumed, check the log for details.")
+        .arg(job->name()));
+  }
+  job_view_model->refreshJob(job);
+}
+
+void JobManager::triggerJobAction(comp::SimJob *job, JobViewModel::JobAction action)
+{
+  switch (action) {
+    case JobViewModel::TerminateAction:
+    {
+      QMessageBox msg;
+      msg.setText("Are you sure that you would like to terminate the job?\nNote: multi-threaded plugins may leave behind orphaned children processes depending on implementation.");
+      msg.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+      msg.setDefaultButton(QMessageBox::No);
+      if (msg.exec() == QMessageBox::Yes)
+        job->terminateJob();
+      break;
+    }
+    case JobViewModel::LogAction:
+      job->terminalOutputDialog()->show();
+      break;
+    case JobViewModel::VisualizeAction:
+      emit job->sig_requestJobVisualization(job);
+      break;
+    case JobViewModel::ExportAction:
+      job->exportJob();
+      break;
+    default:
+      break;
+  }
+  job_view_model->refreshJob(job);
+}
+
+void JobManager::exportSelectedJobs()
+{
+  // collect the jobs of all selected top level rows
+  QList<comp::SimJob*> jobs;
+  for (const QModelIndex &index : tv_job_view->selectionModel()->selectedIndexes()) {
+    comp::SimJob *job = job_view_model->jobAt(index);
+    if (job != nullptr && job->exportable() && !job->exporting()
+        && !jobs.contains(job))
+      jobs.append(job);
+  }
+
+  if (jobs.isEmpty()) {
+    QMessageBox *msg = new QMessageBox(this);
+    msg->setAttribute(Qt::WA_DeleteOnClose);
+    msg->setText(tr("Please select jobs which finished normally, weren't "
+          "imported and aren't being exported already."));
+    msg->open();
+    return;
+  }
+
+  QString dir_path = QFileDialog::getExistingDirectory(this,
+      tr("Export %1 jobs to directory").arg(jobs.length()));
+  if (dir_path.isEmpty())
+    return;
+
+  // each job gets its own archive, numbered if job names collide
+  QDir out_dir(dir_path);
+  QStringList out_paths;
+  for (comp::SimJob *job : jobs) {
+    QString out_path = out_dir.absoluteFilePath(job->name() + ".sqjx.zip");
+    for (int i=1; out_paths.contains(out_path) || QFileInfo(out_path).exists(); i++)
+      out_path = out_dir.absoluteFilePath(QString("%1_%2.sqjx.zip").arg(job->name()).arg(i));
+    out_paths.append(out_path);
+    job->exportJob(out_path);
+  }
+}
+
+bool JobManager::editJobStepParameters(comp::JobStep *job_step)
+{
+  // fill the engine's parameter form with the values of the previous run
+  gui::PropertyMap prop_map = job_step->pluginEngine()->defaultPropertyMap();
+  QMap<QString, QString> params = job_step->jobParameters();
+  for (auto it = prop_map.begin(); it != prop_map.end(); ++it) {
+    if (!params.contains(it.key()))
+      continue;
+    QVariant value(params.value(it.key()));
+    if (value.convert(it.value().value.userType()))
+      it.value().value = value;
+  }
+
+  QDialog d_params(this);
+  d_params.setWindowTitle(tr("Resume Job"));
+  PropertyForm *prop_form = new PropertyForm(prop_map);
+  QDialogButtonBox *dbb_params = new QDialogButtonBox(QDialogButtonBox::Ok
+      | QDialogButtonBox::Cancel);
+  connect(dbb_params, &QDialogButtonBox::accepted, &d_params, &QDialog::accept);
+  connect(dbb_params, &QDialogButtonBox::rejected, &d_params, &QDialog::reject);
+  QScrollArea *sa_params = new QScrollArea();
+  sa_params->setWidget(prop_form);
+  sa_params->setWidgetResizable(true);
+  QVBoxLayout *vl_params = new QVBoxLayout(&d_params);
+  vl_params->addWidget(new QLabel(tr("The job resumes from step %1 (%2), its "
+          "parameters may be changed before it is rerun.")
+        .arg(job_step->jobStepPlacement()).arg(job_step->engineName())));
+  vl_params->addWidget(sa_params);
+  vl_params->addWidget(dbb_params);
+  if (d_params.exec() != QDialog::Accepted)
+    return false;
+
+  gui::PropertyMap final_props = prop_form->finalProperties();
+  for (const QString &key : final_props.keys())
+    params.insert(key, final_props.value(key).value.toString());
+  if (!job_step->updateJobParameters(params)) {
+    QMessageBox::warning(this, tr("Resume Job"), tr("The parameters of step "
+          "%1 could not be updated.").arg(job_step->jobStepPlacement()));
+    return false;
+  }
+  return true;
+}
@@ -15,6 +15,8 @@
 #include "../property_form.h"
 #include "../components/plugin_engine.h"
 #include "../components/sim_job.h"
+#include "../components/job_catalog.h"
+#include "job_view_model.h"
 #include "../visualizers/sim_visualizer.h"
 
 namespace gui{
@@ -44,6 +46,7 @@ namespace gui{
         if (engine->commandFormats().length() > 0)
           command_format = engine->jointCommandFormat(0).second;
         prop_form = new PropertyForm(engine->defaultPropertyMap());
+        res_policy = comp::ResourcePolicy::fromSettings();
       }
 
       //! Construct a dataset with all values specified.
@@ -62,6 +65,7 @@ namespace gui{
       comp::PluginEngine *engine=nullptr;
       QString command_format;           // command format with arguments delimited by "\n".
       PropertyForm *prop_form=nullptr;
+      comp::ResourcePolicy res_policy;  // limits applied to the job step process
     };
 
     //! Constructor.
@@ -83,6 +87,10 @@ namespace gui{
     //! Process a finished job.
     void processFinishedJob(comp::SimJob *job, comp::SimJob::JobState finish_state);
 
+    //! Delete the directories of old jobs which exceed the runtime temp quota,
+    //! keeping those of the jobs in this manager.
+    void cleanUpJobDirs();
+
     //! Returns whether the job can be shown in SimVisualizer (might want to make
     //! this a SimVisualizer function instead).
     bool eligibleForSimVisualizer(comp::SimJob *job);
@@ -149,6 +157,24 @@ namespace gui{
     //! Initialize the job view panel.
     QWidget *initJobViewPanel();
 
+    //! Show a dialog with the resource usage of all finished job steps
+    //! aggregated per engine.
+    void showEngineResourceStats();
+
+    //! Resume the job selected in the job view from its first unfinished step.
+    void resumeSelectedJob();
+
+    //! Carry out an action requested from the actions column of the job view.
+    void triggerJobAction(comp::SimJob *job, JobViewModel::JobAction action);
+
+    //! Export all jobs selected in the job view into a directory chosen by the
+    //! user. The exports run in parallel.
+    void exportSelectedJobs();
+
+    //! Let the user edit the parameters of a job step about to be rerun.
+    //! Returns whether the user confirmed and the parameters were applied.
+    bool editJobStepParameters(comp::JobStep *job_step);
+
     //! Return the engine currently selected on the engine list, or a null
     //! pointer if none is selected.
     comp::PluginEngine *selectedEngine();
@@ -165,7 +191,7 @@ namespace gui{
     QSortFilterProxyModel *eng_filter_proxy_model;    // proxy model for filtering eng_model
     QStandardItemModel *cat_filter_model; // data model storing the filter items used for filtering eng_model
     QStandardItemModel *job_steps_model;  // data model storing the job steps engine sequence
-    QStandardItemModel *job_view_model;   // data model storing the list of submitted and completed jobs
+    JobViewModel *job_view_model;         // data model presenting the submitted and completed jobs
     QList<comp::PluginEngine::StandardItemField> eng_list_fields; // order of fields in eng_model
 
     // GUI elements that need class-wide access
@@ -210,6 +236,7 @@ namespace gui{
     {
       QString name;
       gui::DesignInclusionArea inclusion_area;
+      bool use_result_cache;
     };
 
     //! Constructor.
@@ -234,6 +261,7 @@ namespace gui{
       QMetaEnum inc_a_enum = QMetaEnum::fromType<IA>();
       job_details.inclusion_area = static_cast<IA>(inc_a_enum.keyToValue(
             cbb_inclusion_area->currentText().toLatin1()));
+      job_details.use_result_cache = cb_use_result_cache->isChecked();
       return job_details;
     }
     
@@ -247,12 +275,17 @@ namespace gui{
     QVBoxLayout *vl_institutions;                   // list of institutions
     QVBoxLayout *vl_links;                          // list of links
     QComboBox *cbb_inclusion_area;                  // inclusion area
+    QCheckBox *cb_use_result_cache;                 // reuse results of identical problems
     QLabel *l_plugin_name;                          // plugin name
     QLabel *l_plugin_status;                        // plugin status
     QPushButton *pb_refresh_status;                 // refresh the plugin status
     QMenu *menu_command_preset;                     // command format preset selection menu
     QTextEdit *te_command;                          // command format edit field
     QVBoxLayout *vl_plugin_params;                  // layout holding engine property form
+    QLineEdit *le_cpu_affinity;                     // CPU affinity of the plugin process
+    QSpinBox *sb_nice;                              // niceness increment of the plugin process
+    QSpinBox *sb_memory_limit;                      // memory limit of the plugin process
+    QSpinBox *sb_timeout;                           // wall-clock limit of the plugin process
   };
 
 
@@ -0,0 +1,321 @@
+// @file:     job_view_model.cc
+// @author:   Samuel
+// @created:  2020.06.29
+// @license:  GNU LGPL v3
+//
+// @desc:     JobViewModel and JobActionDelegate implementations.
+
+#include "job_view_model.h"
+
+using namespace gui;
+
+
+// JobViewModel
+
+void JobViewModel::addJob(comp::SimJob *job)
+{
+  if (job_orders.contains(job))
+    return;
+
+  beginInsertRows(QModelIndex(), 0, 0);
+  job_orders.insert(job, jobs.size());
+  jobs.append(job);
+  step_counts.insert(job, job->jobSteps().size());
+  endInsertRows();
+
+  connect(job, &comp::SimJob::sig_statusChanged, this, &JobViewModel::refreshJob);
+  connect(job, &comp::SimJob::sig_exportFinished, this, &JobViewModel::refreshJob);
+}
+
+void JobViewModel::refreshJob(comp::SimJob *job)
+{
+  int row = jobRow(job);
+  if (row < 0)
+    return;
+
+  // steps might have been added before the job was run
+  QModelIndex job_index = index(row, 0);
+  int old_count = step_counts.value(job);
+  int new_count = job->jobSteps().size();
+  if (new_count > old_count) {
+    beginInsertRows(job_index, old_count, new_count - 1);
+    step_counts.insert(job, new_count);
+    endInsertRows();
+  } else if (new_count < old_count) {
+    beginRemoveRows(job_index, new_count, old_count - 1);
+    step_counts.insert(job, new_count);
+    endRemoveRows();
+  }
+
+  emit dataChanged(job_index, index(row, ColumnCount-1));
+  if (new_count > 0)
+    emit dataChanged(index(0, 0, job_index), index(new_count-1, ColumnCount-1, job_index));
+}
+
+comp::SimJob *JobViewModel::jobAt(const QModelIndex &index) const
+{
+  if (!index.isValid())
+    return nullptr;
+  if (index.internalPointer() != nullptr)
+    return static_cast<comp::SimJob*>(index.internalPointer());
+  return jobInRow(index.row());
+}
+
+QString JobViewModel::actionText(JobAction action)
+{
+  switch (action) {
+    case TerminateAction:
+      return tr("Terminate");
+    case LogAction:
+      return tr("Log");
+    case VisualizeAction:
+      return tr("Visualize Results");
+    case ExportAction:
+      return tr("Export Results");
+    default:
+      return QString();
+  }
+}
+
+bool JobViewModel::actionEnabled(comp::SimJob *job, JobAction action)
+{
+  switch (action) {
+    case TerminateAction:
+      return job->terminable();
+    case ExportAction:
+      return job->exportable() && !job->exporting();
+    default:
+      return true;
+  }
+}
+
+QModelIndex JobViewModel::index(int row, int column, const QModelIndex &parent) const
+{
+  if (row < 0 || column < 0 || column >= ColumnCount)
+    return QModelIndex();
+
+  // job steps point to their job, jobs don't point anywhere
+  if (!parent.isValid()) {
+    if (row >= jobs.size())
+      return QModelIndex();
+    return createIndex(row, column);
+  }
+  if (parent.internalPointer() != nullptr || parent.row() >= jobs.size())
+    return QModelIndex();
+  comp::SimJob *job = jobInRow(parent.row());
+  if (row >= step_counts.value(job))
+    return QModelIndex();
+  return createIndex(row, column, job);
+}
+
+QModelIndex JobViewModel::parent(const QModelIndex &child) const
+{
+  if (!child.isValid() || child.internalPointer() == nullptr)
+    return QModelIndex();
+  return createIndex(jobRow(static_cast<comp::SimJob*>(child.internalPointer())), 0);
+}
+
+int JobViewModel::rowCount(const QModelIndex &parent) const
+{
+  if (!parent.isValid())
+    return jobs.size();
+  if (parent.internalPointer() != nullptr || parent.column() != 0)
+    return 0;
+  return step_counts.value(jobInRow(parent.row()));
+}
+
+int JobViewModel::columnCount(const QModelIndex &) const
+{
+  return ColumnCount;
+}
+
+QVariant JobViewModel::data(const QModelIndex &index, int role) const
+{
+  if (!index.isValid())
+    return QVariant();
+  comp::SimJob *job = jobAt(index);
+
+  if (index.internalPointer() == nullptr) {
+    // job row
+    if (role == Qt::DisplayRole) {
+      if (index.column() == NameColumn)
+        return job->name();
+      else if (index.column() == StatusColumn)
+        return job->statusText();
+    } else if (role == Qt::ToolTipRole && index.column() == NameColumn) {
+      return job->jobTempDirPath();
+    }
+    return QVariant();
+  }
+
+  // job step row
+  if (role != Qt::DisplayRole && role != Qt::ToolTipRole)
+    return QVariant();
+  comp::JobStep *js = job->getJobStep(index.row());
+  if (index.column() == NameColumn && role == Qt::DisplayRole) {
+    return tr("Step %1: %2").arg(js->jobStepPlacement()).arg(js->engineName());
+  } else if (index.column() == NameColumn || index.column() == StatusColumn) {
+    QString text = js->fromCache() ? tr("Reused cached result")
+      : js->resourceUsage().summary();
+    if (role == Qt::ToolTipRole) {
+      QString energy_text = lowestEnergyText(js);
+      if (!energy_text.isEmpty())
+        text += "\n" + energy_text;
+    }
+    return text;
+  }
+  return QVariant();
+}
+
+QVariant JobViewModel::headerData(int section, Qt::Orientation orientation,
+    int role) const
+{
+  if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+    return QVariant();
+  switch (section) {
+    case NameColumn:
+      return tr("Job");
+    case StatusColumn:
+      return tr("Status");
+    case ActionsColumn:
+      return tr("Actions");
+    default:
+      return QVariant();
+  }
+}
+
+Qt::ItemFlags JobViewModel::flags(const QModelIndex &index) const
+{
+  if (!index.isValid())
+    return Qt::NoItemFlags;
+  return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+
+QString JobViewModel::lowestEnergyText(comp::JobStep *js)
+{
+  if (js->designHash().isEmpty()
+      || !js->resultTypes().contains(comp::JobResult::ChargeConfigsResult))
+    return QString();
+  comp::JobCatalog *catalog = comp::JobCatalog::instance();
+  QString best_dir_path;
+  int best_step_ind;
+  if (!catalog->lowestEnergyStep(js->designHash(), &best_dir_path, &best_step_ind))
+    return QString();
+  comp::JobCatalog::JobRecord best_job = catalog->job(best_dir_path);
+  return tr("Lowest energy of this design across all runs: %1 in step %2 of job %3")
+    .arg(best_job.steps.at(best_step_ind).min_energy).arg(best_step_ind)
+    .arg(best_job.name);
+}
+
+
+// JobActionDelegate
+
+void JobActionDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+    const QModelIndex &index) const
+{
+  QStyledItemDelegate::paint(painter, option, index);
+  const JobViewModel *model = qobject_cast<const JobViewModel*>(index.model());
+  if (model == nullptr || index.column() != JobViewModel::ActionsColumn
+      || index.parent().isValid())
+    return;
+
+  comp::SimJob *job = model->jobAt(index);
+  QStyle *style = option.widget ? option.widget->style() : QApplication::style();
+  for (int i=0; i<JobViewModel::JobActionCount; i++) {
+    JobViewModel::JobAction action = static_cast<JobViewModel::JobAction>(i);
+    QStyleOptionButton button;
+    button.rect = buttonRect(option, action);
+    button.text = JobViewModel::actionText(action);
+    button.fontMetrics = option.fontMetrics;
+    button.state = QStyle::State_Raised;
+    if (JobViewModel::actionEnabled(job, action))
+      button.state |= QStyle::State_Enabled;
+    if (pressed_index == index && pressed_action == i)
+      button.state |= QStyle::State_Sunken;
+    style->drawControl(QStyle::CE_PushButton, &button, painter, option.widget);
+  }
+}
+
+QSize JobActionDelegate::sizeHint(const QStyleOptionViewItem &option,
+    const QModelIndex &index) const
+{
+  QSize size = QStyledItemDelegate::sizeHint(option, index);
+  if (index.column() != JobViewModel::ActionsColumn || index.parent().isValid())
+    return size;
+  return actionsSize(option).expandedTo(size);
+}
+
+QSize JobActionDelegate::actionsSize(const QStyleOptionViewItem &option) const
+{
+  QSize size;
+  for (int i=0; i<JobViewModel::JobActionCount; i++) {
+    QSize button_size = buttonSize(option, static_cast<JobViewModel::JobAction>(i));
+    size.setWidth(size.width() + button_size.width());
+    size.setHeight(qMax(size.height(), button_size.height()));
+  }
+  return size;
+}
+
+bool JobActionDelegate::editorEvent(QEvent *event, QAbstractItemModel *model,
+    const QStyleOptionViewItem &option, const QModelIndex &index)
+{
+  JobViewModel *job_model = qobject_cast<JobViewModel*>(model);
+  if (job_model == nullptr || index.column() != JobViewModel::ActionsColumn
+      || index.parent().isValid())
+    return QStyledItemDelegate::editorEvent(event, model, option, index);
+  if (event->type() != QEvent::MouseButtonPress
+      && event->type() != QEvent::MouseButtonRelease)
+    return QStyledItemDelegate::editorEvent(event, model, option, index);
+
+  // find the button under the cursor
+  comp::SimJob *job = job_model->jobAt(index);
+  QPoint pos = static_cast<QMouseEvent*>(event)->pos();
+  int action = -1;
+  for (int i=0; i<JobViewModel::JobActionCount; i++) {
+    JobViewModel::JobAction a = static_cast<JobViewModel::JobAction>(i);
+    if (buttonRect(option, a).contains(pos) && JobViewModel::actionEnabled(job, a))
+      action = i;
+  }
+
+  QAbstractItemView *view = qobject_cast<QAbstractItemView*>(parent());
+  if (event->type() == QEvent::MouseButtonPress) {
+    pressed_index = index;
+    pressed_action = action;
+  } else {
+    bool clicked = pressed_index == index && pressed_action == action && action >= 0;
+    pressed_index = QPersistentModelIndex();
+    pressed_action = -1;
+    if (view != nullptr)
+      view->viewport()->update();
+    if (clicked)
+      emit sig_actionTriggered(job, static_cast<JobViewModel::JobAction>(action));
+    return clicked;
+  }
+  if (view != nullptr)
+    view->viewport()->update();
+  return action >= 0;
+}
+
+QRect JobActionDelegate::buttonRect(const QStyleOptionViewItem &option,
+    JobViewModel::JobAction action) const
+{
+  // buttons are laid out left to right in the order of the actions
+  int x = option.rect.left();
+  for (int i=0; i<action; i++)
+    x += buttonSize(option, static_cast<JobViewModel::JobAction>(i)).width();
+  QSize size = buttonSize(option, action);
+  return QRect(x, option.rect.top(), size.width(), option.rect.height());
+}
+
+QSize JobActionDelegate::buttonSize(const QStyleOptionViewItem &option,
+    JobViewModel::JobAction action) const
+{
+  QStyle *style = option.widget ? option.widget->style() : QApplication::style();
+  QStyleOptionButton button;
+  button.text = JobViewModel::actionText(action);
+  button.fontMetrics = option.fontMetrics;
+  QSize text_size = option.fontMetrics.size(Qt::TextShowMnemonic, button.text);
+  return style->sizeFromContents(QStyle::CT_PushButton, &button, text_size,
+      option.widget);
+}
@@ -0,0 +1,130 @@
+// @file:     job_view_model.h
+// @author:   Samuel
+// @created:  2020.06.29
+// @license:  GNU LGPL v3
+//
+// @desc:     Item model and delegate of the job view in the job manager.
+
+#ifndef _GUI_JOB_VIEW_MODEL_H_
+#define _GUI_JOB_VIEW_MODEL_H_
+
+#include <QtWidgets>
+
+#include "../components/sim_job.h"
+#include "../components/job_catalog.h"
+
+namespace gui{
+
+  //! Item model presenting jobs as top level rows with their job steps as
+  //! children. Rows are computed from the jobs on request rather than stored,
+  //! so views only pay for the rows they show. Newest jobs come first.
+  class JobViewModel : public QAbstractItemModel
+  {
+    Q_OBJECT
+
+  public:
+
+    enum Column{NameColumn, StatusColumn, ActionsColumn, ColumnCount};
+
+    //! Actions offered for each job in the actions column.
+    enum JobAction{TerminateAction, LogAction, VisualizeAction, ExportAction,
+      JobActionCount};
+    Q_ENUM(JobAction)
+
+    //! Constructor.
+    JobViewModel(QObject *parent=nullptr) : QAbstractItemModel(parent) {};
+
+    //! Add a job as the first row. Does nothing if the job was added already.
+    void addJob(comp::SimJob *job);
+
+    //! Update the rows of the job and its steps, e.g. after steps finished.
+    void refreshJob(comp::SimJob *job);
+
+    //! Return the job of the index, which is the parent job for job step
+    //! indices, or a null pointer for invalid indices.
+    comp::SimJob *jobAt(const QModelIndex &index) const;
+
+    //! Return the label of the action.
+    static QString actionText(JobAction action);
+
+    //! Return whether the action is available for the job.
+    static bool actionEnabled(comp::SimJob *job, JobAction action);
+
+    // QAbstractItemModel interface
+    QModelIndex index(int row, int column,
+        const QModelIndex &parent=QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent=QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent=QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+        int role=Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+  private:
+
+    //! Return a description of the lowest energy found for the design of the
+    //! job step across all catalogued runs, empty if none is known.
+    static QString lowestEnergyText(comp::JobStep *js);
+
+    //! Return the top level row of the job, -1 if it isn't in the model.
+    int jobRow(comp::SimJob *job) const
+    {
+      int order = job_orders.value(job, -1);
+      return order < 0 ? -1 : jobs.size() - 1 - order;
+    }
+
+    //! Return the job in the top level row.
+    comp::SimJob *jobInRow(int row) const {return jobs.at(jobs.size() - 1 - row);}
+
+    QVector<comp::SimJob*> jobs;            // jobs in the order they were added
+    QHash<comp::SimJob*, int> job_orders;   // index of each job in jobs
+    QHash<comp::SimJob*, int> step_counts;  // child rows currently presented for each job
+  };
+
+  //! Paints the job actions of JobViewModel as buttons in the actions column
+  //! and reports clicks on them. No widgets are created for the rows.
+  class JobActionDelegate : public QStyledItemDelegate
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Constructor.
+    JobActionDelegate(QObject *parent=nullptr) : QStyledItemDelegate(parent) {};
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+        const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option,
+        const QModelIndex &index) const override;
+
+    //! Return the size taken by the buttons of all actions.
+    QSize actionsSize(const QStyleOptionViewItem &option) const;
+
+  signals:
+
+    //! Emitted when the button of an action has been clicked.
+    void sig_actionTriggered(comp::SimJob *job, JobViewModel::JobAction action);
+
+  protected:
+
+    bool editorEvent(QEvent *event, QAbstractItemModel *model,
+        const QStyleOptionViewItem &option, const QModelIndex &index) override;
+
+  private:
+
+    //! Return the rectangle of the action button within the cell.
+    QRect buttonRect(const QStyleOptionViewItem &option,
+        JobViewModel::JobAction action) const;
+
+    //! Return the size of the button of the action.
+    QSize buttonSize(const QStyleOptionViewItem &option,
+        JobViewModel::JobAction action) const;
+
+    QPersistentModelIndex pressed_index;  // cell of the button being pressed
+    int pressed_action=-1;                // action of the button being pressed
+  };
+
+} // end of gui namespace
+
+#endif
@@ -264,6 +264,16 @@ void LayerManager::setActiveLayer(prim::Layer *layer)
   side_widget->updateCurrentLayer(layer);
 }
 
+int LayerManager::itemCount() const
+{
+  int count = 0;
+  for (prim::Layer *layer : layers)
+    count += layer->itemCount();
+  for (prim::Layer *layer : simvislayers)
+    count += layer->itemCount();
+  return count;
+}
+
 int LayerManager::indexOf(prim::Layer *layer) const
 {
   return layer==0 ? layers.indexOf(active_layer) : layers.indexOf(layer);
@@ -191,6 +191,9 @@ namespace gui{
     //! Returns the number of layers in the layers stack.
     int layerCount() const {return layers.count();}
 
+    //! Returns the number of items in all design and result layers.
+    int itemCount() const;
+
     //! Returns the pointer to the active layer.
     prim::Layer* activeLayer() {return active_layer;}
 
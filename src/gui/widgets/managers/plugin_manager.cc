@@ -7,17 +7,45 @@
 
 #include "plugin_manager.h"
 #include "settings/settings.h"
+#include "../components/profiler.h"
+
+#include <QtConcurrent>
 
 using namespace gui;
 
+namespace {
+  // constructs plugin engines on worker threads and hands them over to the
+  // thread of the plugin manager
+  struct PluginEngineLoader
+  {
+    typedef comp::PluginEngine *result_type;
+
+    QString preset_root_path;
+    QThread *target_thread;
+
+    comp::PluginEngine *operator()(const QString &desc_path) const
+    {
+      SQ_PROFILE_SCOPE("PluginManager::loadPluginEngine");
+      comp::PluginEngine *eng = new comp::PluginEngine(desc_path, preset_root_path);
+      eng->moveToThread(target_thread);
+      return eng;
+    }
+  };
+}
+
 PluginManager::PluginManager(QWidget *parent)
   : QWidget(parent, Qt::Dialog)
 {
+  initServiceTypes();
+  initGui();
+
+  // the Python path and plugins are resolved on worker threads, engines are
+  // added to the list as they become available
   if (gui::python_path.isEmpty())
     initPythonPath();
-  initServiceTypes();
+  else
+    setPythonPathReady();
   initPluginEngines();
-  initGui();
 }
 
 PluginManager::~PluginManager()
@@ -33,26 +61,8 @@ void PluginManager::refreshPluginList()
 {
   plugins_model->clear();
   plugins_model->setColumnCount(3);
-  for (comp::PluginEngine *eng : plugin_engines) {
-    QList<QStandardItem*> row_plug_info;
-    row_plug_info.append(new QStandardItem(eng->name()));
-    //row_plug_info.append(new QStandardItem(eng->pluginRootPath()));
-    plugins_model->appendRow(row_plug_info);
-    tv_plugins->resizeColumnToContents(0);
-
-    QList<QWidget*> row_widgets({
-        eng->widgetVenvStatus(),
-        eng->widgetVenvInitLog()
-        });
-
-    QModelIndex mi_back = plugins_model->indexFromItem(row_plug_info.back());
-    int col_start = mi_back.column() + 1;
-    for (int col=col_start; col < col_start + row_widgets.size(); col++) {
-      tv_plugins->setIndexWidget(plugins_model->index(mi_back.row(),
-            col), row_widgets[col-col_start]);
-      tv_plugins->resizeColumnToContents(col);
-    }
-  }
+  for (comp::PluginEngine *eng : plugin_engines)
+    appendPluginRow(eng);
 }
 
 
@@ -61,24 +71,30 @@ void PluginManager::refreshPluginList()
 void PluginManager::initPythonPath()
 {
   // NOTE dropped in from SimManager implementation, TODO improve (e.g. virualenv, docker, etc.)
-  QString s_py = settings::AppSettings::instance()->get<QString>("user_python_path");
+  settings::AppSettings *app_settings = settings::AppSettings::instance();
+  QString s_py = app_settings->get<QString>("user_python_path");
 
   if (!s_py.isEmpty()) {
     gui::python_path = s_py;
     qDebug() << tr("Python path retrieved from user settings: %1").arg(gui::python_path);
-  } else {
-    if (!findWorkingPythonPath())
-      qWarning() << "No Python 3 interpreter found. Please set it in the settings dialog.";
+    setPythonPathReady();
+    return;
+  }
+
+  // use the last known-good interpreter if it is still around
+  QString cached_py = app_settings->get<QString>("cached_python_path");
+  if (!cached_py.isEmpty()
+      && !QStandardPaths::findExecutable(cached_py.split(',').first()).isEmpty()) {
+    gui::python_path = cached_py;
+    qDebug() << tr("Python path retrieved from cache: %1").arg(gui::python_path);
+    setPythonPathReady();
+    return;
   }
-}
 
-bool PluginManager::findWorkingPythonPath()
-{
-  // NOTE dropped in from SimManager implementation, TODO improve
   QStringList test_py_paths;
   QString kernel_type = QSysInfo::kernelType();
-  auto get_py_paths = [](const QString &os) -> QStringList {
-    return settings::AppSettings::instance()->getPaths("python_search_"+os);
+  auto get_py_paths = [app_settings](const QString &os) -> QStringList {
+    return app_settings->getPaths("python_search_"+os);
   };
   if (kernel_type == "linux" || kernel_type == "freebsd") {
     test_py_paths << get_py_paths("linux");
@@ -88,46 +104,88 @@ bool PluginManager::findWorkingPythonPath()
     test_py_paths << get_py_paths("darwin");
   } else {
     qWarning() << tr("No Python search path defined for your kernel type %1. Please enter your Python binary path in the Settings dialog and restart the application.").arg(kernel_type);
-    return false;
+    setPythonPathReady();
+    return;
   }
 
   QString test_script = QDir(QCoreApplication::applicationDirPath()).filePath("helpers/is_python3.py");
   if (!QFile::exists(test_script)) {
     qDebug() << tr("Python version test script %1 not found").arg(test_script);
-    return false;
+    setPythonPathReady();
+    return;
   }
 
+  // probe the search paths on a worker thread
+  QFutureWatcher<QString> *py_watcher = new QFutureWatcher<QString>(this);
+  connect(py_watcher, &QFutureWatcher<QString>::finished,
+      [this, py_watcher]()
+      {
+        QString py_path = py_watcher->result();
+        if (py_path.isEmpty()) {
+          qWarning() << "No Python 3 interpreter found. Please set it in the settings dialog.";
+        } else {
+          gui::python_path = py_path;
+          settings::AppSettings::instance()->setValue("cached_python_path", py_path);
+          qDebug() << tr("Python path found: %1").arg(gui::python_path);
+        }
+        py_watcher->deleteLater();
+        setPythonPathReady();
+      });
+  py_watcher->setFuture(QtConcurrent::run(&PluginManager::findWorkingPythonPath,
+        test_py_paths, test_script));
+}
+
+QString PluginManager::findWorkingPythonPath(const QStringList &test_py_paths,
+    const QString &test_script)
+{
+  SQ_PROFILE_SCOPE("PluginManager::findWorkingPythonPath");
 
+  // launch all candidates at once so the search takes as long as the slowest
+  // candidate rather than the sum of all of them
+  QList<QProcess*> py_processes;
   for (QString test_py_path : test_py_paths) {
     QStringList splitted_path = test_py_path.split(',');
-    if (splitted_path.size() == 0)
-      continue;
 
     // set up command and arguments
     QString command = splitted_path.at(0);
     QStringList args = splitted_path.mid(1);
     args << test_script;
 
-    QString output;
-    QProcess *py_process = new QProcess(this);
-    //py_process->start(test_py_path, {test_script});
+    QProcess *py_process = new QProcess();
     py_process->start(command, args);
-    py_process->waitForStarted(1000);
-
-    // run the test script
-    while(py_process->waitForReadyRead(1000))
-      output.append(QString::fromStdString(py_process->readAll().toStdString()));
-    
-    if (output.contains("Python3 Interpretor Found")) {
-      gui::python_path = test_py_path;
-      qDebug() << tr("Python path found: %1").arg(gui::python_path);
-      return true;
-    } else {
-      qDebug() << tr("Python path %1 is invalid. Output: %2").arg(test_py_path).arg(output);
+    py_processes.append(py_process);
+  }
+
+  // take the first working candidate in the order of preference
+  QString found_path;
+  for (int i=0; i<py_processes.size(); i++) {
+    QProcess *py_process = py_processes.at(i);
+    if (found_path.isEmpty()) {
+      py_process->waitForFinished(5000);
+      QString output = QString::fromUtf8(py_process->readAllStandardOutput());
+      if (output.contains("Python3 Interpretor Found")) {
+        found_path = test_py_paths.at(i);
+      } else {
+        qDebug() << tr("Python path %1 is invalid. Output: %2").arg(test_py_paths.at(i)).arg(output);
+      }
+    }
+    if (py_process->state() != QProcess::NotRunning) {
+      py_process->kill();
+      py_process->waitForFinished(1000);
     }
+    delete py_process;
   }
 
-  return false;
+  return found_path;
+}
+
+void PluginManager::setPythonPathReady()
+{
+  python_path_ready = true;
+  for (comp::PluginEngine *engine : plugin_engines)
+    engine->prepareVirtualenv();
+  if (initialized())
+    emit sig_initialized();
 }
 
 void PluginManager::initServiceTypes()
@@ -181,8 +239,46 @@ void PluginManager::initServiceTypes()
 
 void PluginManager::initPluginEngines()
 {
-  // initialize engines
-  QStringList eng_lib_dir_paths = settings::AppSettings::instance()->getPaths("plugs/eng_lib_dirs");
+  settings::AppSettings *app_settings = settings::AppSettings::instance();
+  QStringList eng_lib_dir_paths = app_settings->getPaths("plugs/eng_lib_dirs");
+  QString preset_root_path = app_settings->getPath("plugs/preset_root_path");
+
+  // scan the engine libraries on a worker thread, then read the description
+  // files in parallel
+  QFutureWatcher<QStringList> *scan_watcher = new QFutureWatcher<QStringList>(this);
+  connect(scan_watcher, &QFutureWatcher<QStringList>::finished,
+      [this, scan_watcher, preset_root_path]()
+      {
+        QStringList eng_dec_paths = scan_watcher->result();
+        scan_watcher->deleteLater();
+
+        QFutureWatcher<comp::PluginEngine*> *eng_watcher
+          = new QFutureWatcher<comp::PluginEngine*>(this);
+        connect(eng_watcher, &QFutureWatcher<comp::PluginEngine*>::resultReadyAt,
+            [this, eng_watcher](int ind)
+            {
+              addPluginEngine(eng_watcher->resultAt(ind));
+            });
+        connect(eng_watcher, &QFutureWatcher<comp::PluginEngine*>::finished,
+            [this, eng_watcher]()
+            {
+              qDebug() << tr("Finished reading plugin files.");
+              eng_watcher->deleteLater();
+              engines_loaded = true;
+              if (initialized())
+                emit sig_initialized();
+            });
+        eng_watcher->setFuture(QtConcurrent::mapped(eng_dec_paths,
+              PluginEngineLoader{preset_root_path, thread()}));
+      });
+  scan_watcher->setFuture(QtConcurrent::run(&PluginManager::findPluginDescriptionFiles,
+        eng_lib_dir_paths));
+}
+
+QStringList PluginManager::findPluginDescriptionFiles(const QStringList &eng_lib_dir_paths)
+{
+  SQ_PROFILE_SCOPE("PluginManager::findPluginDescriptionFiles");
+  QStringList eng_dec_paths;
 
   // go through all possible plugin locations
   for (QString eng_lib_dir_path : eng_lib_dir_paths) {
@@ -196,7 +292,6 @@ void PluginManager::initPluginEngines()
         QDir::AllDirs | QDir::NoDotAndDotDot);
 
     // find all existing engines in the engine library
-    QStringList eng_dec_paths;
     QStringList eng_filter(QStringList() << "*.physeng" << "*.sqplug");
     for (QString engine_dir_path : engine_dir_paths) {
       qDebug() << tr("Checking %1 for engine description file").arg(engine_dir_path);
@@ -209,15 +304,43 @@ void PluginManager::initPluginEngines()
         qDebug() << tr("Found engine file: %1").arg(eng_dec_paths.back());
       }
     }
-
-    // import engines corresponding to the list of declaration files
-    for (QString eng_dec_path : eng_dec_paths) {
-      comp::PluginEngine *eng = new comp::PluginEngine(eng_dec_path);
-      plugin_engines.insert(eng->uniqueIdentifier(), eng);
-    }
   }
 
-  qDebug() << tr("Finished reading plugin files.");
+  return eng_dec_paths;
+}
+
+void PluginManager::addPluginEngine(comp::PluginEngine *engine)
+{
+  plugin_engines.insert(engine->uniqueIdentifier(), engine);
+  appendPluginRow(engine);
+
+  // otherwise prepared once the Python path is known
+  if (python_path_ready)
+    engine->prepareVirtualenv();
+
+  emit sig_pluginEngineAdded(engine);
+}
+
+void PluginManager::appendPluginRow(comp::PluginEngine *eng)
+{
+  QList<QStandardItem*> row_plug_info;
+  row_plug_info.append(new QStandardItem(eng->name()));
+  //row_plug_info.append(new QStandardItem(eng->pluginRootPath()));
+  plugins_model->appendRow(row_plug_info);
+  tv_plugins->resizeColumnToContents(0);
+
+  QList<QWidget*> row_widgets({
+      eng->widgetVenvStatus(),
+      eng->widgetVenvInitLog()
+      });
+
+  QModelIndex mi_back = plugins_model->indexFromItem(row_plug_info.back());
+  int col_start = mi_back.column() + 1;
+  for (int col=col_start; col < col_start + row_widgets.size(); col++) {
+    tv_plugins->setIndexWidget(plugins_model->index(mi_back.row(),
+          col), row_widgets[col-col_start]);
+    tv_plugins->resizeColumnToContents(col);
+  }
 }
 
 void PluginManager::initGui()
@@ -29,6 +29,10 @@ namespace gui{
     //! Refresh the plugin list.
     void refreshPluginList();
 
+    //! Return whether the Python path has been resolved and all discovered
+    //! plugin engines have been loaded.
+    bool initialized() const {return python_path_ready && engines_loaded;}
+
     //! Return the plugin count.
     int count() const {return plugin_engines.count();}
 
@@ -46,31 +50,58 @@ namespace gui{
 
     // TODO engine list with specific services
 
+  signals:
+
+    //! Emitted when a plugin engine has been discovered and added.
+    void sig_pluginEngineAdded(comp::PluginEngine *engine);
+
+    //! Emitted once initialized() becomes true.
+    void sig_initialized();
+
 
   private:
 
     //! Initialize Python path. If a user preference has been set before, use 
-    //! that one. Otherwise, check whether any of the default Python search 
-    //! paths contain an invokable Python 3 interpreter and show a pop-up dialog
-    //! asking the user to choose the preferred one. The user may also enter a 
-    //! custom path in that dialog.
+    //! that one. Otherwise, use the last known-good interpreter if it still
+    //! exists, or check on a worker thread whether any of the default Python
+    //! search paths contain an invokable Python 3 interpreter.
     void initPythonPath();
 
-    //! Find python path.
-    bool findWorkingPythonPath();
+    //! Find python path. All search paths are probed concurrently and the
+    //! first working one in the order given is returned, an empty string if
+    //! none works. Safe to call from worker threads.
+    static QString findWorkingPythonPath(const QStringList &test_py_paths,
+        const QString &test_script);
+
+    //! Mark the Python path as resolved and prepare the virtual environments
+    //! of the engines discovered so far.
+    void setPythonPathReady();
 
     //! Initialize plugin service types.
     void initServiceTypes();
 
-    //! Initialize engines.
+    //! Initialize engines. Plugin directories are scanned and description
+    //! files read on worker threads, engines are added as they arrive.
     void initPluginEngines();
 
+    //! Return the description file paths found in the engine libraries. Safe
+    //! to call from worker threads.
+    static QStringList findPluginDescriptionFiles(const QStringList &eng_lib_dir_paths);
+
+    //! Add a discovered engine to the engine map and the plugin list.
+    void addPluginEngine(comp::PluginEngine *engine);
+
+    //! Append a row representing the engine to the plugin list.
+    void appendPluginRow(comp::PluginEngine *eng);
+
     //! Initialize GUI.
     void initGui();
 
     // Map of plugin unique identifier to plugin engine pointers. This map 
     // contains all plugin engines.
     QMap<uint, comp::PluginEngine*> plugin_engines;
+    bool python_path_ready=false; // Python path has been resolved
+    bool engines_loaded=false;    // all plugin description files have been read
 
     // GUI elements
     QTreeView *tv_plugins;              // tree view of all plugins
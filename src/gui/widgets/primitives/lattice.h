@@ -83,6 +83,15 @@ namespace prim{
     //! Save the lattice layer to XML stream.
     void saveLayer(QXmlStreamWriter *) const override;
 
+    //! Return the lattice name.
+    QString latticeName() const {return lattice_name;}
+
+    //! Return specified lattice vector in angstrom.
+    QPointF latticeVector(int dim) const {return a[dim];}
+
+    //! Return the unit cell site vectors in angstrom.
+    QList<QPointF> siteVectors() const {return b;}
+
     //! Return specified lattice vector after graphical scaling
     QPoint sceneLatticeVector(int dim) const {return a_scene[dim];}
 
@@ -119,7 +128,6 @@ namespace prim{
 
     //! Set lattice dot location to be occupied
     void setOccupied(const prim::LatticeCoord &l_coord, prim::DBDot *dbdot) {
-      qDebug() << tr("set occupied %1, %2, %3").arg(l_coord.n).arg(l_coord.m).arg(l_coord.l);
       occ_latdots.insert(l_coord, dbdot);
     }
 
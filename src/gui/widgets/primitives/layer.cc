@@ -109,6 +109,16 @@ void prim::Layer::addItem(prim::Item *item, int index)
 }
 
 
+void prim::Layer::addItems(const QList<prim::Item*> &new_items)
+{
+  items.reserve(items.size() + new_items.size());
+  for (prim::Item *item : new_items) {
+    items.append(item);
+    item->setActive(active);
+    item->setVisible(visible);
+  }
+}
+
 
 bool prim::Layer::removeItem(prim::Item *item)
 {
@@ -215,32 +225,7 @@ void prim::Layer::loadItems(QXmlStreamReader *rs, QGraphicsScene *scene)
   qDebug() << QObject::tr("Loading layer items for %1").arg(name);
   // create items according to hierarchy
   while(rs->readNextStartElement()) {
-    qDebug() << rs->name();
-    if (rs->name() == "dbdot") {
-      //rs->readNext();
-      prim::DBDot *dbdot = new prim::DBDot(rs, scene, layer_id);
-      addItem(dbdot);
-      prim::Emitter::instance()->addItemToScene(dbdot);
-      static_cast<prim::DBLayer*>(this)->getLattice()->setOccupied(dbdot->latticeCoord(), dbdot);
-      prim::LatticeCoord lc = dbdot->latticeCoord();
-      prim::Emitter::instance()->sig_moveDBToLatticeCoord(dbdot, lc.n, lc.m, lc.l);
-    } else if (rs->name() == "aggregate") {
-      // TODO pass a blank list to Aggregate 
-      QList<prim::Item*> new_items;
-      addItem(new prim::Aggregate(rs, scene, new_items, layer_id));
-      for (prim::Item *item : new_items) {
-        if (item->item_type == prim::Item::DBDot) {
-          prim::DBDot *dbdot = static_cast<prim::DBDot*>(item);
-          static_cast<prim::DBLayer*>(this)->getLattice()->setOccupied(dbdot->latticeCoord(), dbdot);
-          prim::LatticeCoord lc = dbdot->latticeCoord();
-          prim::Emitter::instance()->sig_moveDBToLatticeCoord(dbdot, lc.n, lc.m, lc.l);
-        }
-      }
-      new_items.clear();
-    } else if (rs->name() == "electrode") {
-      rs->readNext();
-      addItem(new prim::Electrode(rs, scene, layer_id));
-    } else {
+    if (!loadItem(rs, scene)) {
       qDebug() << QObject::tr("Layer load item: invalid element encountered on line %1 - %2").arg(rs->lineNumber()).arg(rs->name().toString());
       rs->skipCurrentElement();
     }
@@ -251,3 +236,37 @@ void prim::Layer::loadItems(QXmlStreamReader *rs, QGraphicsScene *scene)
     qCritical() << QObject::tr("XML error: ") << rs->errorString().data();
   }
 }
+
+prim::Item *prim::Layer::loadItem(QXmlStreamReader *rs, QGraphicsScene *scene, int index)
+{
+  prim::Item *item=0;
+  if (rs->name() == "dbdot") {
+    //rs->readNext();
+    prim::DBDot *dbdot = new prim::DBDot(rs, scene, layer_id);
+    addItem(dbdot, index);
+    prim::Emitter::instance()->addItemToScene(dbdot);
+    static_cast<prim::DBLayer*>(this)->getLattice()->setOccupied(dbdot->latticeCoord(), dbdot);
+    prim::LatticeCoord lc = dbdot->latticeCoord();
+    prim::Emitter::instance()->sig_moveDBToLatticeCoord(dbdot, lc.n, lc.m, lc.l);
+    item = dbdot;
+  } else if (rs->name() == "aggregate") {
+    // TODO pass a blank list to Aggregate 
+    QList<prim::Item*> new_items;
+    item = new prim::Aggregate(rs, scene, new_items, layer_id);
+    addItem(item, index);
+    for (prim::Item *new_item : new_items) {
+      if (new_item->item_type == prim::Item::DBDot) {
+        prim::DBDot *dbdot = static_cast<prim::DBDot*>(new_item);
+        static_cast<prim::DBLayer*>(this)->getLattice()->setOccupied(dbdot->latticeCoord(), dbdot);
+        prim::LatticeCoord lc = dbdot->latticeCoord();
+        prim::Emitter::instance()->sig_moveDBToLatticeCoord(dbdot, lc.n, lc.m, lc.l);
+      }
+    }
+    new_items.clear();
+  } else if (rs->name() == "electrode") {
+    rs->readNext();
+    item = new prim::Electrode(rs, scene, layer_id);
+    addItem(item, index);
+  }
+  return item;
+}
@@ -86,6 +86,11 @@ namespace prim{
     //! do nothing.
     void addItem(prim::Item *item, int index=-1);
 
+    //! append new Items to the end of the layer in bulk. Unlike addItem, no
+    //! check is performed for Items that are already in the layer, the caller
+    //! is responsible for only supplying new Items.
+    void addItems(const QList<prim::Item*> &new_items);
+
     //! attempt to remove the given Item from the layer. Returns true if the Item
     //! is found and removed, false otherwise.
     bool removeItem(prim::Item *item);
@@ -130,6 +135,9 @@ namespace prim{
     //! get index of an item with the item's pointer
     int getItemIndex(prim::Item *item) {return items.indexOf(item);}
 
+    //! get the number of items in the Layer
+    int itemCount() const {return items.size();}
+
     //! get the Layer's items, needs to be a copy rather than a reference for Layer removal
     QStack<prim::Item*> &getItems() {return items;}
 
@@ -139,6 +147,11 @@ namespace prim{
     virtual void saveItems(QXmlStreamWriter *, gui::DesignInclusionArea) const;
     virtual void loadItems(QXmlStreamReader *, QGraphicsScene *);
 
+    //! load a single item from the start element that the stream is positioned
+    //! at and insert it at the given index (-1 to append). Returns the new item
+    //! or 0 if the element is not a recognized item.
+    prim::Item *loadItem(QXmlStreamReader *, QGraphicsScene *, int index=-1);
+
   signals:
 
     void sig_visibilityChanged(bool visible);
@@ -90,6 +90,7 @@ SimVisualizer::SimVisualizer(DesignPanel *design_pan, QWidget *parent)
   {
     comp::JobStep *js = sim_job->getJobStep(job_step_ind);
     charge_config_set_visualizer->clearVisualizer();
+    js->ensureLocalFile(js->problemPath());
     emit sig_loadProblemFile(js->problemPath());
     charge_config_set_visualizer->setLattice(design_pan->getLattice(false));
     ECS *charge_config_set = static_cast<ECS*>(
@@ -145,6 +146,7 @@ SimVisualizer::SimVisualizer(DesignPanel *design_pan, QWidget *parent)
   auto setPotentialLandscapeJobStep = [this](const int &job_step_ind)
   {
     comp::JobStep *js = sim_job->getJobStep(job_step_ind);
+    js->ensureLocalFile(js->problemPath());
     emit sig_loadProblemFile(js->problemPath());
     PL *pot_landscape = static_cast<PL*>(
         js->jobResults().value(comp::JobResult::PotentialLandscapeResult));
@@ -200,6 +202,9 @@ void SimVisualizer::showJob(comp::SimJob *job)
 
   sim_job = job;
   qDebug() << tr("Showing job %1").arg(job->name());
+
+  // results are read when a step is selected and must stay loaded while shown
+  comp::ResultMemoryBudget::instance()->setPinnedSteps(job->jobSteps());
   setEnabled(true);
 
   // tell application to show virualization side dock and load Result layers
@@ -263,6 +268,7 @@ void SimVisualizer::clearJob()
   pot_landscape_visualizer->clearVisualizer();
 
   sim_job = nullptr;
+  comp::ResultMemoryBudget::instance()->setPinnedSteps(QList<comp::JobStep*>());
 
   // disable user interaction to the entire plugin
   setEnabled(false);
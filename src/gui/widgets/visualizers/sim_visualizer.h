@@ -37,6 +37,9 @@ namespace gui{
     //! Clear the job result from this and children visualizers.
     void clearJob();
 
+    //! Return the job whose results are shown, a null pointer if none.
+    comp::SimJob *shownJob() const {return sim_job;}
+
     //! Take actions after design panel reset
     void designPanelResetActions();
 
@@ -11,9 +11,11 @@
 #include <QCommandLineParser>
 #include <QMainWindow>
 #include <QResource>
+#include <QTimer>
 #include <QDebug>
 
 #include "gui/application.h"
+#include "gui/widgets/components/profiler.h"
 #include "settings/settings.h"
 
 #include <cstdlib>
@@ -85,8 +87,18 @@ int main(int argc, char **argv){
   parser.addHelpOption();
   parser.addVersionOption();
   parser.addPositionalArgument("file", "Design file to open (normally *.sqd).");
+  QCommandLineOption profile_option("profile-startup",
+      "Record startup timings and write them to <trace> in the Chrome trace "
+      "format once startup, including plugin discovery and loading <file>, "
+      "has finished.", "trace");
+  parser.addOption(profile_option);
 
   parser.process(app);
+  const QString trace_path = parser.value(profile_option);
+  if (!trace_path.isEmpty()) {
+    comp::Profiler::setEnabled(true);
+    comp::Profiler::setThreadName("GUI");
+  }
   const QStringList args = parser.positionalArguments();
   QString f_path;
   if (!args.isEmpty()) {
@@ -94,8 +106,29 @@ int main(int argc, char **argv){
     qDebug() << QObject::tr("CML file path: %1").arg(f_path);
   }
 
+  // the startup span ends once the main window reports that plugins, the
+  // Python path and the command line file are ready, or on quitting before
+  // that. The report is written then and recording stops so that the spans
+  // of later interaction, e.g. of every painted frame, don't pile up.
+  comp::ProfileScope *startup_scope = new comp::ProfileScope("main::startup");
+  auto finishStartup = [&startup_scope, trace_path]()
+  {
+    if (startup_scope == nullptr)
+      return;
+    delete startup_scope;
+    startup_scope = nullptr;
+    if (!trace_path.isEmpty()) {
+      comp::Profiler::writeChromeTrace(trace_path);
+      comp::Profiler::setEnabled(false);
+    }
+  };
+
   // pre-launch setup
-  settings::AppSettings *app_settings = settings::AppSettings::instance();
+  settings::AppSettings *app_settings;
+  {
+    SQ_PROFILE_SCOPE("main::loadSettings");
+    app_settings = settings::AppSettings::instance();
+  }
   if(app_settings->get<bool>("view/hidpi_support"))
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 
@@ -110,6 +143,11 @@ int main(int argc, char **argv){
   // main window
   gui::ApplicationGUI w(f_path);
   w.show();
+  if (w.startupFinished())
+    finishStartup();
+  else
+    QObject::connect(&w, &gui::ApplicationGUI::sig_startupFinished, finishStartup);
+  QObject::connect(&app, &QCoreApplication::aboutToQuit, finishStartup);
 
   // execute
   return app.exec();
@@ -116,6 +116,7 @@ QSettings *settings::AppSettings::m_defs()
 
   // python path related
   S->setValue("user_python_path", QString(""));   // user's own python path setting
+  S->setValue("cached_python_path", QString("")); // last working path found in the search paths
   // linux/bsd python search paths
   S->setValue("python_search_linux", QStringList({
     "python3",
@@ -141,6 +142,20 @@ QSettings *settings::AppSettings::m_defs()
   }));
   S->setValue("plugs/preset_root_path", QString("<CONFIG>/plugins/"));
   S->setValue("plugs/runtime_tmp_root_path", QString("<SYSTMP>/plugins/"));
+  S->setValue("plugs/cpu_affinity", QString()); // e.g. 0-3,6, empty for all CPUs
+  S->setValue("plugs/nice", 0);
+  S->setValue("plugs/memory_limit_mb", 0);      // 0 for no limit
+  S->setValue("plugs/timeout_s", 0);            // 0 for no limit
+  S->setValue("plugs/result_cache", true);      // reuse results of identical problems by default
+  S->setValue("plugs/use_workers", true);       // use persistent workers of plugins supporting them
+  S->setValue("plugs/max_workers_per_engine", 2);
+  S->setValue("plugs/worker_idle_timeout_s", 300);
+  S->setValue("plugs/result_memory_budget_mb", 1024); // 0 for no limit
+  S->setValue("plugs/export_compression", QString("Better")); // Store, Faster or Better
+  S->setValue("plugs/export_include_filters", QString());     // space-separated wildcards, empty for all files
+  S->setValue("plugs/export_exclude_filters", QString());     // space-separated wildcards
+  S->setValue("plugs/job_catalog_path", QString("<CONFIG>/job_catalog.jsonl"));
+  S->setValue("plugs/runtime_tmp_quota_mb", 0);  // 0 for no limit
 
   S->setValue("float_prc", 6);  // float precision specified in QString::setNum; not always obeyed.
   S->setValue("float_fmt", "g");   // float format specified in QString::setNum; not always obeyed.
@@ -148,6 +163,7 @@ QSettings *settings::AppSettings::m_defs()
   S->setValue("save/autosaveroot", QString("<SYSTMP>/autosave/"));
   S->setValue("save/autosavenum", 10);
   S->setValue("save/autosaveinterval", 60); // in seconds
+  S->setValue("save/checkpointrecords", 200); // journal records between checkpoints
 
   return S;
 }
@@ -8,12 +8,13 @@
 CONFIG += qt c++11
 CONFIG += release
 
-QT += core gui widgets svg printsupport uitools charts
+QT += core gui widgets svg printsupport uitools charts concurrent
 
 TEMPLATE = app
 TARGET = siqad
 INCLUDEPATH += .
 INCLUDEPATH += libs/zipper/zipper
+linux: LIBS += -lrt
 LIBS += -L"$$(ZLIB_LIBRARYDIR)" -lzlib -L"$$(ZIPPER_LIB_PATH)" -lZipper
 
 ###########################
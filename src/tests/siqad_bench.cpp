@@ -0,0 +1,461 @@
+// @file:     siqad_bench.cpp
+// @author:   Samuel
+// @created:  2020.06.15
+// @license:  GNU LGPL v3
+//
+// @desc:     Benchmarks of the core data paths. Run with -json <path> to also
+//            write the results as JSON for tracking between releases.
+
+#include <QtTest/QtTest>
+#include <QtCore>
+#include <QApplication>
+
+#include <random>
+
+#include "gui/widgets/primitives/lattice.h"
+#include "gui/widgets/primitives/dbdot.h"
+#include "gui/widgets/components/design_model.h"
+#include "gui/widgets/components/job_results/electron_config_set.h"
+#include "gui/widgets/components/job_results/potential_landscape.h"
+
+namespace {
+  const QString lattice_path = ":/lattices/si_100_2x1.xml";
+
+  // lattice coordinate of the i-th DB when filling a square block of dimers
+  prim::LatticeCoord blockCoord(int i, int side)
+  {
+    return prim::LatticeCoord((i/2) % side, (i/2) / side, i % 2);
+  }
+
+  int blockSide(int db_count)
+  {
+    return qCeil(qSqrt(db_count / 2.));
+  }
+}
+
+class SiQADBench: public QObject
+{
+  Q_OBJECT
+
+public:
+
+  //! Write the recorded results as JSON to the given path.
+  bool writeJson(const QString &path) const
+  {
+    QJsonObject report{
+      {"siqad_version", APP_VERSION},
+      {"qt_version", qVersion()},
+      {"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+      {"results", results}};
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+      qWarning() << "Unable to write benchmark results to" << path;
+      return false;
+    }
+    file.write(QJsonDocument(report).toJson());
+    return true;
+  }
+
+private:
+
+  // mark the timed region of a benchmark iteration for the JSON report, the
+  // QtTest result itself comes from QBENCHMARK
+  void startIteration() {iter_timer.start();}
+  void endIteration() {total_ns += iter_timer.nsecsElapsed(); iterations++;}
+
+  //! Return a design with the given number of DBs in a dense block.
+  comp::DesignModel makeDesign(int db_count) const
+  {
+    comp::DesignModel model;
+    model.setLattice(lat_def);
+    comp::DesignModel::LayerRecord lat_layer, db_layer;
+    lat_layer.name = lat_layer.type = "Lattice";
+    db_layer.name = "Surface";
+    db_layer.type = "DB";
+    db_layer.active = true;
+    model.addLayer(lat_layer);
+    int lay = model.addLayer(db_layer);
+    model.reserveDBs(db_count);
+    int side = blockSide(db_count);
+    QRgb color = QColor("#ffc8c8c8").rgba();
+    for (int i=0; i<db_count; i++) {
+      prim::LatticeCoord lc = blockCoord(i, side);
+      model.addDB(lc.n, lc.m, lc.l, lay, color);
+    }
+    return model;
+  }
+
+  //! Return an elec_dist element with the given number of charge configs.
+  static QByteArray makeChargeConfigXml(int db_count, int config_count)
+  {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> charge(0, 2);
+    std::uniform_real_distribution<float> energy(-1, 1);
+    const char charge_chars[] = {'-', '0', '+'};
+    QByteArray xml;
+    QXmlStreamWriter ws(&xml);
+    ws.writeStartElement("elec_dist");
+    for (int i=0; i<config_count; i++) {
+      QString dist;
+      for (int j=0; j<db_count; j++)
+        dist.append(charge_chars[charge(gen)]);
+      ws.writeStartElement("dist");
+      ws.writeAttribute("energy", QString::number(energy(gen)));
+      ws.writeAttribute("count", "1");
+      ws.writeAttribute("physically_valid", QString::number(i % 2));
+      ws.writeAttribute("state_count", "3");
+      ws.writeCharacters(dist);
+      ws.writeEndElement();
+    }
+    ws.writeEndElement();
+    return xml;
+  }
+
+  //! Return a potential_map element for a square grid of the given size.
+  static QByteArray makePotentialMapXml(int grid_size)
+  {
+    QByteArray xml;
+    QXmlStreamWriter ws(&xml);
+    ws.writeStartElement("potential_map");
+    for (int i=0; i<grid_size; i++) {
+      for (int j=0; j<grid_size; j++) {
+        ws.writeStartElement("potential_val");
+        ws.writeAttribute("x", QString::number(i*1e-10));
+        ws.writeAttribute("y", QString::number(j*1e-10));
+        ws.writeAttribute("val", QString::number(qSin(i)*qCos(j)));
+        ws.writeEndElement();
+      }
+    }
+    ws.writeEndElement();
+    return xml;
+  }
+
+  // add data rows for the design sizes
+  static void addDesignSizeRows()
+  {
+    QTest::addColumn<int>("db_count");
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+  }
+
+// functions in these slots are automatically called
+private slots:
+
+  void initTestCase()
+  {
+    prim::Item::init();
+    QVERIFY(tmp_dir.isValid());
+
+    comp::DesignModel lat_model;
+    QVERIFY(lat_model.loadLatticeFromFile(lattice_path));
+    lat_def = lat_model.lattice();
+
+    QFile lat_file(lattice_path);
+    QVERIFY(lat_file.open(QFile::ReadOnly | QFile::Text));
+    QXmlStreamReader rs(&lat_file);
+    rs.readNextStartElement();
+    lattice = new prim::Lattice(&rs, 0);
+  }
+
+  void cleanupTestCase()
+  {
+    delete lattice;
+  }
+
+  void init()
+  {
+    total_ns = 0;
+    iterations = 0;
+  }
+
+  void cleanup()
+  {
+    if (iterations == 0)
+      return;
+    results.append(QJsonObject{
+        {"name", QTest::currentTestFunction()},
+        {"tag", QTest::currentDataTag()},
+        {"iterations", iterations},
+        {"ns_per_iteration", double(total_ns) / iterations}});
+  }
+
+
+  // LATTICE
+
+  void latticeNearestSite()
+  {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<qreal> coord(-1e5, 1e5);
+    QVector<QPointF> points;
+    for (int i=0; i<10000; i++)
+      points.append(QPointF(coord(gen), coord(gen)));
+
+    QBENCHMARK {
+      startIteration();
+      for (const QPointF &pt : points)
+        lattice->nearestSite(pt, true);
+      endIteration();
+    }
+  }
+
+  void latticeEnclosedSites_data()
+  {
+    QTest::addColumn<qreal>("width_nm");
+    QTest::newRow("10nm") << 10.;
+    QTest::newRow("100nm") << 100.;
+    QTest::newRow("500nm") << 500.;
+  }
+
+  void latticeEnclosedSites()
+  {
+    QFETCH(qreal, width_nm);
+    qreal width = width_nm * prim::Item::scale_factor_nm;
+    QRectF rect(-width/2, -width/2, width, width);
+
+    QBENCHMARK {
+      startIteration();
+      QList<prim::LatticeCoord> sites = lattice->enclosedSites(rect);
+      endIteration();
+      QVERIFY(!sites.isEmpty());
+    }
+  }
+
+
+  // LAYER
+
+  void layerAddItem_data()
+  {
+    QTest::addColumn<int>("db_count");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+  }
+
+  void layerAddItem()
+  {
+    QFETCH(int, db_count);
+    QList<prim::Item*> dbs;
+    int side = blockSide(db_count);
+    for (int i=0; i<db_count; i++)
+      dbs.append(new prim::DBDot(blockCoord(i, side), 1, true));
+
+    QBENCHMARK {
+      prim::Layer layer("Surface", prim::Layer::DB, prim::Layer::Design);
+      startIteration();
+      for (prim::Item *db : dbs)
+        layer.addItem(db);
+      endIteration();
+      layer.getItems().clear();   // the items are reused
+    }
+    qDeleteAll(dbs);
+  }
+
+  void layerAddItems_data() {addDesignSizeRows();}
+
+  void layerAddItems()
+  {
+    QFETCH(int, db_count);
+    QList<prim::Item*> dbs;
+    int side = blockSide(db_count);
+    for (int i=0; i<db_count; i++)
+      dbs.append(new prim::DBDot(blockCoord(i, side), 1, true));
+
+    QBENCHMARK {
+      prim::Layer layer("Surface", prim::Layer::DB, prim::Layer::Design);
+      startIteration();
+      layer.addItems(dbs);
+      endIteration();
+      layer.getItems().clear();   // the items are reused
+    }
+    qDeleteAll(dbs);
+  }
+
+  void layerRemoveItem_data() {addDesignSizeRows();}
+
+  void layerRemoveItem()
+  {
+    QFETCH(int, db_count);
+    prim::Layer layer("Surface", prim::Layer::DB, prim::Layer::Design);
+    QList<prim::Item*> dbs;
+    int side = blockSide(db_count);
+    for (int i=0; i<db_count; i++)
+      dbs.append(new prim::DBDot(blockCoord(i, side), 1, true));
+    layer.addItems(dbs);
+
+    // remove 1000 items spread evenly across the layer
+    QList<prim::Item*> to_remove;
+    for (int i=0; i<1000; i++)
+      to_remove.append(dbs.at(i * (db_count / 1000)));
+
+    QBENCHMARK_ONCE {
+      startIteration();
+      for (prim::Item *db : to_remove)
+        layer.removeItem(db);
+      endIteration();
+    }
+    QCOMPARE(layer.getItems().size(), db_count - 1000);
+    qDeleteAll(to_remove);
+  }
+
+
+  // DESIGN FILES
+
+  void sqdSave_data()
+  {
+    QTest::addColumn<int>("db_count");
+    QTest::addColumn<bool>("binary");
+    for (int db_count : {10000, 100000, 1000000}) {
+      QString size = db_count >= 1000000 ? QString("%1M").arg(db_count/1000000)
+                                         : QString("%1k").arg(db_count/1000);
+      QTest::newRow(qPrintable(size + " sqd")) << db_count << false;
+      QTest::newRow(qPrintable(size + " sqdb")) << db_count << true;
+    }
+  }
+
+  void sqdSave()
+  {
+    QFETCH(int, db_count);
+    QFETCH(bool, binary);
+    comp::DesignModel model = makeDesign(db_count);
+    QString path = tmp_dir.filePath(binary ? "save.sqdb" : "save.sqd");
+
+    QBENCHMARK {
+      startIteration();
+      bool success = binary ? model.saveToBinaryFile(path) : model.saveToFile(path);
+      endIteration();
+      QVERIFY(success);
+    }
+  }
+
+  void sqdLoad_data() {sqdSave_data();}
+
+  void sqdLoad()
+  {
+    QFETCH(int, db_count);
+    QFETCH(bool, binary);
+    QString path = tmp_dir.filePath(binary ? "load.sqdb" : "load.sqd");
+    {
+      comp::DesignModel model = makeDesign(db_count);
+      QVERIFY(binary ? model.saveToBinaryFile(path) : model.saveToFile(path));
+    }
+
+    QBENCHMARK {
+      comp::DesignModel model;
+      model.setFallbackLatticePath(lattice_path);
+      startIteration();
+      bool success = binary ? model.loadFromBinaryFile(path) : model.loadFromFile(path);
+      endIteration();
+      QVERIFY(success);
+      QCOMPARE(model.dbCount(), db_count);
+    }
+  }
+
+
+  // JOB RESULTS
+
+  void chargeConfigSetParse_data()
+  {
+    QTest::addColumn<int>("db_count");
+    QTest::addColumn<int>("config_count");
+    QTest::newRow("20 DBs x 10k") << 20 << 10000;
+    QTest::newRow("20 DBs x 100k") << 20 << 100000;
+    QTest::newRow("200 DBs x 10k") << 200 << 10000;
+  }
+
+  void chargeConfigSetParse()
+  {
+    QFETCH(int, db_count);
+    QFETCH(int, config_count);
+    QByteArray xml = makeChargeConfigXml(db_count, config_count);
+
+    QBENCHMARK {
+      QXmlStreamReader rs(xml);
+      rs.readNextStartElement();
+      startIteration();
+      comp::ChargeConfigSet config_set(&rs);
+      endIteration();
+      QCOMPARE(config_set.totalConfigCount(), config_count);
+    }
+  }
+
+  void chargeConfigSetFilter_data() {chargeConfigSetParse_data();}
+
+  void chargeConfigSetFilter()
+  {
+    QFETCH(int, db_count);
+    QFETCH(int, config_count);
+    QByteArray xml = makeChargeConfigXml(db_count, config_count);
+    QXmlStreamReader rs(xml);
+    rs.readNextStartElement();
+    comp::ChargeConfigSet config_set(&rs);
+    int net_charge = config_set.mostPopularNetCharge();
+
+    QBENCHMARK {
+      startIteration();
+      QList<comp::ChargeConfigSet::ChargeConfig> valid = config_set.chargeConfigs(true);
+      QList<comp::ChargeConfigSet::ChargeConfig> net = config_set.chargeConfigs(true, false, net_charge);
+      int lowest = comp::ChargeConfigSet::lowestPhysicallyValidInd(valid);
+      endIteration();
+      QVERIFY(!valid.isEmpty() && !net.isEmpty() && lowest >= 0);
+    }
+  }
+
+  void potentialLandscapeParse_data()
+  {
+    QTest::addColumn<int>("grid_size");
+    QTest::newRow("100x100") << 100;
+    QTest::newRow("500x500") << 500;
+    QTest::newRow("1000x1000") << 1000;
+  }
+
+  void potentialLandscapeParse()
+  {
+    QFETCH(int, grid_size);
+    QByteArray xml = makePotentialMapXml(grid_size);
+
+    QBENCHMARK {
+      QXmlStreamReader rs(xml);
+      rs.readNextStartElement();
+      startIteration();
+      comp::PotentialLandscape landscape(&rs, tmp_dir.path());
+      endIteration();
+      QCOMPARE(landscape.potentials().size(), grid_size*grid_size);
+    }
+  }
+
+private:
+
+  QTemporaryDir tmp_dir;
+  comp::DesignModel::LatticeDef lat_def;
+  prim::Lattice *lattice=nullptr;
+
+  QElapsedTimer iter_timer;
+  qint64 total_ns=0;
+  qint64 iterations=0;
+  QJsonArray results;
+};
+
+int main(int argc, char **argv)
+{
+  QApplication app(argc, argv);
+  app.setApplicationName(APPLICATION_NAME);
+  app.setApplicationVersion(APP_VERSION);
+
+  // take the JSON output path out of the arguments before QtTest sees them
+  QStringList args = app.arguments();
+  QString json_path;
+  int json_ind = args.indexOf("-json");
+  if (json_ind >= 0 && json_ind + 1 < args.size()) {
+    json_path = args.at(json_ind + 1);
+    args.erase(args.begin() + json_ind, args.begin() + json_ind + 2);
+  }
+
+  SiQADBench bench;
+  int ret = QTest::qExec(&bench, args);
+  if (!json_path.isEmpty() && !bench.writeJson(json_path))
+    ret = 1;
+  return ret;
+}
+
+#include "siqad_bench.moc"  // generated at compile time
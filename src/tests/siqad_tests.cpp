@@ -2,13 +2,343 @@
 
 #include "gui/widgets/managers/layer_manager.h"
 #include "gui/widgets/primitives/lattice.h"
+#include "gui/widgets/components/design_model.h"
+#include "gui/widgets/components/job_archive.h"
+#include "gui/widgets/components/job_catalog.h"
+#include "gui/widgets/components/result_cache.h"
+
+namespace {
+  const QString lattice_path = ":/lattices/si_100_2x1.xml";
+}
 
 class SiQADTests: public QObject
 {
   Q_OBJECT
 
+private:
+
+  //! Return a design with DBs in and out of an aggregate, an electrode and an
+  //! item only kept as XML. If with_overlay is set, an overlay layer is placed
+  //! between the DB and electrode layers.
+  comp::DesignModel makeDesign(bool with_overlay) const
+  {
+    comp::DesignModel model;
+    model.setLattice(lat_def);
+    auto addLayer = [&model](const QString &name, const QString &type,
+                             const QString &role)
+    {
+      comp::DesignModel::LayerRecord layer;
+      layer.name = name;
+      layer.type = type;
+      layer.role = role;
+      layer.layer_id = model.layers().size();
+      return model.addLayer(layer);
+    };
+    addLayer("Lattice", "Lattice", "Design");
+    int db_lay = addLayer("Surface", "DB", "Design");
+    int overlay_lay = with_overlay ? addLayer("Screenshot Overlay", "Misc", "Overlay") : -1;
+    int elec_lay = addLayer("Metal", "Electrode", "Design");
+    int misc_lay = addLayer("AFM", "Misc", "Design");
+
+    QRgb color = QColor("#ffc8c8c8").rgba();
+    model.addDB(0, 0, 0, db_lay, color);
+    int agg = model.addAggregate(db_lay);
+    model.addDB(2, 1, 0, db_lay, color, agg);
+    model.addDB(2, 1, 1, db_lay, 0, agg);
+    model.addDB(-3, 4, 1, db_lay, 0);
+
+    comp::DesignModel::ElectrodeRecord elec;
+    elec.layer = elec_lay;
+    elec.rect = QRectF(-20, 10, 40.5, 12);
+    elec.angle = 30;
+    elec.color = 0;
+    elec.properties.append(qMakePair(QString("potential"), QString("0.5")));
+    elec.properties.append(qMakePair(QString("phase"), QString("0")));
+    model.addElectrode(elec);
+
+    model.addXmlItem(misc_lay, afmAreaXml(misc_lay));
+    if (overlay_lay != -1)
+      model.addXmlItem(overlay_lay, afmAreaXml(overlay_lay));
+    return model;
+  }
+
+  //! Return the XML of an AFM area on the given layer.
+  static QByteArray afmAreaXml(int layer_id)
+  {
+    QByteArray xml;
+    QXmlStreamWriter ws(&xml);
+    ws.writeStartElement("afmarea");
+    ws.writeTextElement("layer_id", QString::number(layer_id));
+    ws.writeEmptyElement("dimensions");
+    ws.writeAttribute("x1", "0");
+    ws.writeAttribute("y1", "0");
+    ws.writeAttribute("x2", "10");
+    ws.writeAttribute("y2", "20");
+    ws.writeTextElement("z_speed", "1");
+    ws.writeEndElement();
+    return xml;
+  }
+
+  //! Compare the contents of the models including the order of top level
+  //! items.
+  static void compareModels(const comp::DesignModel &actual,
+                            const comp::DesignModel &expected)
+  {
+    QCOMPARE(actual.lattice().name, expected.lattice().name);
+    QCOMPARE(actual.lattice().a[0], expected.lattice().a[0]);
+    QCOMPARE(actual.lattice().a[1], expected.lattice().a[1]);
+    QCOMPARE(actual.lattice().b, expected.lattice().b);
+
+    QCOMPARE(actual.layers().size(), expected.layers().size());
+    for (int i=0; i<expected.layers().size(); i++) {
+      const comp::DesignModel::LayerRecord &a = actual.layers().at(i);
+      const comp::DesignModel::LayerRecord &e = expected.layers().at(i);
+      QCOMPARE(a.name, e.name);
+      QCOMPARE(a.type, e.type);
+      QCOMPARE(a.role, e.role);
+      QCOMPARE(a.zoffset, e.zoffset);
+      QCOMPARE(a.zheight, e.zheight);
+      QCOMPARE(a.visible, e.visible);
+      QCOMPARE(a.active, e.active);
+      QCOMPARE(a.layer_id, e.layer_id);
+    }
+
+    QCOMPARE(actual.dbs().size(), expected.dbs().size());
+    for (int i=0; i<expected.dbs().size(); i++) {
+      const comp::DesignModel::DBRecord &a = actual.dbs().at(i);
+      const comp::DesignModel::DBRecord &e = expected.dbs().at(i);
+      QCOMPARE(a.n, e.n);
+      QCOMPARE(a.m, e.m);
+      QCOMPARE(a.l, e.l);
+      QCOMPARE(a.layer, e.layer);
+      QCOMPARE(a.aggregate, e.aggregate);
+      QCOMPARE(a.color, e.color);
+    }
+
+    QCOMPARE(actual.aggregates().size(), expected.aggregates().size());
+    for (int i=0; i<expected.aggregates().size(); i++) {
+      QCOMPARE(actual.aggregates().at(i).layer, expected.aggregates().at(i).layer);
+      QCOMPARE(actual.aggregates().at(i).parent, expected.aggregates().at(i).parent);
+    }
+
+    QCOMPARE(actual.electrodes().size(), expected.electrodes().size());
+    for (int i=0; i<expected.electrodes().size(); i++) {
+      const comp::DesignModel::ElectrodeRecord &a = actual.electrodes().at(i);
+      const comp::DesignModel::ElectrodeRecord &e = expected.electrodes().at(i);
+      QCOMPARE(a.layer, e.layer);
+      QCOMPARE(a.rect, e.rect);
+      QCOMPARE(a.angle, e.angle);
+      QCOMPARE(a.color, e.color);
+      QVERIFY(a.properties == e.properties);
+    }
+
+    QCOMPARE(actual.xmlItems().size(), expected.xmlItems().size());
+    for (int i=0; i<expected.xmlItems().size(); i++) {
+      QCOMPARE(actual.xmlItems().at(i).layer, expected.xmlItems().at(i).layer);
+      QCOMPARE(actual.xmlItems().at(i).xml, expected.xmlItems().at(i).xml);
+    }
+    QCOMPARE(actual.topLevelItems().size(), expected.topLevelItems().size());
+    for (int i=0; i<expected.topLevelItems().size(); i++) {
+      QCOMPARE(actual.topLevelItems().at(i).kind, expected.topLevelItems().at(i).kind);
+      QCOMPARE(actual.topLevelItems().at(i).index, expected.topLevelItems().at(i).index);
+    }
+  }
+
 // functions in these slots are automatically called
 private slots:
+
+  void initTestCase()
+  {
+    QVERIFY(tmp_dir.isValid());
+    comp::DesignModel lat_model;
+    QVERIFY(lat_model.loadLatticeFromFile(lattice_path));
+    lat_def = lat_model.lattice();
+  }
+
+  void designRoundTrip_data()
+  {
+    QTest::addColumn<bool>("binary");
+    QTest::newRow("sqd") << false;
+    QTest::newRow("sqdb") << true;
+  }
+
+  // .sqd -> DesignModel -> .sqd or .sqdb -> DesignModel keeps the design
+  void designRoundTrip()
+  {
+    QFETCH(bool, binary);
+    comp::DesignModel design = makeDesign(false);
+    QString design_path = tmp_dir.filePath("design.sqd");
+    QVERIFY(design.saveToFile(design_path));
+
+    comp::DesignModel model;
+    QVERIFY(model.loadFromFile(design_path));
+    QCOMPARE(model.filePurpose(), QString("save"));
+    compareModels(model, design);
+
+    QString path = tmp_dir.filePath(binary ? "round_trip.sqdb" : "round_trip.sqd");
+    QVERIFY(binary ? model.saveToBinaryFile(path) : model.saveToFile(path));
+    comp::DesignModel reloaded;
+    QVERIFY(binary ? reloaded.loadFromBinaryFile(path) : reloaded.loadFromFile(path));
+    compareModels(reloaded, design);
+  }
+
+  // overlay layers are left out of simulation problems, the layer_id of each
+  // item must still refer to its layer in the written layer list
+  void simProblemLayerIDs()
+  {
+    comp::DesignModel design = makeDesign(true);
+    QString design_path = tmp_dir.filePath("overlay.sqd");
+    QVERIFY(design.saveToFile(design_path));
+
+    comp::DesignModel model;
+    QVERIFY(model.loadFromFile(design_path));
+    QCOMPARE(model.layers().size(), design.layers().size() - 1);
+
+    QString problem_path = tmp_dir.filePath("problem.xml");
+    QList<QPair<QString,QString>> sim_params{qMakePair(QString("num_instances"), QString("1"))};
+    QVERIFY(model.writeSimProblem(problem_path, sim_params));
+
+    QFile file(problem_path);
+    QVERIFY(file.open(QFile::ReadOnly | QFile::Text));
+    QXmlStreamReader rs(&file);
+    QStringList layer_types;
+    int layer = -1;
+    int item_count = 0;
+    while (!rs.atEnd()) {
+      rs.readNext();
+      if (!rs.isStartElement())
+        continue;
+      if (rs.name() == "layer_prop") {
+        while (rs.readNextStartElement()) {
+          if (rs.name() == "type")
+            layer_types.append(rs.readElementText());
+          else
+            rs.skipCurrentElement();
+        }
+      } else if (rs.name() == "layer") {
+        layer++;
+        QVERIFY(layer < layer_types.size());
+        QCOMPARE(rs.attributes().value("type").toString(), layer_types.at(layer));
+      } else if (rs.name() == "layer_id") {
+        QCOMPARE(rs.readElementText().toInt(), layer);
+        item_count++;
+      }
+    }
+    QVERIFY(!rs.hasError());
+    QCOMPARE(layer, layer_types.size() - 1);
+    QCOMPARE(item_count, model.dbCount() + model.electrodes().size()
+        + model.xmlItems().size());
+  }
+
+  void isSafeEntryName_data()
+  {
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<bool>("safe");
+    QTest::newRow("relative") << "job/step_0/result.xml" << true;
+    QTest::newRow("parent") << "../x" << false;
+    QTest::newRow("inner parent") << "job/../x" << false;
+    QTest::newRow("absolute") << "/abs" << false;
+    QTest::newRow("current") << "a/./b" << false;
+    QTest::newRow("drive") << "C:x" << false;
+    QTest::newRow("backslash") << "a\\b" << false;
+    QTest::newRow("backslash parent") << "..\\x" << false;
+    QTest::newRow("empty") << "" << false;
+  }
+
+  // archive entries must not be extracted to outside of the extraction root
+  void isSafeEntryName()
+  {
+    QFETCH(QString, name);
+    QFETCH(bool, safe);
+    QCOMPARE(comp::JobArchive::isSafeEntryName(name), safe);
+  }
+
+  // the last record of a job directory wins, removal records drop the job and
+  // a line cut short by a crash is skipped, compaction keeps the current state
+  void jobCatalogReplay()
+  {
+    QString catalog_path = tmp_dir.filePath("job_catalog.jsonl");
+    QString dir_a = tmp_dir.filePath("job_a");
+    QString dir_b = tmp_dir.filePath("job_b");
+    QString dir_c = tmp_dir.filePath("job_c");
+    auto recordLine = [](const QString &dir_path, const QString &name)
+    {
+      QJsonObject obj;
+      obj["job_dir"] = dir_path;
+      obj["name"] = name;
+      obj["state"] = "Finished";
+      return QJsonDocument(obj).toJson(QJsonDocument::Compact) + "\n";
+    };
+
+    QFile file(catalog_path);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text));
+    // enough superseded records for the next write to compact the catalog
+    for (int i=0; i<=100; i++)
+      file.write(recordLine(dir_a, QString("a%1").arg(i)));
+    file.write(recordLine(dir_b, "b"));
+    QJsonObject removal;
+    removal["job_dir"] = dir_b;
+    removal["removed"] = true;
+    file.write(QJsonDocument(removal).toJson(QJsonDocument::Compact) + "\n");
+    file.write(recordLine(dir_c, "c"));
+    file.write(recordLine(tmp_dir.filePath("job_d"), "d").left(20));
+    file.close();
+
+    comp::JobCatalog catalog(catalog_path);
+    QCOMPARE(catalog.jobs().size(), 2);
+    QCOMPARE(catalog.job(dir_a).name, QString("a100"));
+    QCOMPARE(catalog.job(dir_c).name, QString("c"));
+    QVERIFY(catalog.job(dir_b).job_dir_path.isEmpty());
+
+    catalog.forget(dir_c);
+    QVERIFY(file.open(QFile::ReadOnly | QFile::Text));
+    QList<QByteArray> lines = file.readAll().trimmed().split('\n');
+    file.close();
+    QCOMPARE(lines.size(), 1);
+
+    comp::JobCatalog compacted(catalog_path);
+    QCOMPARE(compacted.jobs().size(), 1);
+    QCOMPARE(compacted.job(dir_a).name, QString("a100"));
+    QVERIFY(compacted.job(dir_c).job_dir_path.isEmpty());
+  }
+
+  // the order of DBs within a layer doesn't change the problem hash, the DBs
+  // themselves and the simulation parameters do
+  void problemHashCanonical()
+  {
+    auto problemHash = [this](const QList<QPoint> &db_cells, const QString &mu)
+    {
+      comp::DesignModel model;
+      model.setLattice(lat_def);
+      comp::DesignModel::LayerRecord layer;
+      layer.name = "Lattice";
+      layer.type = "Lattice";
+      layer.role = "Design";
+      layer.layer_id = 0;
+      model.addLayer(layer);
+      layer.name = "Surface";
+      layer.type = "DB";
+      layer.layer_id = 1;
+      int db_lay = model.addLayer(layer);
+      for (const QPoint &cell : db_cells)
+        model.addDB(cell.x(), cell.y(), 0, db_lay, 0);
+
+      QString problem_path = tmp_dir.filePath("hash_problem.xml");
+      QList<QPair<QString,QString>> sim_params{qMakePair(QString("muzm"), mu)};
+      if (!model.writeSimProblem(problem_path, sim_params))
+        return QString();
+      return comp::ResultCache::problemHash(problem_path, "SimAnneal", "0.1",
+          QStringList{"@BINPATH@", "@PROBLEMPATH@", "@RESULTPATH@"});
+    };
+
+    QList<QPoint> db_cells{QPoint(0, 0), QPoint(2, 1), QPoint(-3, 4)};
+    QList<QPoint> reordered{QPoint(-3, 4), QPoint(0, 0), QPoint(2, 1)};
+    QString hash = problemHash(db_cells, "-0.25");
+    QVERIFY(!hash.isEmpty());
+    QCOMPARE(problemHash(reordered, "-0.25"), hash);
+    QVERIFY(problemHash(db_cells, "-0.3") != hash);
+    QVERIFY(problemHash(db_cells.mid(1), "-0.25") != hash);
+  }
   
   // void testLayerManager()
   // {
@@ -50,6 +380,10 @@ private slots:
   //   QCOMPARE(layman->layerCount(), 0);
   // }
 
+private:
+
+  QTemporaryDir tmp_dir;
+  comp::DesignModel::LatticeDef lat_def;
 };
 
 QTEST_MAIN(SiQADTests)
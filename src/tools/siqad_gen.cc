@@ -0,0 +1,322 @@
+// @file:     siqad_gen.cc
+// @author:   Samuel
+// @created:  2020.06.16
+// @license:  GNU LGPL v3
+//
+// @desc:     Procedurally generate SiQAD designs and matching synthetic
+//            simulation results for scale testing and benchmarking.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QtCore>
+
+#include <random>
+
+#include "gui/widgets/primitives/lattice.h"
+#include "gui/widgets/components/design_model.h"
+
+namespace {
+
+  //! Generator parameters.
+  struct GenParams
+  {
+    int db_count;
+    QString pattern;
+    qreal fill;           // fraction of lattice sites occupied (random)
+    int cluster_count;    // number of clusters (clustered)
+    qreal cluster_sigma;  // standard deviation of cluster spread in angstrom
+    int wire_length;      // DBs per wire (wire)
+    int config_count;     // charge configurations in the result
+    int grid_size;        // potential grid points per dimension
+  };
+
+  // key for the set of occupied lattice sites, n and m take 28 bits each and
+  // l the lowest 8 bits, which is unique for any generated design
+  quint64 siteKey(const prim::LatticeCoord &lc)
+  {
+    const quint64 coord_mask = (quint64(1) << 28) - 1;
+    return ((quint64(quint32(lc.n)) & coord_mask) << 36)
+      | ((quint64(quint32(lc.m)) & coord_mask) << 8)
+      | (quint64(quint32(lc.l)) & 0xff);
+  }
+
+  //! Randomly distributed DBs in a square block sized for the given fill.
+  QVector<prim::LatticeCoord> randomPattern(const prim::Lattice &lattice,
+      const GenParams &p, std::mt19937 &gen)
+  {
+    int sites_per_cell = lattice.siteVectors().size();
+    qint64 cells = qCeil(p.db_count / p.fill / sites_per_cell);
+    int side = qMax(1, qCeil(qSqrt(cells)));
+    std::uniform_int_distribution<int> cell(0, side-1);
+    std::uniform_int_distribution<int> site(0, sites_per_cell-1);
+
+    QVector<prim::LatticeCoord> coords;
+    coords.reserve(p.db_count);
+    QSet<quint64> occupied;
+    occupied.reserve(p.db_count);
+    while (coords.size() < p.db_count) {
+      prim::LatticeCoord lc(cell(gen), cell(gen), site(gen));
+      if (!occupied.contains(siteKey(lc))) {
+        occupied.insert(siteKey(lc));
+        coords.append(lc);
+      }
+    }
+    return coords;
+  }
+
+  //! DBs in gaussian clusters around random centers, snapped to the nearest
+  //! lattice site. Gives up once too many samples landed on occupied sites,
+  //! so fewer DBs than requested are returned if the clusters are too dense.
+  QVector<prim::LatticeCoord> clusteredPattern(const prim::Lattice &lattice,
+      const GenParams &p, std::mt19937 &gen)
+  {
+    // spread the cluster centers so that clusters rarely overlap
+    qreal spacing = 6 * p.cluster_sigma;
+    int side = qMax(1, qCeil(qSqrt(p.cluster_count)));
+    std::uniform_real_distribution<qreal> center(0, side * spacing);
+    QVector<QPointF> centers;
+    for (int i=0; i<p.cluster_count; i++)
+      centers.append(QPointF(center(gen), center(gen)));
+
+    std::uniform_int_distribution<int> pick(0, p.cluster_count-1);
+    std::normal_distribution<qreal> spread(0, p.cluster_sigma);
+    QVector<prim::LatticeCoord> coords;
+    coords.reserve(p.db_count);
+    QSet<quint64> occupied;
+    occupied.reserve(p.db_count);
+    qint64 attempts_left = 100LL * p.db_count;
+    while (coords.size() < p.db_count && attempts_left-- > 0) {
+      QPointF pos = centers.at(pick(gen)) + QPointF(spread(gen), spread(gen));
+      prim::LatticeCoord lc = lattice.nearestSite(pos, false);
+      if (!lc.isValid() || occupied.contains(siteKey(lc)))
+        continue;
+      occupied.insert(siteKey(lc));
+      coords.append(lc);
+    }
+    return coords;
+  }
+
+  //! Arrays of binary wires, each a row of DBs along the first lattice vector
+  //! with one empty site between DBs. Wires are tiled in a square grid.
+  QVector<prim::LatticeCoord> wirePattern(const GenParams &p)
+  {
+    int wire_count = qCeil(qreal(p.db_count) / p.wire_length);
+    int wires_per_row = qMax(1, qCeil(qSqrt(wire_count)));
+    QVector<prim::LatticeCoord> coords;
+    coords.reserve(p.db_count);
+    for (int i=0; i<p.db_count; i++) {
+      int wire = i / p.wire_length;
+      int n0 = (wire % wires_per_row) * (2*p.wire_length + 4);
+      int m0 = (wire / wires_per_row) * 3;
+      coords.append(prim::LatticeCoord(n0 + 2*(i % p.wire_length), m0, 0));
+    }
+    return coords;
+  }
+
+  //! Write a simulation result file matching the DB locations, streamed so
+  //! that large fixtures don't have to fit in memory.
+  bool writeResult(const QString &path, const QVector<QPointF> &physlocs,
+      const GenParams &p, std::mt19937 &gen)
+  {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+      qCritical() << QObject::tr("Unable to write result file %1: %2")
+        .arg(path).arg(file.errorString());
+      return false;
+    }
+    QXmlStreamWriter ws(&file);
+    ws.setAutoFormatting(true);
+    ws.writeStartDocument();
+    ws.writeStartElement("sim_out");
+
+    ws.writeStartElement("eng_info");
+    ws.writeTextElement("engine", "siqad_gen");
+    ws.writeTextElement("version", APP_VERSION);
+    ws.writeEndElement();
+    ws.writeEmptyElement("sim_params");
+
+    QRectF bounds;
+    ws.writeStartElement("physloc");
+    for (const QPointF &loc : physlocs) {
+      ws.writeEmptyElement("dbdot");
+      ws.writeAttribute("x", QString::number(loc.x()));
+      ws.writeAttribute("y", QString::number(loc.y()));
+      bounds |= QRectF(loc, QSizeF(1e-3, 1e-3));
+    }
+    ws.writeEndElement();
+
+    if (p.config_count > 0) {
+      const char charge_chars[] = {'-', '0', '+'};
+      std::discrete_distribution<int> charge({4, 5, 1});
+      std::uniform_real_distribution<qreal> energy(-1, 0);
+      std::bernoulli_distribution valid(0.5);
+      QByteArray dist(physlocs.size(), '0');
+      ws.writeStartElement("elec_dist");
+      for (int i=0; i<p.config_count; i++) {
+        for (int j=0; j<dist.size(); j++)
+          dist[j] = charge_chars[charge(gen)];
+        ws.writeStartElement("dist");
+        ws.writeAttribute("energy", QString::number(energy(gen)));
+        ws.writeAttribute("count", "1");
+        ws.writeAttribute("physically_valid", valid(gen) ? "1" : "0");
+        ws.writeAttribute("state_count", "3");
+        ws.writeCharacters(QString::fromLatin1(dist));
+        ws.writeEndElement();
+      }
+      ws.writeEndElement();
+    }
+
+    if (p.grid_size > 0 && !physlocs.isEmpty()) {
+      // potentials are in V on a grid in m covering the design
+      qreal step_x = bounds.width() / qMax(1, p.grid_size-1);
+      qreal step_y = bounds.height() / qMax(1, p.grid_size-1);
+      ws.writeStartElement("potential_map");
+      for (int i=0; i<p.grid_size; i++) {
+        for (int j=0; j<p.grid_size; j++) {
+          qreal x = bounds.left() + i * step_x;
+          qreal y = bounds.top() + j * step_y;
+          ws.writeEmptyElement("potential_val");
+          ws.writeAttribute("x", QString::number(x * 1e-10));
+          ws.writeAttribute("y", QString::number(y * 1e-10));
+          ws.writeAttribute("val", QString::number(0.1 * qSin(x / 50) * qCos(y / 50)));
+        }
+      }
+      ws.writeEndElement();
+    }
+
+    ws.writeEndElement();
+    ws.writeEndDocument();
+    file.close();
+    if (file.error() != QFileDevice::NoError) {
+      qCritical() << QObject::tr("Error when writing result file %1: %2")
+        .arg(path).arg(file.errorString());
+      return false;
+    }
+    return true;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  QCoreApplication app(argc, argv);
+  app.setApplicationName(APPLICATION_NAME);
+  app.setApplicationVersion(APP_VERSION);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Generate synthetic SiQAD designs and "
+      "simulation results for scale testing.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addPositionalArgument("design", "Design file to write, *.sqdb for the binary format.");
+  QCommandLineOption dbs_opt("dbs", "Number of DBs.", "N", "10000");
+  QCommandLineOption pattern_opt("pattern", "DB pattern: random, clustered or wire.",
+      "pattern", "random");
+  QCommandLineOption lattice_opt("lattice", "Lattice file.", "path",
+      ":/lattices/si_100_2x1.xml");
+  QCommandLineOption seed_opt("seed", "Random seed.", "seed", "1");
+  QCommandLineOption fill_opt("fill", "Fraction of lattice sites occupied by "
+      "the random pattern.", "fraction", "0.1");
+  QCommandLineOption clusters_opt("clusters", "Number of clusters, defaults to "
+      "one per 100 DBs.", "K");
+  QCommandLineOption sigma_opt("cluster-sigma", "Cluster spread in angstrom.",
+      "angstrom", "30");
+  QCommandLineOption wire_opt("wire-length", "DBs per wire.", "N", "8");
+  QCommandLineOption result_opt("result", "Also write a matching simulation "
+      "result file.", "path");
+  QCommandLineOption configs_opt("configs", "Charge configurations in the result.",
+      "M", "100");
+  QCommandLineOption grid_opt("potential-grid", "Potential grid points per "
+      "dimension in the result, 0 for none.", "R", "0");
+  parser.addOptions({dbs_opt, pattern_opt, lattice_opt, seed_opt, fill_opt,
+      clusters_opt, sigma_opt, wire_opt, result_opt, configs_opt, grid_opt});
+  parser.process(app);
+
+  if (parser.positionalArguments().size() != 1)
+    parser.showHelp(1);
+  QString design_path = parser.positionalArguments().at(0);
+
+  GenParams p;
+  p.db_count = parser.value(dbs_opt).toInt();
+  p.pattern = parser.value(pattern_opt);
+  p.fill = qBound(1e-6, parser.value(fill_opt).toDouble(), 1.);
+  p.cluster_count = parser.isSet(clusters_opt) ? parser.value(clusters_opt).toInt()
+                                               : p.db_count / 100;
+  p.cluster_count = qMax(1, p.cluster_count);
+  p.cluster_sigma = parser.value(sigma_opt).toDouble();
+  p.wire_length = qMax(1, parser.value(wire_opt).toInt());
+  p.config_count = parser.value(configs_opt).toInt();
+  p.grid_size = parser.value(grid_opt).toInt();
+  std::mt19937 gen(parser.value(seed_opt).toUInt());
+
+  // the lattice provides the coordinate math, the design model the lattice
+  // definition written to file
+  QString lattice_path = parser.value(lattice_opt);
+  comp::DesignModel model;
+  if (!model.loadLatticeFromFile(lattice_path))
+    return 1;
+  QFile lattice_file(lattice_path);
+  if (!lattice_file.open(QFile::ReadOnly | QFile::Text)) {
+    qCritical() << QObject::tr("Cannot open lattice file at path: %1").arg(lattice_path);
+    return 1;
+  }
+  QXmlStreamReader rs(&lattice_file);
+  rs.readNextStartElement();
+  prim::Lattice lattice(&rs, 0);
+
+  QVector<prim::LatticeCoord> coords;
+  if (p.pattern == "random") {
+    coords = randomPattern(lattice, p, gen);
+  } else if (p.pattern == "clustered") {
+    if (p.cluster_sigma <= 0) {
+      qCritical() << QObject::tr("The cluster sigma must be positive.");
+      return 1;
+    }
+    coords = clusteredPattern(lattice, p, gen);
+    if (coords.size() < p.db_count) {
+      qCritical() << QObject::tr("Only %1 of %2 DBs could be placed, increase "
+          "the cluster count or sigma.").arg(coords.size()).arg(p.db_count);
+      return 1;
+    }
+  } else if (p.pattern == "wire") {
+    coords = wirePattern(p);
+  } else {
+    qCritical() << QObject::tr("Unknown pattern %1").arg(p.pattern);
+    return 1;
+  }
+
+  comp::DesignModel::LayerRecord lat_layer, db_layer, metal_layer;
+  lat_layer.name = lat_layer.type = "Lattice";
+  db_layer.name = "Surface";
+  db_layer.type = "DB";
+  db_layer.active = true;
+  metal_layer.name = "Metal";
+  metal_layer.type = "Electrode";
+  metal_layer.zoffset = 1000;
+  metal_layer.zheight = 100;
+  model.addLayer(lat_layer);
+  int lay = model.addLayer(db_layer);
+  model.addLayer(metal_layer);
+
+  QRgb color = QColor("#ffc8c8c8").rgba();
+  QVector<QPointF> physlocs;
+  physlocs.reserve(coords.size());
+  model.reserveDBs(coords.size());
+  for (const prim::LatticeCoord &lc : coords) {
+    model.addDB(lc.n, lc.m, lc.l, lay, color);
+    physlocs.append(lattice.latticeCoord2PhysLoc(lc));
+  }
+
+  bool success = comp::DesignModel::isBinaryPath(design_path)
+      ? model.saveToBinaryFile(design_path) : model.saveToFile(design_path);
+  if (!success)
+    return 1;
+  qInfo() << QObject::tr("Wrote %1 DBs to %2").arg(coords.size()).arg(design_path);
+
+  if (parser.isSet(result_opt)) {
+    if (!writeResult(parser.value(result_opt), physlocs, p, gen))
+      return 1;
+    qInfo() << QObject::tr("Wrote result to %1").arg(parser.value(result_opt));
+  }
+
+  return 0;
+}